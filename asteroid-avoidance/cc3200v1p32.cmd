@@ -78,5 +78,9 @@ SECTIONS
     .bss    :   > SRAM_DATA
     .sysmem :   > SRAM_DATA
     .stack  :   > SRAM_DATA(HIGH)
+
+    /* Binary-log format strings (LOG_BINARY builds): kept in the .out for
+       tools/logdecode.py but never loaded; a string's offset is its ID */
+    .logstr :   load = 0x00000000, type = COPY, LOAD_START(log_str_start)
 }
 
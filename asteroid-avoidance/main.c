@@ -37,6 +37,32 @@
 
 // Custom includes
 #include "utils/network_utils.h"
+#include "utils/fixed_point.h"
+#include "utils/prng.h"
+#include "utils/ir_ring.h"
+#include "utils/ir_decoder.h"
+#include "utils/ir_keymap.h"
+#include "utils/work_queue.h"
+#include "utils/isr_profile.h"
+#include "utils/accel.h"
+#include "utils/tilt_filter.h"
+#include "utils/i2c_async.h"
+#include "utils/i2c_async_hw.h"
+#include "utils/uart_log.h"
+#include "utils/aws_shadow.h"
+#include "utils/mqtt_client.h"
+#include "utils/score_cache.h"
+#include "utils/dns_cache.h"
+#include "utils/tls_conn.h"
+
+// Game logging: DEBUG and below are compiled in. Per-frame TRACE output is
+// only cheap enough with binary logging.
+#ifdef LOG_BINARY
+#define LOG_MODULE_LEVEL LOG_LEVEL_TRACE
+#else
+#define LOG_MODULE_LEVEL LOG_LEVEL_DEBUG
+#endif
+#include "utils/log.h"
 
 // Timing interrupt
 #include "systick.h"
@@ -68,11 +94,25 @@
 #define SCORE_MILESTONE_BASE 100    // First milestone at 100 points
 #define MAX_ACTIVE_ASTEROIDS 5      // Maximum asteroids that can be active simultaneously
 
-// Asteroid speed definitions - 4 fixed speed tiers (all slower than before)
-#define ASTEROID_SPEED_SLOW     1   // 2 pixels per frame
-#define ASTEROID_SPEED_MEDIUM   2   // 3 pixels per frame
-#define ASTEROID_SPEED_FAST     3   // 4 pixels per frame
-#define ASTEROID_SPEED_FASTEST  4   // 5 pixels per frame
+// Asteroid speed curve (Q8.8 pixels per frame). Each spawn draws a speed from a
+// window that slides from [EASY_MIN, EASY_MAX] to [HARD_MIN, HARD_MAX] as the
+// score approaches DIFFICULTY_FULL_SCORE.
+#define ASTEROID_SPEED_EASY_MIN FIX_FROM_RATIO(1, 1)   // 1.0 px/frame
+#define ASTEROID_SPEED_EASY_MAX FIX_FROM_RATIO(5, 2)   // 2.5 px/frame
+#define ASTEROID_SPEED_HARD_MIN FIX_FROM_RATIO(2, 1)   // 2.0 px/frame
+#define ASTEROID_SPEED_HARD_MAX FIX_FROM_RATIO(4, 1)   // 4.0 px/frame
+#define DIFFICULTY_FULL_SCORE   2000                   // Score at which the curve tops out
+
+// Ship tilt response: filtered tilt in accel counts -> Q8.8 pixels per frame
+#define SHIP_MAX_SPEED          FIX_FROM_RATIO(2, 1)   // ±2 px/frame
+#define TILT_ALPHA              FIX_FROM_RATIO(1, 2)   // Filter position gain
+#define TILT_BETA               FIX_FROM_RATIO(1, 10)  // Filter rate gain
+#define TILT_DEADZONE           FIX_FROM_RATIO(3, 2)   // Counts treated as level
+#define TILT_FULL               INT_TO_FIX(18)         // Counts for full speed
+#define TILT_EXPO               FIX_FROM_RATIO(1, 2)   // 0 linear .. 1 cubic (fine control near level)
+#define TILT_MAX_ERRORS         5                      // Failed reads before the ship stops
+#define TILT_CALIB_SAMPLES      16
+#define MAX_FRAME_STEP          INT_TO_FIX(4)          // Cap dt after an unexpected overrun
 
 #define SPI_IF_BIT_RATE  20000000
 #define UART_BAUD_RATE   115200
@@ -82,16 +122,36 @@
 #define MAX_MSG_LEN      128
 
 #define SYSCLKFREQ       80000000ULL
-#define TICKS_TO_US(ticks) \
-    ((((ticks) / SYSCLKFREQ) * 1000000ULL) + \
-    ((((ticks) % SYSCLKFREQ) * 1000000ULL) / SYSCLKFREQ))
+// ticks * 1e6 / SYSCLKFREQ as one 32x32->64 multiply and shift. The multiplier
+// is rounded up so exact multiples of a microsecond don't round down.
+#define TICKS_TO_US_MULT ((((uint64_t)1000000ULL << 32) + SYSCLKFREQ - 1) / SYSCLKFREQ)
+#define TICKS_TO_US(ticks) ((uint32_t)(((uint64_t)(uint32_t)(ticks) * TICKS_TO_US_MULT) >> 32))
 #define US_TO_TICKS(us) ((SYSCLKFREQ / 1000000ULL) * (us))
+#define TICKS_PER_MS (SYSCLKFREQ / 1000ULL)
 #define SYSTICK_RELOAD_VAL 3200000UL
 
-#define SHORT_PULSE_MIN 400
-#define SHORT_PULSE_MAX 600
-#define LONG_PULSE_MIN  1500
-#define LONG_PULSE_MAX  1700
+#define IR_REMOTE_ADDRESS 0x20  // NEC address of the ATT-RC1534801 remote
+#define IR_NUM_BUTTONS    12
+#define IR_KEYMAP_FILE    "/usr/ir_keymap.bin"  // Learned remote codes
+#define HIGH_SCORE_FILE   "/usr/high_score.bin" // Best score and whether the shadow has it
+#define DNS_CACHE_FILE    "/usr/dns_cache.bin"  // AWS endpoint address from an earlier session
+#ifndef PLAYER_INITIALS
+#define PLAYER_INITIALS   "CC3"                 // This board's leaderboard name (A-Z, 0-9)
+#endif
+
+// IR receiver on PIN_62 (GT_CCP07): Timer A3, sub-timer B in edge-time capture.
+// The 8-bit prescaler extends the 16-bit counter to 24 bits (~210 ms at 80 MHz).
+#define IR_TIMER_BASE       TIMERA3_BASE
+#define IR_TIMER            TIMER_B
+#define IR_CAPTURE_MASK     0x00FFFFFFUL
+
+// Accelerometer INT1 (data ready) wired to PIN_08 (GPIO17)
+#define ACCEL_INT_GPIO_BASE GPIOA2_BASE
+#define ACCEL_INT_GPIO_PIN  0x02
+#define ACCEL_STALE_US      (4 * ACCEL_SAMPLE_PERIOD_US)  // No data-ready this long: poll instead
+#define ACCEL_STALE_FRAMES  ((ACCEL_STALE_US * TARGET_FPS + 999999) / 1000000)
+#define ACCEL_MAX_AGE_US    250000                        // Older samples don't steer the ship
+#define ACCEL_CALIB_DELAY   533333                        // ~20 ms of UtilsDelay between samples
 
 #define DATE            2    /* Current Date */
 #define MONTH           6     /* Month 1-12 */
@@ -103,13 +163,16 @@
 #define APPLICATION_NAME      "SSL"
 #define APPLICATION_VERSION   "SQ24"
 #define SERVER_NAME           "a1m8o1coxrb26a-ats.iot.us-east-2.amazonaws.com"
-#define GOOGLE_DST_PORT       8443
-#define POSTHEADER "POST /things/CC3200/shadow HTTP/1.1\r\n"
-#define HOSTHEADER "Host: a1m8o1coxrb26a-ats.iot.us-east-2.amazonaws.com\r\n"
-#define CHEADER "Connection: Keep-Alive\r\n"
-#define CTHEADER "Content-Type: application/json; charset=utf-8\r\n"
-#define CLHEADER1 "Content-Length: "
-#define CLHEADER2 "\r\n\r\n"
+#define GOOGLE_DST_PORT       AWS_SHADOW_PORT  // MQTT 8883, or 8443 with AWS_SHADOW_HTTP
+#define AWS_SHADOW_TIMEOUT_TICKS US_TO_TICKS(5000000)  // Give up on a shadow request after 5 s
+#define TLS_BACKOFF_MIN_TICKS    US_TO_TICKS(1000000)  // First reconnect delay, doubled per failure
+#define TLS_BACKOFF_MAX_TICKS    US_TO_TICKS(32000000) // (the 32-bit tick clock wraps after ~53 s)
+#define TLS_CONNECT_TIMEOUT_TICKS US_TO_TICKS(10000000)
+#define TLS_KEEPALIVE_TICKS      US_TO_TICKS(30000000) // Idle time before a keep-alive read
+#define SCORE_RETRY_MIN_TICKS    US_TO_TICKS(2000000)  // Repost an unconfirmed record after 2 s,
+#define SCORE_RETRY_MAX_TICKS    US_TO_TICKS(32000000) // doubling up to 32 s
+#define WLAN_REJOIN_TIMEOUT_MS   5000                  // Stored profile's IP address, else full setup
+#define DNS_CACHE_BOOTS          20                    // Boots reusing a resolved endpoint address
 
 #define FOREVER                 1
 #define FAILURE                 -1
@@ -118,20 +181,32 @@
 #define RET_IF_ERR(Func)          {int iRetVal = (Func); \
                                    if (SUCCESS != iRetVal) \
                                      return  iRetVal;}
-#define MAX_ASTEROID_SPEED 0.1 // Much slower asteroids (was 1)
+
+// Game seed: 0 derives a fresh seed from timing/sensor noise each game,
+// any other value replays the same asteroid sequence every game
+// (-DGAME_SEED=<seed> from the build)
+#ifndef GAME_SEED
+#define GAME_SEED 0
+#endif
 
 // Frame rate control
 #define TARGET_FPS 45                    // Target 60 FPS for smooth gameplay
 #define FRAME_DELAY_TICKS (SYSCLKFREQ / TARGET_FPS)  // Ticks per frame
+#define WORK_BUDGET_TICKS US_TO_TICKS(3000)          // Deferred work per main-loop pass
+#define ISR_BUDGET_US 50                             // Longest acceptable ISR run
+#define I2C_ASYNC_TIMEOUT_TICKS US_TO_TICKS(5000)    // Abort an I2C step stuck this long
+#define LOG_RUNTIME_LEVEL LOG_LEVEL_INFO             // Compiled-in levels printed at boot
 
 // ========================= TYPEDEFS =========================
 
 typedef struct {
-    int x, y;
-    int dx, dy;
+    fix8_t x, y;   // Q8.8 position
+    fix8_t dx, dy; // Q8.8 velocity, pixels per frame
+    int px, py;    // Integer position last drawn on screen
     int radius;
     int sides;
     int speed; // used for scoring
+    int slot;  // spawn slot owned by this asteroid (-1 if none)
 } Asteroid;
 
 typedef struct PinSetting {
@@ -143,7 +218,8 @@ typedef enum {
     GAME_STATE_START_SCREEN,
     GAME_STATE_PLAYING,
     GAME_STATE_GAME_OVER,
-    GAME_STATE_WAITING_RESTART
+    GAME_STATE_WAITING_RESTART,
+    GAME_STATE_LEADERBOARD
 } GameState;
 
 // ========================= GLOBAL VARIABLES =========================
@@ -151,7 +227,16 @@ typedef enum {
 Asteroid asteroids[MAX_ASTEROIDS];
 
 #define NUM_ASTEROID_SLOTS      MAX_ACTIVE_ASTEROIDS
-static int asteroid_slot_used[NUM_ASTEROID_SLOTS] = {0};
+#define SLOT_WORD_BITS          32
+#define NUM_SLOT_WORDS          ((NUM_ASTEROID_SLOTS + SLOT_WORD_BITS - 1) / SLOT_WORD_BITS)
+#define MAX_ASTEROID_SLOTS      (SLOT_WORD_BITS * SLOT_WORD_BITS) // Two-level bitmap capacity
+#if NUM_ASTEROID_SLOTS > MAX_ASTEROID_SLOTS
+#error "NUM_ASTEROID_SLOTS exceeds the slot allocator capacity"
+#endif
+// Bit b of asteroid_slot_free[w] is set while slot (w * 32 + b) is free,
+// bit w of asteroid_slot_summary is set while word w has any free slot
+static uint32_t asteroid_slot_free[NUM_SLOT_WORDS] = {0};
+static uint32_t asteroid_slot_summary = 0;
 static int asteroid_slot_x[NUM_ASTEROID_SLOTS] = {0};
 
 // OLED/SPI variables
@@ -166,12 +251,22 @@ int msgIndex = 0;
 // Game state variables
 int player_lives = 3;
 int player_score = 0;
-int ship_x = SCREEN_WIDTH / 2;
+int ship_x = SCREEN_WIDTH / 2;    // Integer render position, derived from ship_x_fx
 int ship_y = SCREEN_HEIGHT - 32;  // 32 pixels above bottom of screen
 int ship_size = 10;
-int x_speed = 0;
+fix8_t ship_x_fx = INT_TO_FIX(SCREEN_WIDTH / 2);
+fix8_t x_speed = 0;               // Q8.8 pixels per frame
 int y_speed = 0;
 
+// Per-game random stream (spawn slots, sizes, speeds)
+static Prng game_rng;
+static uint32_t game_seed = 0;
+static unsigned long games_played = 0;
+
+// Start of the last game frame. Reset after the blocking waits (round start,
+// collision) so the next frame doesn't count the wait as elapsed time.
+static uint32_t last_frame_time = 0;
+
 // Time-based scoring variables
 unsigned long game_start_time = 0;
 
@@ -185,12 +280,39 @@ volatile GameState current_game_state = GAME_STATE_START_SCREEN;
 
 // IR/Decoding/Systick/Interrupts variables
 volatile unsigned long IR_intcount;
-volatile unsigned char IR_intflag;
-volatile int edge = 1;
-volatile int bit_count = 0;
-volatile uint64_t decoded_sequence = 0;
-volatile uint64_t delta_ticks = 0;
-volatile uint64_t delta_us = 0;
+static IrEdgeRing ir_edges;                 // Filled by IRCaptureIntHandler, drained by processIREdges
+static IrDecoder ir_decoder;
+static IrKeyMap ir_keymap;                  // (protocol, address, command) -> button
+static int ir_learn_button = -1;            // Button being learned, -1 = not learning
+static uint32_t ir_last_edge_time = 0;      // Timestamp of the previous edge
+static uint32_t ir_overflows_seen = 0;
+// Capture ISR state: extends the 24-bit hardware capture to a 32-bit timestamp
+static uint32_t ir_capture_time = 0;
+static uint32_t ir_last_capture = 0;
+static volatile uint32_t ir_capture_wraps = 0;  // Counter periods since the last edge
+static uint32_t ir_capture_level = 1;           // Receiver output idles high
+static volatile uint32_t ir_capture_tick = 0;   // SysTick at the latest edge (idle timing)
+
+// Accelerometer data-ready tracking. The ISR counts pulses and timestamps the
+// latest; the main loop fetches only when the count moved.
+static volatile uint32_t accel_ready_count = 0;
+static volatile uint32_t accel_ready_time = 0;
+static uint32_t accel_fetched_count = 0;            // accel_ready_count when the last fetch started
+static uint32_t accel_quiet_frames = 0;             // Frames in a row with no data-ready pulse
+static uint32_t accel_fetch_time = 0;               // Data time of the fetch in flight
+static uint32_t accel_sample_time = 0;              // Data time of the sample in use
+static unsigned long accel_samples_coalesced = 0;   // Samples superseded before they were fetched
+uint32_t accel_sample_age_us = 0;                   // Age of the sample steering the ship
+static TiltFilter ship_tilt;                        // Accel X -> ship velocity
+
+// Bottom halves posted by ISRs, run by the main loop
+static WorkQueue deferred_work;
+static IsrProfile isr_prof_ir_capture;
+static IsrProfile isr_prof_multitap;
+static IsrProfile frame_prof;                       // Update + collide + render time per frame
+
+// Free-running SysTick time base (SysTick counts down and wraps every 40 ms)
+static volatile uint32_t g_ulSysTickWraps = 0;
 
 // Multi-tap messaging state
 volatile int curButton = -1;
@@ -213,6 +335,10 @@ const char* keyMap[12] = {
     "\b",      //  MUTE
     "\n",       // LAST
 };
+const char* ir_button_names[IR_NUM_BUTTONS] = {
+    "0", "1", "2 (ABC)", "3 (DEF)", "4 (GHI)", "5 (JKL)",
+    "6 (MNO)", "7 (PQRS)", "8 (TUV)", "9 (WXYZ)", "MUTE", "LAST"
+};
 
 // Timeout Interrupt
 static volatile unsigned long g_ulSysTickValue;
@@ -221,12 +347,15 @@ static volatile unsigned long g_ulRefBase;
 static volatile unsigned long g_ulRefTimerInts = 0;
 static volatile unsigned long g_ulIntClearVector;
 unsigned long g_ulTimerInts;
-static const PinSetting IR_SIGNAL = { .port = GPIOA0_BASE, .pin = 0x80};
 
-// AWS/IoT buffers
-char awsMessage[MAX_MSG_LEN];
-char DATA1[MAX_MSG_LEN];  // Buffer for the JSON string
+// AWS/IoT connection
 long lRetVal = -1;
+static int wlan_rejoined = 0;                       // Boot used the stored Wi-Fi profile
+
+// Boot milestones, ms since SysTick started (0: not reached yet)
+static uint32_t boot_wifi_ms = 0;
+static uint32_t boot_playable_ms = 0;
+static uint32_t boot_cloud_ms = 0;
 #if defined(ccs)
 extern void (* const g_pfnVectors[])(void);
 #endif
@@ -243,11 +372,16 @@ void uartInit();
 void spiInit();
 void adafruitInit();
 void i2cInit();
+void tiltInit();
 void systickInit();
 void interruptInit();
 void terminalInit();
 void awsInit();
 void varInit();
+void seedGameRng();
+void irMapInit();
+void scoreInit();
+void bootMilestonePoll();
 // --- Main Game Loop ---
 void startGame();
 void updateState();
@@ -256,40 +390,49 @@ void endGame();
 void renderAsteroids();
 void drawUI();
 void checkCollisions();
-void updatePositions();
-void showGameOverScreen(int score, int isHighScore);
+void updatePositions(fix8_t dt);
+void showGameOverScreen(int score, int isHighScore, int rank);
+void showLeaderboard();
 void printOLED(const char msg[], int x, int y, unsigned int color);
 void drawDividerLine();
 void MasterMain();
 void onButtonPress(int button);
-void matchSequence(uint32_t decodedSequence);
-static void GPIOA0IntHandler(void);
-int decodePulse(int timeElapsed);
+void onButtonRepeat(int button);
+void onIRFrame(const IrEvent *ir);
+void startIRLearning();
+void learnIRCode(uint32_t key);
+static void IRCaptureIntHandler(void);
+static void AccelDataReadyIntHandler(void);
 static void SysTickInit(void);
-static inline void SysTickReset(void);
+static void SysTickIntHandler(void);
+static uint32_t SysTickNow(void);
+static uint32_t SysTickUptimeMs(void);
+void processIREdges(void);
 void TimerBaseIntHandler(void);
+void showMultiTapChar(uint32_t c);
+void reportIsrProfiles();
 int DisplayBuffer(unsigned char *pucDataBuf, unsigned char ucLen);
 int ProcessReadRegCommand(char *pcInpString);
 int ParseNProcessCmd(char *pcCmdBuffer);
-void buildJson();
 static int set_time();
-void awsMsg();
-int getHighScoreFromAWS();
-static int http_get(int iTLSSockID);
-static int http_post(int);
+static uint32_t clockSeconds();
+void onHighScoreChanged(int high_score);
 static void BoardInit(void);
 void drawShip(int x, int y, int size, unsigned int color);
 void drawAsteroidPolygon(int cx, int cy, int radius, int sides, unsigned int color);
 void spawnAsteroid(Asteroid* t);
 void initAsteroids();
+void initAsteroidSlots();
+int getFreeAsteroidSlot();
+void setAsteroidSlotUsed(int slot, int used);
+void spawnAsteroidInSlot(Asteroid* t, int slot);
+void freeAsteroidSlotForAsteroid(Asteroid* t);
 void drawGameObjects(int ship_x, int ship_y, int ship_size, int prev_ship_x, int prev_ship_y);
 // --- Dynamic Asteroid Spawning System ---
 void checkScoreMilestones();
 int spawnNewAsteroidSafely();
 // --- Accelerometer Functions ---
 int readAccelAxis(char axis);
-int readAccelX();
-int readAccelY();
 void updateShipFromAccel();
 // --- Efficient Rendering ---
 void efficientRender(int prev_ship_x, int prev_ship_y);
@@ -300,35 +443,60 @@ void eraseAsteroid(int index);
 // --- Initialization ---
 void gameInit() {
     Report("=== INITIALIZING GAME SYSTEMS ===\r\n");
+    logSetLevel(LOG_RUNTIME_LEVEL);
     boardInit();
+    systickInit();      // First, so boot milestones count from here
     pinmuxInit();
     uartInit();
     spiInit();
     adafruitInit();
     i2cInit();
-    systickInit();
+    tiltInit();
     interruptInit();
     terminalInit();
     awsInit();
+    irMapInit();
+    scoreInit();
     varInit();
 }
 
 void boardInit() { BoardInit(); }
 void pinmuxInit() { PinMuxConfig(); }
-void uartInit() { InitTerm(); }
+void uartInit() { InitTerm(); uartLogInit(CONSOLE); }
 void spiInit() { MasterMain(); }
 void adafruitInit() { Adafruit_Init(); fillScreen(BLACK); }
 void systickInit() { SysTickInit(); }
-void terminalInit() { InitTerm(); ClearTerm(); }
+void terminalInit() { uartLogFlush(); InitTerm(); ClearTerm(); }
 void awsInit() {
+    const TlsConnConfig tls_cfg = {
+        TLS_BACKOFF_MIN_TICKS, TLS_BACKOFF_MAX_TICKS, TLS_CONNECT_TIMEOUT_TICKS, TLS_KEEPALIVE_TICKS
+    };
+
     Report("Initializing AWS IoT connection...\r\n");
     g_app_config.host = SERVER_NAME;
     g_app_config.port = GOOGLE_DST_PORT;
+    tlsConnInit(&tls_cfg, SysTickNow);
+    awsShadowInit(SERVER_NAME, SysTickNow, AWS_SHADOW_TIMEOUT_TICKS, onHighScoreChanged);
+
+    // Fast boot: rejoin the profile stored by the last full setup. The full
+    // sequence (default-state reset, scan, connect) runs only if that fails.
+    lRetVal = startFastConnect(WLAN_REJOIN_TIMEOUT_MS);
+    wlan_rejoined = lRetVal == 0;
+    if (!wlan_rejoined) {
+        Report("No fast connect (%d), full Wi-Fi setup\r\n", lRetVal);
+        lRetVal = connectToAccessPoint();
+        if (lRetVal < 0) {
+            Report("Failed to connect to access point: %d\r\n", lRetVal);
+            return;
+        }
+    }
+    boot_wifi_ms = SysTickUptimeMs();
+    Report("Boot: Wi-Fi up after %u ms (%s)\r\n", (unsigned int)boot_wifi_ms,
+           wlan_rejoined ? "stored profile" : "full setup");
 
-    lRetVal = connectToAccessPoint();
-    if (lRetVal < 0) {
-        Report("Failed to connect to access point: %d\r\n", lRetVal);
-        return;
+    // The first connect skips DNS while the address saved last time is fresh
+    if (dnsCacheInit(DNS_CACHE_FILE, SERVER_NAME, DNS_CACHE_BOOTS) < 0) {
+        Report("No cached address for %s\r\n", SERVER_NAME);
     }
 
     lRetVal = set_time();
@@ -337,28 +505,90 @@ void awsInit() {
         return;
     }
 
-    lRetVal = tls_connect();
-    if (lRetVal < 0) {
-        Report("Failed to establish TLS connection: %d\r\n", lRetVal);
-        return;
-    }
-
-    http_get(lRetVal); // get aws highscore
+    // The TLS connection is opened in the background by the first request;
+    // the start screen shows the high score when the response arrives
+    awsShadowRequestGet();
 }
 void varInit() {
     // Reset all game state variables at the start of each game
     player_lives = 3;
     player_score = 0;
     ship_x = SCREEN_WIDTH / 2;
+    ship_x_fx = INT_TO_FIX(ship_x);
     ship_y = SCREEN_HEIGHT - 32;  // 32 pixels above bottom of screen
     ship_size = 10;
     x_speed = 0;
     y_speed = 0;
 
+    seedGameRng();
     initAsteroids();
     Report("Game variables reset complete\r\n");
 }
 
+// Built-in ATT remote codes, plus any remote learned earlier (needs the
+// network processor started by awsInit for the file system)
+void irMapInit() {
+    static const unsigned char att_commands[IR_NUM_BUTTONS] = {
+        0x08, 0x88, 0x48, 0xC8, 0x28, 0xA8, 0x68, 0xE8, 0x18, 0x98, 0x50, 0x58
+    };
+    IrEvent code;
+    long ret;
+    int i;
+
+    irKeyMapClear(&ir_keymap);
+    code.protocol = IR_PROTO_NEC;
+    code.address = IR_REMOTE_ADDRESS;
+    for (i = 0; i < IR_NUM_BUTTONS; i++) {
+        code.command = att_commands[i];
+        irKeyMapPut(&ir_keymap, irEventKey(&code), i, 0);
+    }
+
+    ret = irKeyMapLoad(&ir_keymap, IR_KEYMAP_FILE);
+    if (ret < 0) {
+        Report("No learned IR remote loaded (%d)\r\n", (int)ret);
+    } else {
+        Report("IR key map: %d codes\r\n", ir_keymap.count);
+    }
+}
+
+// High score saved by earlier sessions, so the start screen doesn't wait for
+// the shadow (file system needs the network processor started by awsInit)
+void scoreInit() {
+    long ret = scoreCacheInit(HIGH_SCORE_FILE, SysTickNow, SCORE_RETRY_MIN_TICKS, SCORE_RETRY_MAX_TICKS);
+    if (ret < 0) {
+        Report("No saved high score (%d)\r\n", (int)ret);
+    }
+}
+
+// Cloud ready: the shadow session is up and the boot-time read answered
+void bootMilestonePoll() {
+    if (boot_cloud_ms == 0 && awsShadowOnline() && awsShadowIdle()) {
+        boot_cloud_ms = SysTickUptimeMs();
+        Report("Boot: cloud ready after %u ms\r\n", (unsigned int)boot_cloud_ms);
+    }
+}
+
+// Seed the per-game generator. The seed is logged so any game can be replayed
+// by building with GAME_SEED set to it.
+void seedGameRng() {
+#if GAME_SEED
+    game_seed = GAME_SEED;
+#else
+    game_seed = prngMix(game_seed, SysTickNow());
+    // The polled read can't share the bus with a queued async transfer; the
+    // tick count alone still varies between games
+    if (i2cAsyncIdle()) {
+        AccelSample sample = {0, 0};
+        accelRead(&sample);
+        game_seed = prngMix(game_seed, (uint32_t)(uint8_t)sample.x << 8 | (uint8_t)sample.y);
+    }
+    game_seed = prngMix(game_seed, games_played);
+#endif
+    games_played++;
+    prngSeed(&game_rng, game_seed);
+    Report("Game seed: 0x%08X\r\n", (unsigned int)game_seed);
+}
+
 // ========================= MAIN =========================
 // Main entry point for Asteroid Avoidance survival game
 int main() {
@@ -367,48 +597,25 @@ int main() {
 
     // Display initial start screen
     startGame();
-
-    int bit_value = 0;
-    unsigned long last_frame_time = 0;  // Track last frame time for FPS control
+    boot_playable_ms = SysTickUptimeMs();
+    Report("Boot: playable after %u ms\r\n", (unsigned int)boot_playable_ms);
 
     while (1) {
         // Process IR input first (highest priority)
-        if (IR_intflag) {
-            IR_intflag = 0;
-            if (delta_ticks > 0) {
-                delta_us = TICKS_TO_US(delta_ticks);
-                bit_value = decodePulse(delta_us);
-                if (bit_value == 1 || bit_value == 0) {
-                    bit_count++;
-                    decoded_sequence = (decoded_sequence << 1) | bit_value;
-                    if (bit_count == 32) {
-                        Report("Received: 0x%08X\r\n", (unsigned int)decoded_sequence);
-                        matchSequence((uint32_t)decoded_sequence);
-                        decoded_sequence = 0;
-                        bit_count = 0;
-                    }
-                } else {
-                    // Invalid pulse, reset sequence
-                    if (bit_count > 0) {
-                        Report("Received: Invalid Signal\r\n");
-                    }
-                    decoded_sequence = 0;
-                    bit_count = 0;
-                }
-            }
-        }
+        processIREdges();
+
+        // OLED/UART work deferred by interrupt handlers
+        workQueueRun(&deferred_work, SysTickNow, WORK_BUDGET_TICKS);
+        i2cAsyncPoll();
+        awsShadowPoll();
+        scoreCachePoll();
+        bootMilestonePoll();
 
         // Frame rate limited game updates when playing
         if (current_game_state == GAME_STATE_PLAYING) {
-            unsigned long current_time = SysTickValueGet();
-            unsigned long elapsed_ticks;
-
-            // Calculate elapsed time since last frame (handle wraparound)
-            if (current_time <= last_frame_time) {
-                elapsed_ticks = last_frame_time - current_time;
-            } else {
-                elapsed_ticks = (SYSTICK_RELOAD_VAL - current_time) + last_frame_time;
-            }
+            uint32_t current_time = SysTickNow();
+            // Unsigned difference handles wraparound of the 32-bit time base
+            uint32_t elapsed_ticks = current_time - last_frame_time;
 
             // Only update if enough time has passed for target FPS
             if (elapsed_ticks >= FRAME_DELAY_TICKS) {
@@ -418,14 +625,18 @@ int main() {
                 prev_ship_x = ship_x;
                 prev_ship_y = ship_y;
 
-                updatePositions();
+                // Advance by the real elapsed time in frames (Q8.8) so motion
+                // speed doesn't depend on how late this frame started
+                fix8_t dt = FIX_DIV(elapsed_ticks, FRAME_DELAY_TICKS);
+                if (dt > MAX_FRAME_STEP) dt = MAX_FRAME_STEP;
+                // Before the update: a collision stall moves it on again
+                last_frame_time = current_time;
+                updatePositions(dt);
                 checkCollisions();
 
                 // Efficient rendering with position tracking
                 efficientRender(prev_ship_x, prev_ship_y);
-
-                // Update frame timing
-                last_frame_time = current_time;
+                ISR_PROFILE_RECORD(frame_prof, SysTickNow() - current_time);
 
                 // If player_lives == 0, transition to game over
                 if (player_lives == 0) {
@@ -456,16 +667,28 @@ void BoardInit(void)
 
 // ========================= GAME LOOP SECTION =========================
 
+// High score line of the start screen
+static void drawStartHighScore(int high_score) {
+    char highScoreText[32];
+    sprintf(highScoreText, "High Score: %d", high_score);
+    fillRect(0, 128/2, SCREEN_WIDTH, 8, BLACK);
+    printOLED(highScoreText, (128 - strlen(highScoreText) * 6) / 2, 128/2, GREEN);
+}
+
 void startGame() {
     fillScreen(BLACK);
 
-    // Get current high score from AWS for display
-    int awsHighScore = getHighScoreFromAWS();
-    char highScoreText[32];
-    sprintf(highScoreText, "High Score: %d", awsHighScore);    printOLED("ASTEROID AVOIDANCE", (128 - strlen("ASTEROID AVOIDANCE") * 6) / 2, 128/2 - 24, GREEN);
-    printOLED(highScoreText, (128 - strlen(highScoreText) * 6) / 2, 128/2, GREEN);
+    // Show the high score from the flash cache now; onHighScoreChanged
+    // redraws the line if the shadow has a better one. Over MQTT changes are
+    // pushed, over HTTP a read refreshes it in the background.
+#ifdef AWS_SHADOW_HTTP
+    awsShadowRequestGet();
+#endif
+    printOLED("ASTEROID AVOIDANCE", (128 - strlen("ASTEROID AVOIDANCE") * 6) / 2, 128/2 - 24, GREEN);
+    drawStartHighScore(scoreCacheBest());
     printOLED("Press MUTE to start", (128 - strlen("Press MUTE to start") * 6) / 2, 128/2 + 24, WHITE);
     printOLED("Tilt left/right to move", (128 - strlen("Tilt left/right to move") * 6) / 2, 128/2 + 36, WHITE);
+    printOLED("LAST: leaderboard", (128 - strlen("LAST: leaderboard") * 6) / 2, 128/2 + 48, WHITE);
 
     Report("=== [STARTING GAME] ===\r\n");
 }
@@ -477,6 +700,7 @@ void updateState() {
     drawUI();
     MAP_UtilsDelay(16000000); // 3s delay
     renderAsteroids();
+    last_frame_time = SysTickNow();
 
     int prev_ship_x = ship_x;
     int prev_ship_y = ship_y;
@@ -488,7 +712,7 @@ void updateState() {
         prev_ship_x = ship_x;
         prev_ship_y = ship_y;
 
-        updatePositions();
+        updatePositions(FIX_ONE);
         checkCollisions();
 
         // Efficient rendering with position tracking
@@ -507,26 +731,37 @@ void updateState() {
 void endGame() {
     Report("Game ended. Player score: %d\r\n", player_score);
 
-    // Get current high score from AWS
-    int awsHighScore = getHighScoreFromAWS();
+    // Compare against the cached high score (flash, kept up to date from
+    // the shadow) so the game-over screen doesn't wait on the network
+    int highScore = scoreCacheBest();
     int isHighScore = 0;
+    LeaderboardEntry entry;
+    int rank;
 
-    // Only post to AWS if the current score is higher than the AWS high score
-    if (player_score > awsHighScore) {
+    if (scoreCacheRecord(player_score)) {
         isHighScore = 1;
-        Report("New high score achieved: %d (previous AWS high score: %d)\r\n", player_score, awsHighScore);
+        Report("New high score achieved: %d (previous high score: %d)\r\n", player_score, highScore);
 
-        // POST new high score to AWS (key: "highscore:")
-        snprintf(MessageTx, sizeof(MessageTx), "%d", player_score);
-        buildJson();
-        awsMsg();
-        Report("High score posted to AWS\r\n");
+        // Saved to flash and queued now, so it goes out with the leaderboard
+        // entry below as one versioned update; the main loop reposts it
+        // until the shadow holds it, across resets too
+        Report("High score saved, queued for AWS\r\n");
     } else {
         isHighScore = 0;
-        Report("Final score: %d (Current AWS high score: %d) - No new high score\r\n", player_score, awsHighScore);
+        Report("Final score: %d (Current high score: %d) - No new high score\r\n", player_score, highScore);
     }
 
-    showGameOverScreen(player_score, isHighScore);
+    // Ranked against the cached table; goes out with the next shadow update
+    strcpy(entry.initials, PLAYER_INITIALS);
+    entry.score = (uint32_t)player_score;
+    entry.time = clockSeconds();
+    rank = player_score > 0 ? awsShadowSubmit(&entry) : -1;
+    if (rank >= 0) {
+        Report("Leaderboard: %s %d is #%d\r\n", entry.initials, player_score, rank + 1);
+    }
+
+    showGameOverScreen(player_score, isHighScore, rank);
+    reportIsrProfiles();
 
     // Set state to waiting for restart - IR loop will handle button press
     current_game_state = GAME_STATE_WAITING_RESTART;
@@ -537,63 +772,91 @@ void endGame() {
 void initAsteroidSlots() {
     int i;
     int slot_width = SCREEN_WIDTH / NUM_ASTEROID_SLOTS;
+    for (i = 0; i < NUM_SLOT_WORDS; i++) {
+        asteroid_slot_free[i] = 0;
+    }
+    asteroid_slot_summary = 0;
     for (i = 0; i < NUM_ASTEROID_SLOTS; i++) {
-        asteroid_slot_used[i] = 0;
         asteroid_slot_x[i] = (slot_width / 2) + i * slot_width;
+        setAsteroidSlotUsed(i, 0);
     }
 }
 
+// Count trailing zeros of a non-zero word (de Bruijn lookup, no loops)
+static int slotCtz(uint32_t v) {
+    static const unsigned char debruijn_index[32] = {
+        0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+        31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+    };
+    return debruijn_index[((v & (0u - v)) * 0x077CB531u) >> 27];
+}
+
+// Pick a set bit of a non-zero mask: rotate by a random amount, then take the
+// lowest set bit so spawns don't always favor the leftmost free slot
+static int slotPickBit(uint32_t mask) {
+    int r = prngNext(&game_rng) >> 27; // Top 5 bits: 0..31
+    uint32_t rotated = r ? ((mask >> r) | (mask << (SLOT_WORD_BITS - r))) : mask;
+    return (slotCtz(rotated) + r) & (SLOT_WORD_BITS - 1);
+}
+
 int getFreeAsteroidSlot() {
-    // Collect all free slots
-    int free_slots[NUM_ASTEROID_SLOTS];
-    int count = 0;
-    int i;
-    for (i = 0; i < NUM_ASTEROID_SLOTS; i++) {
-        if (!asteroid_slot_used[i]) {
-            free_slots[count++] = i;
+    if (asteroid_slot_summary == 0) return -1;
+    int word = slotPickBit(asteroid_slot_summary);
+    int bit = slotPickBit(asteroid_slot_free[word]);
+    return word * SLOT_WORD_BITS + bit;
+}
+
+void setAsteroidSlotUsed(int slot, int used) {
+    if (slot < 0 || slot >= NUM_ASTEROID_SLOTS) return;
+    int word = slot / SLOT_WORD_BITS;
+    uint32_t bit = 1u << (slot % SLOT_WORD_BITS);
+    if (used) {
+        asteroid_slot_free[word] &= ~bit;
+        if (asteroid_slot_free[word] == 0) {
+            asteroid_slot_summary &= ~(1u << word);
         }
+    } else {
+        asteroid_slot_free[word] |= bit;
+        asteroid_slot_summary |= 1u << word;
     }
-    if (count == 0) return -1;
-    // Shuffle free_slots array to randomize order
-    for (i = count - 1; i > 0; i--) {
-        int j = rand() % (i + 1);
-        int temp = free_slots[i];
-        free_slots[i] = free_slots[j];
-        free_slots[j] = temp;
-    }
-    // Return the first slot in the shuffled array
-    return free_slots[0];
 }
 
-void setAsteroidSlotUsed(int slot, int used) {
-    if (slot >= 0 && slot < NUM_ASTEROID_SLOTS) asteroid_slot_used[slot] = used;
+// Difficulty in Q8.8, ramping linearly from 0 to 1.0 over DIFFICULTY_FULL_SCORE points
+static fix8_t currentDifficulty() {
+    if (player_score >= DIFFICULTY_FULL_SCORE) return FIX_ONE;
+    return FIX_DIV(player_score, DIFFICULTY_FULL_SCORE);
 }
 
 void spawnAsteroidInSlot(Asteroid* t, int slot) {
-    // Use arrays instead of switch statements for size and speed
     static const int radius_options[] = {6, 8, 10, 12};
-    static const int speed_options[] = {ASTEROID_SPEED_SLOW, ASTEROID_SPEED_MEDIUM, ASTEROID_SPEED_FAST, ASTEROID_SPEED_FASTEST};
 
-    int r = radius_options[rand() % 4];
-    int dy = speed_options[rand() % 4];
+    // Speed window slides with difficulty; pick uniformly inside it
+    fix8_t difficulty = currentDifficulty();
+    fix8_t speed_min = FIX_LERP(ASTEROID_SPEED_EASY_MIN, ASTEROID_SPEED_HARD_MIN, difficulty);
+    fix8_t speed_max = FIX_LERP(ASTEROID_SPEED_EASY_MAX, ASTEROID_SPEED_HARD_MAX, difficulty);
+
+    int r = radius_options[prngRange(&game_rng, 4)];
+    fix8_t dy = speed_min + (fix8_t)prngRange(&game_rng, speed_max - speed_min + 1);
     int y = -r - 10;
     int x = asteroid_slot_x[slot];
-    int dx = 0;
-    t->x = x;
-    t->y = y;
-    t->dx = dx;
+    t->x = INT_TO_FIX(x);
+    t->y = INT_TO_FIX(y);
+    t->dx = 0;
     t->dy = dy;
+    t->px = x;
+    t->py = y;
     t->radius = r;
     t->sides = 4;
-    t->speed = dy;
+    t->speed = FIX_ROUND(dy) > 0 ? FIX_ROUND(dy) : 1; // Whole px/frame, used for scoring
+    t->slot = slot;
     setAsteroidSlotUsed(slot, 1);
-    Report("Spawned asteroid in slot %d at x=%d\n", slot, x);
+    LOG_DEBUG("Spawned asteroid in slot %d at x=%d (speed %d/256 px/frame)\n", slot, x, dy);
 }
 
 int spawnNewAsteroidSafely() {
     int slot = getFreeAsteroidSlot();
     if (slot == -1) {
-        Report("No available asteroid slots for spawning\n");
+        LOG_DEBUG("No available asteroid slots for spawning\n");
         return 0;
     }
     int i;
@@ -610,12 +873,9 @@ int spawnNewAsteroidSafely() {
 }
 
 void freeAsteroidSlotForAsteroid(Asteroid* t) {
-    int i;
-    for (i = 0; i < NUM_ASTEROID_SLOTS; i++) {
-        if (asteroid_slot_x[i] == t->x) {
-            setAsteroidSlotUsed(i, 0);
-            break;
-        }
+    if (t->slot >= 0) {
+        setAsteroidSlotUsed(t->slot, 0);
+        t->slot = -1;
     }
 }
 
@@ -626,7 +886,9 @@ void renderAsteroids() {
     int i;
     for (i = 0; i < current_num_asteroids; i++) {
         if (asteroids[i].radius == 0) continue; // Skip uninitialized
-        drawAsteroidPolygon(asteroids[i].x, asteroids[i].y, asteroids[i].radius, asteroids[i].sides, PASTEL_RED);
+        asteroids[i].px = FIX_TO_INT(asteroids[i].x);
+        asteroids[i].py = FIX_TO_INT(asteroids[i].y);
+        drawAsteroidPolygon(asteroids[i].px, asteroids[i].py, asteroids[i].radius, asteroids[i].sides, PASTEL_RED);
     }
 }
 
@@ -670,8 +932,8 @@ void checkCollisions() {
         if (asteroids[i].radius == 0) continue;
 
         // Ship vs asteroid collision - using overlapping area detection
-        int dx = ship_x - asteroids[i].x;
-        int dy = ship_y - asteroids[i].y;
+        int dx = ship_x - FIX_TO_INT(asteroids[i].x);
+        int dy = ship_y - FIX_TO_INT(asteroids[i].y);
         int dist2 = dx*dx + dy*dy;
 
         // Calculate collision boundaries - ship radius + asteroid radius
@@ -681,7 +943,7 @@ void checkCollisions() {
 
         // Check if objects are overlapping (collision detected)
         if (dist2 < min_dist*min_dist) {
-            player_lives--;            Report("COLLISION! Ship (radius %d) overlapped with asteroid %d (radius %d). Lives remaining: %d\r\n",
+            player_lives--;            LOG_INFO("COLLISION! Ship (radius %d) overlapped with asteroid %d (radius %d). Lives remaining: %d\r\n",
                    ship_radius, i, asteroid_radius, player_lives);
 
             // Visual feedback for collision
@@ -691,6 +953,7 @@ void checkCollisions() {
                 Report("Respawning ship and resetting round...\r\n");
                 // Reset ship position to 32 pixels above bottom
                 ship_x = SCREEN_WIDTH / 2;
+                ship_x_fx = INT_TO_FIX(ship_x);
                 ship_y = SCREEN_HEIGHT - 32;  // 32 pixels above bottom of screen
 
                 x_speed = 0;
@@ -700,6 +963,7 @@ void checkCollisions() {
                 drawUI();
                 MAP_UtilsDelay(10000000); // 0.75s delay for recovery
                 renderAsteroids();
+                last_frame_time = SysTickNow();
             } else {
                 Report("GAME OVER - No lives remaining!\r\n");
             }
@@ -708,32 +972,35 @@ void checkCollisions() {
     }
 }
 
-// Update positions of ship and asteroids with horizontal-only movement
-void updatePositions() {
-    extern int ship_x, ship_y, ship_size, x_speed, y_speed;
+// Update positions of ship and asteroids with horizontal-only movement.
+// dt is the elapsed time in frames (Q8.8); velocities are Q8.8 pixels per frame.
+void updatePositions(fix8_t dt) {
     updateShipFromAccel();
-    ship_x += x_speed;
+    ship_x_fx += FIX_MUL(x_speed, dt);
     // ship_y += y_speed / 1.25; // Removed - ship no longer moves vertically
-    if (ship_x < 0) {
-        ship_x = SCREEN_WIDTH - 1;
-        Report("Ship wrapped from left to right side (x=%d)\r\n", ship_x);
+    if (ship_x_fx < 0) {
+        ship_x_fx += INT_TO_FIX(SCREEN_WIDTH);
+        LOG_TRACE("Ship wrapped from left to right side (x=%d)\r\n", FIX_TO_INT(ship_x_fx));
     }
-    if (ship_x >= SCREEN_WIDTH) {
-        ship_x = 0;
-        Report("Ship wrapped from right to left side (x=%d)\r\n", ship_x);
+    if (ship_x_fx >= INT_TO_FIX(SCREEN_WIDTH)) {
+        ship_x_fx -= INT_TO_FIX(SCREEN_WIDTH);
+        LOG_TRACE("Ship wrapped from right to left side (x=%d)\r\n", FIX_TO_INT(ship_x_fx));
     }
+    ship_x = FIX_TO_INT(ship_x_fx);
     // Y boundary checks removed - ship stays at fixed Y position
     int i;
     for (i = 0; i < current_num_asteroids; i++) {
         if (asteroids[i].radius == 0) continue;
-        asteroids[i].y += asteroids[i].dy;
-        if (asteroids[i].y - asteroids[i].radius > SCREEN_HEIGHT + 32) {
+        asteroids[i].x += FIX_MUL(asteroids[i].dx, dt);
+        asteroids[i].y += FIX_MUL(asteroids[i].dy, dt);
+        int top_edge = FIX_TO_INT(asteroids[i].y) - asteroids[i].radius;
+        if (top_edge > SCREEN_HEIGHT + 32) {
             freeAsteroidSlotForAsteroid(&asteroids[i]);
-            drawAsteroidPolygon(asteroids[i].x, asteroids[i].y, asteroids[i].radius, asteroids[i].sides, BLACK);
+            drawAsteroidPolygon(asteroids[i].px, asteroids[i].py, asteroids[i].radius, asteroids[i].sides, BLACK);
             int asteroid_points = asteroids[i].radius * asteroids[i].speed;
             player_score += asteroid_points;
-            Report("Asteroid %d completely off bottom (top edge at y=%d), awarding %d points (radius %d * speed %d). Total score: %d\r\n",
-                   i, asteroids[i].y - asteroids[i].radius, asteroid_points, asteroids[i].radius, asteroids[i].speed, player_score);
+            LOG_DEBUG("Asteroid %d completely off bottom (top edge at y=%d), awarding %d points (radius %d * speed %d). Total score: %d\r\n",
+                   i, top_edge, asteroid_points, asteroids[i].radius, asteroids[i].speed, player_score);
             int slot = getFreeAsteroidSlot();
             if (slot != -1) {
                 spawnAsteroidInSlot(&asteroids[i], slot);
@@ -764,7 +1031,7 @@ void efficientRender(int prev_ship_x, int prev_ship_y) {    // Only redraw ship
     // Check if any asteroid is in the top portion of screen where UI is displayed
     for (i = 0; i < current_num_asteroids; i++) {
         if (asteroids[i].radius == 0) continue; // Skip uninitialized
-        if (asteroids[i].y - asteroids[i].radius <= 20) { // Top 20 pixels contain UI
+        if (FIX_TO_INT(asteroids[i].y) - asteroids[i].radius <= 20) { // Top 20 pixels contain UI
             ui_area_threatened = 1;
             break;
         }
@@ -788,16 +1055,32 @@ void eraseShip(int x, int y, int size) {
     drawShip(x, y, size, BLACK);
 }
 
-// Erase asteroid at previous position
+// Erase asteroid at the integer position it was last drawn at
 void eraseAsteroid(int index) {
-    // Calculate previous position based on velocity
-    int prev_x = asteroids[index].x - asteroids[index].dx;
-    int prev_y = asteroids[index].y - asteroids[index].dy;
-    drawAsteroidPolygon(prev_x, prev_y, asteroids[index].radius, asteroids[index].sides, BLACK);
+    drawAsteroidPolygon(asteroids[index].px, asteroids[index].py, asteroids[index].radius, asteroids[index].sides, BLACK);
 }
 
 // Show GAME OVER screen and high score info
-void showGameOverScreen(int score, int isHighScore) {
+// Top scores from the table cached by aws_shadow; nothing is fetched
+void showLeaderboard() {
+    Leaderboard board;
+    char line[24];
+    int i;
+
+    awsShadowLeaderboard(&board);
+    fillScreen(BLACK);
+    printOLED("LEADERBOARD", (SCREEN_WIDTH - strlen("LEADERBOARD") * 6) / 2, 4, GREEN);
+    if (board.count == 0) {
+        printOLED("No scores yet", (SCREEN_WIDTH - strlen("No scores yet") * 6) / 2, SCREEN_HEIGHT / 2, WHITE);
+    }
+    for (i = 0; i < board.count; i++) {
+        sprintf(line, "%d. %-3s %10lu", i + 1, board.entries[i].initials, (unsigned long)board.entries[i].score);
+        printOLED(line, 6, 20 + i * 12, strcmp(board.entries[i].initials, PLAYER_INITIALS) ? WHITE : GREEN);
+    }
+    printOLED("Any button: back", (SCREEN_WIDTH - strlen("Any button: back") * 6) / 2, SCREEN_HEIGHT - 10, WHITE);
+}
+
+void showGameOverScreen(int score, int isHighScore, int rank) {
     fillScreen(BLACK);
 
     printOLED("GAME OVER", (SCREEN_WIDTH - strlen("GAME OVER") * 6) / 2, SCREEN_HEIGHT / 2 - 36, RED);
@@ -812,6 +1095,10 @@ void showGameOverScreen(int score, int isHighScore) {
     } else {
         printOLED("Try again!", (SCREEN_WIDTH - strlen("Try again!") * 6) / 2, SCREEN_HEIGHT / 2, WHITE);
     }
+    if (rank >= 0) {
+        sprintf(score_text, "Leaderboard #%d", rank + 1);
+        printOLED(score_text, (SCREEN_WIDTH - strlen(score_text) * 6) / 2, SCREEN_HEIGHT / 2 + 12, GREEN);
+    }
 
     printOLED("Press any button", (SCREEN_WIDTH - strlen("Press any button") * 6) / 2, SCREEN_HEIGHT / 2 + 24, WHITE);
     printOLED("to play again", (SCREEN_WIDTH - strlen("to play again") * 6) / 2, SCREEN_HEIGHT / 2 + 36, WHITE);
@@ -820,19 +1107,13 @@ void showGameOverScreen(int score, int isHighScore) {
 // ========================= IR/DECODING/SYSTICK/INTERRUPTS SECTION =========================
 // Handle button press event (game input/shooting) with continuous IR monitoring
 void onButtonPress(int button) {
-    // Define descriptive button names
-    const char* buttonNames[12] = {
-        "0", "1", "2 (ABC)", "3 (DEF)", "4 (GHI)", "5 (JKL)",
-        "6 (MNO)", "7 (PQRS)", "8 (TUV)", "9 (WXYZ)", "MUTE", "LAST"
-    };
-
-    if (button < 0 || button >= 12) {
-        Report("Invalid button press detected: %d\r\n", button);
+    if (button < 0 || button >= IR_NUM_BUTTONS) {
+        LOG_WARN("Invalid button press detected: %d\r\n", button);
         return;
     }
 
-    Report("IR Button pressed: %s (Button %d) - Game State: %d\r\n",
-           buttonNames[button], button, current_game_state);
+    LOG_INFO("IR Button pressed: %s (Button %d) - Game State: %d\r\n",
+           ir_button_names[button], button, current_game_state);
 
     switch (current_game_state) {
 
@@ -845,22 +1126,31 @@ void onButtonPress(int button) {
                 drawUI();
                 MAP_UtilsDelay(16000000); // ~3s delay for ship display
                 renderAsteroids();
+                last_frame_time = SysTickNow();
 
                 Report("Game started - entering gameplay state\r\n");
+            } else if (button == 11) { // LAST: leaderboard
+                current_game_state = GAME_STATE_LEADERBOARD;
+                showLeaderboard();
             }
             break;        case GAME_STATE_PLAYING:
             if (button >= 1 && button <= 9) {
-                Report("Number button pressed during gameplay (no action in survival mode)\r\n");
+                LOG_DEBUG("Number button pressed during gameplay (no action in survival mode)\r\n");
             } else if (button == 10) { // MUTE
-                Report("MUTE button during gameplay - could implement pause\r\n");
+                LOG_DEBUG("MUTE button during gameplay - could implement pause\r\n");
             } else if (button == 11) { // LAST - Emergency stop
                 x_speed = y_speed = 0;
-                Report("Emergency stop - All ship movement stopped during gameplay\r\n");
+                LOG_INFO("Emergency stop - All ship movement stopped during gameplay\r\n");
             } else if (button != 0) {
-                Report("Unhandled button during gameplay: %d\r\n", button);
+                LOG_DEBUG("Unhandled button during gameplay: %d\r\n", button);
             }
             break;
 
+        case GAME_STATE_LEADERBOARD:
+            current_game_state = GAME_STATE_START_SCREEN;
+            startGame();
+            break;
+
         case GAME_STATE_GAME_OVER:
         case GAME_STATE_WAITING_RESTART:
             // Any button restarts the game
@@ -876,81 +1166,242 @@ void onButtonPress(int button) {
 }
 
 
-// Match decoded IR sequence to button value
-void matchSequence(uint32_t decodedSequence) {
-    Report("IR sequence decoded: 0x%08X\r\n", (unsigned int)decodedSequence);
+// Handle auto-repeat while a button is held. Only gameplay acts on repeats;
+// menus ignore them so holding a button doesn't restart twice.
+void onButtonRepeat(int button) {
+    if (button >= 0 && current_game_state == GAME_STATE_PLAYING) {
+        onButtonPress(button);
+    }
+}
 
-    // Lookup table for IR sequences - more compact than switch
-    static const struct { uint32_t sequence; int button; } ir_map[] = {
-        {0xDF20F708, 0}, {0xDF207788, 1}, {0xDF20B748, 2}, {0xDF2037C8, 3},
-        {0xDF20D728, 4}, {0xDF2057A8, 5}, {0xDF209768, 6}, {0xDF2017E8, 7},
-        {0xDF20E718, 8}, {0xDF206798, 9}, {0xDF20AF50, 10}, {0xDF20A758, 11}    };
+// Route a decoded frame: learning mode takes every code, otherwise look the
+// code up and hand its button to the game. An unknown remote on the start
+// screen starts learning.
+void onIRFrame(const IrEvent *ir) {
+    uint32_t key = irEventKey(ir);
+    int button;
 
-    curButton = -1; // Default to invalid
-    int i;
-    for (i = 0; i < sizeof(ir_map)/sizeof(ir_map[0]); i++) {
-        if (ir_map[i].sequence == decodedSequence) {
-            curButton = ir_map[i].button;
-            break;
-        }
+    if (ir_learn_button >= 0) {
+        learnIRCode(key);
+        return;
     }
+    button = irKeyMapGet(&ir_keymap, key);
+    if (button < 0 && current_game_state == GAME_STATE_START_SCREEN) {
+        startIRLearning();
+        return;
+    }
+    curButton = button;
+    onButtonPress(button);
+}
 
-    onButtonPress(curButton);
+static void showIRLearnPrompt() {
+    fillScreen(BLACK);
+    printOLED("LEARN REMOTE", (SCREEN_WIDTH - strlen("LEARN REMOTE") * 6) / 2, SCREEN_HEIGHT / 2 - 24, GREEN);
+    printOLED("Press button:", (SCREEN_WIDTH - strlen("Press button:") * 6) / 2, SCREEN_HEIGHT / 2, WHITE);
+    printOLED(ir_button_names[ir_learn_button],
+              (SCREEN_WIDTH - strlen(ir_button_names[ir_learn_button]) * 6) / 2, SCREEN_HEIGHT / 2 + 12, GREEN);
+    printOLED("Known MUTE cancels", (SCREEN_WIDTH - strlen("Known MUTE cancels") * 6) / 2, SCREEN_HEIGHT / 2 + 36, WHITE);
+}
+
+// Walk the user through buttons 0..11 on the new remote
+void startIRLearning() {
+    Report("Unknown IR code on start screen - learning new remote\r\n");
+    ir_learn_button = 0;
+    showIRLearnPrompt();
+}
+
+// Assign a captured code to the button being learned. Codes that are already
+// mapped are refused (a double press would otherwise steal a button), except
+// MUTE, which cancels.
+void learnIRCode(uint32_t key) {
+    int mapped = irKeyMapGet(&ir_keymap, key);
+
+    if (mapped == 10) {
+        Report("IR learning cancelled\r\n");
+        ir_learn_button = -1;
+        irMapInit();    // Drop the codes learned so far
+        startGame();
+        return;
+    }
+    if (mapped >= 0) {
+        Report("IR code 0x%08X already mapped to %s\r\n", (unsigned int)key, ir_button_names[mapped]);
+        return;
+    }
+    if (irKeyMapPut(&ir_keymap, key, ir_learn_button, 1) < 0) {
+        Report("IR key map full - learning stopped\r\n");
+        ir_learn_button = -1;
+        irMapInit();
+        startGame();
+        return;
+    }
+    Report("Learned 0x%08X as %s\r\n", (unsigned int)key, ir_button_names[ir_learn_button]);
+
+    if (++ir_learn_button < IR_NUM_BUTTONS) {
+        showIRLearnPrompt();
+        return;
+    }
+    ir_learn_button = -1;
+    lRetVal = irKeyMapSave(&ir_keymap, IR_KEYMAP_FILE);
+    if (lRetVal < 0) {
+        Report("Failed to save IR key map: %d\r\n", lRetVal);
+    } else {
+        Report("IR key map saved to %s\r\n", IR_KEYMAP_FILE);
+    }
+    startGame();
 }
 
-// GPIO interrupt handler for IR signal edge detection
-static void GPIOA0IntHandler(void) {
-    IR_intflag = 1;
-    if (edge == 1) {    // Rising edge: start of pulse
-        SysTickReset();
-        edge = 0;
-        MAP_GPIOIntTypeSet(IR_SIGNAL.port, IR_SIGNAL.pin, GPIO_FALLING_EDGE);
-    } else {            // Falling edge: end of pulse
-        delta_ticks = SYSTICK_RELOAD_VAL - SysTickValueGet();
-        edge = 1;
-        MAP_GPIOIntTypeSet(IR_SIGNAL.port, IR_SIGNAL.pin, GPIO_RISING_EDGE);
+// Timer capture interrupt for the IR receiver. The GPT latches the counter on
+// both edges in hardware, so ISR latency no longer adds jitter to pulse widths.
+static void IRCaptureIntHandler(void) {
+    uint32_t isr_start = SysTickNow();
+    unsigned long ulStatus = MAP_TimerIntStatus(IR_TIMER_BASE, true);
+    MAP_TimerIntClear(IR_TIMER_BASE, ulStatus);
+
+    if (ulStatus & TIMER_TIMB_TIMEOUT) {
+        ir_capture_wraps++;
+    }
+    if (ulStatus & TIMER_CAPB_EVENT) {
+        uint32_t capture = MAP_TimerValueGet(IR_TIMER_BASE, IR_TIMER) & IR_CAPTURE_MASK;
+        uint32_t elapsed;
+
+        // The counter runs down, so elapsed = last - now modulo one period,
+        // which is only exact if less than a full period has passed
+        if (ir_capture_wraps > 1 || (ir_capture_wraps == 1 && capture <= ir_last_capture)) {
+            // Idle gap: saturate, and resync the level since the line idles
+            // high (this edge must be falling)
+            elapsed = IR_CAPTURE_MASK;
+            ir_capture_level = 1;
+        } else {
+            elapsed = (ir_last_capture - capture) & IR_CAPTURE_MASK;
+        }
+        ir_capture_level ^= 1;
+        ir_capture_time += elapsed;
+        ir_last_capture = capture;
+        ir_capture_wraps = 0;
+        ir_capture_tick = isr_start;
+        irRingPush(&ir_edges, ir_capture_time, ir_capture_level);
+    }
+    ISR_PROFILE_RECORD(isr_prof_ir_capture, SysTickNow() - isr_start);
+}
+
+// Accelerometer INT1: a new sample is ready to fetch
+static void AccelDataReadyIntHandler(void) {
+    unsigned long status = MAP_GPIOIntStatus(ACCEL_INT_GPIO_BASE, true);
+    MAP_GPIOIntClear(ACCEL_INT_GPIO_BASE, status);
+    if (status & ACCEL_INT_GPIO_PIN) {
+        accel_ready_time = SysTickNow();
+        accel_ready_count++;
     }
-    unsigned long ulStatus = MAP_GPIOIntStatus(GPIOA0_BASE, true);
-    MAP_GPIOIntClear(GPIOA0_BASE, ulStatus);
 }
 
-// Decode IR pulse width to bit value
-int decodePulse(int timeElapsed){
-    if(SHORT_PULSE_MIN < timeElapsed && timeElapsed < SHORT_PULSE_MAX){
-        return 1; // short pulse
+static void onIREvent(IrEventType type, const IrEvent *ir) {
+    switch (type) {
+    case IR_EVENT_FRAME:
+        LOG_DEBUG("Received: %s address 0x%02X command 0x%02X (0x%08X)\r\n",
+               ir_protocols[ir->protocol].name, ir->address, ir->command, (unsigned int)ir->raw);
+        onIRFrame(ir);
+        break;
+    case IR_EVENT_REPEAT:
+        if (ir_learn_button < 0) {
+            onButtonRepeat(irKeyMapGet(&ir_keymap, irEventKey(ir)));
+        }
+        break;
+    case IR_EVENT_ERROR:
+        LOG_DEBUG("Received: Invalid %s Signal\r\n", ir_protocols[ir->protocol].name);
+        break;
+    default:
+        break;
     }
-    else if (LONG_PULSE_MIN < timeElapsed && timeElapsed < LONG_PULSE_MAX){
-        return 0; // long pulse
+}
+
+// Drain queued IR edges, turn them into mark/space widths and run them
+// through the multi-protocol decoder
+void processIREdges(void) {
+    IrEdge ev;
+    IrEvent ir;
+
+    // Edges were dropped while the ring was full: the frame in progress is
+    // incomplete, so start over from the next leader
+    if (ir_edges.overflows != ir_overflows_seen) {
+        LOG_WARN("IR edge ring overflow (%u edges dropped in total)\r\n",
+               (unsigned int)ir_edges.overflows);
+        ir_overflows_seen = ir_edges.overflows;
+        irDecoderReset(&ir_decoder);
     }
-    else {
-        return -1;
+
+    while (irRingPop(&ir_edges, &ev)) {
+        uint32_t width_us = TICKS_TO_US(ev.timestamp - ir_last_edge_time);
+        ir_last_edge_time = ev.timestamp;
+
+        // The receiver output is low while the carrier is on, so a rising
+        // edge ends a mark and a falling edge ends a space
+        onIREvent(irDecoderFeed(&ir_decoder, ev.level == 1, width_us, &ir), &ir);
     }
+
+    // An RC5 frame ending in a 0 bit is only complete once its trailing space
+    // is known to be long, and the next edge may be a whole press away. The
+    // capture timer is the ISR's, so the idle time is measured on SysTick.
+    onIREvent(irDecoderIdle(&ir_decoder, TICKS_TO_US(SysTickNow() - ir_capture_tick), &ir), &ir);
 }
 
-// Initialize SysTick timer
+// Initialize SysTick as a free-running time base; the wrap interrupt extends
+// the 24-bit counter to 32 bits
 static void SysTickInit(void) {
+    g_ulSysTickWraps = 0;
     MAP_SysTickPeriodSet(SYSTICK_RELOAD_VAL);
-    MAP_SysTickIntDisable();
+    MAP_SysTickIntRegister(SysTickIntHandler);
+    MAP_SysTickIntEnable();
     MAP_SysTickEnable();
 }
 
-// Reset SysTick timer and timing variables
-static inline void SysTickReset(void) {
-    HWREG(NVIC_ST_CURRENT) = 1;
-    delta_ticks = 0;
-    delta_us = 0;
+// SysTick wrap interrupt
+static void SysTickIntHandler(void) {
+    g_ulSysTickWraps++;
+}
+
+// Wrap count and counter value as one consistent pair. Safe from ISRs: a wrap
+// that is pending but not yet serviced is detected from the NVIC and counted.
+static uint32_t SysTickRead(uint32_t *value) {
+    uint32_t wraps;
+    do {
+        wraps = g_ulSysTickWraps;
+        *value = SysTickValueGet();
+    } while (wraps != g_ulSysTickWraps);
+    if ((HWREG(NVIC_INT_CTRL) & NVIC_INT_CTRL_PENDSTSET) && *value > SYSTICK_RELOAD_VAL / 2) {
+        wraps++;
+    }
+    return wraps;
+}
+
+// Current time in CPU ticks (wraps every ~53 s)
+static uint32_t SysTickNow(void) {
+    uint32_t value;
+    uint32_t wraps = SysTickRead(&value);
+    return wraps * SYSTICK_RELOAD_VAL + (SYSTICK_RELOAD_VAL - 1 - value);
+}
+
+// Milliseconds since SysTickInit. Wraps after ~50 days instead of ~53 s, for
+// boot milestones that may come late (no access point in range).
+static uint32_t SysTickUptimeMs(void) {
+    uint32_t value;
+    uint32_t wraps = SysTickRead(&value);
+    return wraps * (uint32_t)(SYSTICK_RELOAD_VAL / TICKS_PER_MS) +
+           (SYSTICK_RELOAD_VAL - 1 - value) / (uint32_t)TICKS_PER_MS;
 }
 
 // Timer interrupt handler for multi-tap input timeout
+// Multi-tap timeout: commit the selected character. Only buffer updates happen
+// here; the OLED (SPI) and UART output is deferred to the main loop so it
+// can't interleave with a transfer the main loop has in progress.
 void TimerBaseIntHandler(void) {
+    uint32_t isr_start = SysTickNow();
     Timer_IF_InterruptClear(g_ulBase);
     if (pressCount > 0 && prevButton >= 0 && bufferIndex < sizeof(displayBuffer) - 1) {
         int btnChoices = strlen(keyMap[prevButton]);
         if (btnChoices > 0) {
             char c = keyMap[prevButton][(pressCount - 1) % btnChoices];
             displayBuffer[bufferIndex - 1] = c;
-            printOLED(displayBuffer, 0, 98, WHITE); // Display at bottom of screen (y=98)
-            Report("%c", c);
+            workQueuePost(&deferred_work, showMultiTapChar, (uint32_t)(unsigned char)c);
             MessageTx[msgIndex++] = c;
             MessageTx[msgIndex] = '\0';
             pressCount = 0;
@@ -960,6 +1411,82 @@ void TimerBaseIntHandler(void) {
         pressCount = 0;
         prevButton = -1;
     }
+    ISR_PROFILE_RECORD(isr_prof_multitap, SysTickNow() - isr_start);
+}
+
+// Bottom half of TimerBaseIntHandler
+void showMultiTapChar(uint32_t c) {
+    printOLED(displayBuffer, 0, 98, WHITE); // Display at bottom of screen (y=98)
+    Report("%c", (char)c);
+}
+
+static void reportIsrProfile(const char *name, const IsrProfile *prof) {
+    uint32_t max_us = TICKS_TO_US(prof->max_ticks);
+    if (prof->count == 0) {
+        return;
+    }
+    Report("ISR %s: %u runs, max %u us, avg %u us%s\r\n", name,
+           (unsigned int)prof->count, (unsigned int)max_us,
+           (unsigned int)TICKS_TO_US(prof->total_ticks / prof->count),
+           max_us > ISR_BUDGET_US ? " - OVER BUDGET" : "");
+}
+
+// Log interrupt handler timing, frame time and deferred-work queue health
+void reportIsrProfiles() {
+    reportIsrProfile("IR capture", &isr_prof_ir_capture);
+    reportIsrProfile("multi-tap", &isr_prof_multitap);
+    if (frame_prof.count > 0) {
+        Report("Frame: %u frames, max %u us, avg %u us of %u us (log level %d compiled, %d runtime)\r\n",
+               (unsigned int)frame_prof.count, (unsigned int)TICKS_TO_US(frame_prof.max_ticks),
+               (unsigned int)TICKS_TO_US(frame_prof.total_ticks / frame_prof.count),
+               (unsigned int)TICKS_TO_US(FRAME_DELAY_TICKS), LOG_COMPILED_LEVEL, logGetLevel());
+    }
+    Report("Deferred work: high water %u/%u, %u dropped\r\n",
+           (unsigned int)deferred_work.high_water, (unsigned int)WORK_QUEUE_SIZE,
+           (unsigned int)deferred_work.dropped);
+
+    TlsConnStats tls_stats;
+    tlsConnGetStats(&tls_stats);
+    if (tls_stats.connects > 0) {
+        Report("TLS: %lu connects (%lu reconnects), %lu failed, %lu dropped, setup last %u ms, avg %u ms, max %u ms\r\n",
+               tls_stats.connects, tls_stats.reconnects, tls_stats.failures, tls_stats.drops,
+               (unsigned int)(TICKS_TO_US(tls_stats.last_setup_ticks) / 1000),
+               (unsigned int)(TICKS_TO_US(tls_stats.total_setup_ticks / tls_stats.connects) / 1000),
+               (unsigned int)(TICKS_TO_US(tls_stats.max_setup_ticks) / 1000));
+    }
+
+    DnsCacheStats dns_stats;
+    dnsCacheGetStats(&dns_stats);
+    Report("Boot: Wi-Fi %u ms (%s), playable %u ms, cloud ready %u ms; DNS cache %lu hits, %lu stored, %lu dropped\r\n",
+           (unsigned int)boot_wifi_ms, wlan_rejoined ? "stored profile" : "full setup",
+           (unsigned int)boot_playable_ms, (unsigned int)boot_cloud_ms,
+           dns_stats.hits, dns_stats.stores, dns_stats.invalidations);
+
+    AwsShadowStats shadow_stats;
+    awsShadowGetStats(&shadow_stats);
+    Report("AWS shadow: %lu requests, %lu responses, %lu failed, %lu conflicts, slowest %u ms\r\n",
+           shadow_stats.requests, shadow_stats.responses, shadow_stats.failures, shadow_stats.conflicts,
+           (unsigned int)(TICKS_TO_US(shadow_stats.max_ticks) / 1000));
+#ifndef AWS_SHADOW_HTTP
+    MqttStats mqtt_stats;
+    mqttGetStats(&mqtt_stats);
+    Report("MQTT: %lu sessions, %lu published (%lu resent), %lu acked, %lu received, %lu pings, %lu errors, slowest ack %u ms\r\n",
+           mqtt_stats.sessions, mqtt_stats.publishes, mqtt_stats.retransmits, mqtt_stats.acks,
+           mqtt_stats.messages, mqtt_stats.pings, mqtt_stats.errors,
+           (unsigned int)(TICKS_TO_US(mqtt_stats.max_ack_ticks) / 1000));
+#endif
+
+    ScoreCacheStats score_stats;
+    scoreCacheGetStats(&score_stats);
+    Report("Score cache: best %d%s, %lu flash writes (%lu failed), %lu posts, %lu synced\r\n",
+           scoreCacheBest(), scoreCacheUnsynced() ? " (not yet in the shadow)" : "",
+           score_stats.writes, score_stats.write_errors, score_stats.posts, score_stats.synced);
+
+    UartLogStats log_stats;
+    uartLogGetStats(&log_stats);
+    Report("UART log: %lu messages, %lu dropped (%lu bytes), high water %u/%u\r\n",
+           log_stats.messages, log_stats.dropped, log_stats.dropped_bytes,
+           (unsigned int)log_stats.high_water, (unsigned int)UART_LOG_RING_SIZE);
 }
 
 // ========================= ACCELEROMETER/I2C SECTION =========================
@@ -1034,7 +1561,8 @@ int ParseNProcessCmd(char *pcCmdBuffer) {
 }
 
 // ========================= ACCELEROMETER SHIP CONTROL SECTION =========================
-// Read accelerometer value for specified axis using command-based I2C access
+// Debug path: read one axis through the "readreg" command parser.
+// Gameplay uses the accelRead() burst instead.
 // axis: 'X' for X-axis (register 0x5), 'Y' for Y-axis (register 0x3)
 int readAccelAxis(char axis) {
     static int error_count_x = 0;
@@ -1047,11 +1575,11 @@ int readAccelAxis(char axis) {
 
     // Determine register address and error counter based on axis
     if (axis == 'X' || axis == 'x') {
-        register_addr = 0x5;
+        register_addr = ACCEL_REG_X;
         error_count = &error_count_x;
         axis_name = "X";
     } else if (axis == 'Y' || axis == 'y') {
-        register_addr = 0x3;
+        register_addr = ACCEL_REG_Y;
         error_count = &error_count_y;
         axis_name = "Y";
     } else {
@@ -1059,6 +1587,11 @@ int readAccelAxis(char axis) {
         return 0;
     }
 
+    // The polled driver can't share the bus with a queued async transfer
+    if (!i2cAsyncIdle()) {
+        return 0;
+    }
+
     // Create command string: "readreg 0x18 0x[register] 1" (device 0x18, register based on axis, read 1 byte)
     sprintf(cmdBuffer, "readreg 0x18 0x%x 1", register_addr);
 
@@ -1086,91 +1619,115 @@ int readAccelAxis(char axis) {
     return accelValue;
 }
 
-// Wrapper functions for backward compatibility
-int readAccelX() {
-    return readAccelAxis('X');
-}
-
-int readAccelY() {
-    return readAccelAxis('Y');
-}
-
 // Update ship movement based on accelerometer readings
 void updateShipFromAccel() {
-    static int accel_counter = 0;
     static int cached_accel_x = 0;
     static int cached_accel_y = 0;
+    static int error_count = 0;
     static int debug_counter = 0;
     static int last_movement_report = 0;
-
-    // Read accelerometer every 2 frames to reduce I2C overhead (increased from 3 for more responsiveness)
-    accel_counter++;
-    if (accel_counter >= 2) {
-        int new_accel_x = readAccelX();
-        int new_accel_y = readAccelY();
-
-        // Only update if we got valid readings (non-zero or first read)
-        if (new_accel_x != 0 || new_accel_y != 0 || (cached_accel_x == 0 && cached_accel_y == 0)) {
-            cached_accel_x = new_accel_x;
-            cached_accel_y = new_accel_y;
+    static TiltStatus last_status = TILT_OK;
+    AccelSample sample;
+    TiltStatus status;
+    int result;
+
+    uint32_t now = SysTickNow();
+    uint32_t ready = accel_ready_count;
+
+    // Use the burst read started earlier; it ran on the I2C interrupt while
+    // the last frame rendered. On an I2C error keep the last good sample
+    // rather than snapping the ship to neutral.
+    result = accelReadAsyncResult(&sample);
+    if (result > 0) {
+        cached_accel_x = sample.x;
+        cached_accel_y = sample.y;
+        accel_sample_time = accel_fetch_time;
+        error_count = 0;
+        tiltFilterSample(&ship_tilt, sample.x);
+    } else if (result < 0) {
+        tiltFilterError(&ship_tilt);
+        if (error_count++ % 100 == 0) { // Report every 100th error to avoid spam
+            LOG_WARN("Accel burst read error (device 0x%x), error count: %d\r\n", ACCEL_I2C_ADDR, error_count);
         }
+    }
 
-        accel_counter = 0;
-
-        // Debug output every 20 readings (more frequent for troubleshooting)
-        debug_counter++;
-        if (debug_counter >= 20) {
-            Report("Accel raw values - X: %d, Y: %d (Device 0x18 responding: %s)\r\n",
-                   cached_accel_x, cached_accel_y,
-                   (cached_accel_x != 0 || cached_accel_y != 0) ? "YES" : "NO");
-            debug_counter = 0;
+    // Fetch only when the sensor has flagged new data. There is no FIFO, so
+    // several pulses since the last fetch collapse into reading the newest.
+    // If pulses stop (INT1 not wired, sensor reset) poll every frame instead.
+    if (ready != accel_fetched_count) {
+        accel_quiet_frames = 0;
+        if (accelReadAsyncStart() == 0) {
+            accel_samples_coalesced += ready - accel_fetched_count - 1;
+            accel_fetched_count = ready;
+            accel_fetch_time = accel_ready_time;
         }
-    }    // Apply accelerometer offset correction for better balance
-    int x_speed_calc = cached_accel_x;
-    int y_speed_calc = cached_accel_y;
-
-    // Add deadzone to reduce jitter and improve balance
-    const int deadzone = 3;  // Ignore small movements within this range
-    if (x_speed_calc > -deadzone && x_speed_calc < deadzone) {
-        x_speed_calc = 0;
+    } else if (accel_quiet_frames < ACCEL_STALE_FRAMES) {
+        accel_quiet_frames++;
+    } else if (accelReadAsyncStart() == 0) {
+        accel_fetch_time = now;
+    }
+    accel_sample_age_us = TICKS_TO_US(now - accel_sample_time);
+
+    // Trace output every 20 frames
+    debug_counter++;
+    if (debug_counter >= 20) {
+        LOG_TRACE("Accel raw values - X: %d, Y: %d, age %u us, %u coalesced (Device 0x18 responding: %s)\r\n",
+               cached_accel_x, cached_accel_y, (unsigned int)accel_sample_age_us,
+               (unsigned int)accel_samples_coalesced, error_count == 0 ? "YES" : "NO");
+        debug_counter = 0;
     }
 
-    // Apply movement with reduced scaling factor (changed from 2 to 1)
-    x_speed = -1 * x_speed_calc;    // Reduced speed: Move left/right based on tilt
+    // Filtered, calibrated tilt through the response curve gives a sub-pixel
+    // velocity; a fault (read errors, stale sample) stops the ship
+    status = tiltFilterOutput(&ship_tilt, accel_sample_age_us, &x_speed);
     y_speed = 0;                    // Disable vertical movement - ship only moves left/right
 
-    // Clamp speeds to reasonable values for smooth gameplay (reduced limits)
-    if (x_speed > 2) x_speed = 2;   // Reduced from 4 to 2
-    if (x_speed < -2) x_speed = -2; // Reduced from -4 to -2
-    // No Y-speed clamping needed since y_speed is always 0
-
-    // Report movement changes and accelerometer status
-    int movement_changed = (x_speed != last_movement_report);
+    // Report movement changes (in whole pixels) and accelerometer status
+    int movement_changed = (FIX_ROUND(x_speed) != last_movement_report);
     if (movement_changed || debug_counter == 0) {
-        Report("Ship control - Speed: X=%d (Y=0-disabled) | Accel raw: X=%d, Y=%d | Calc: X=%d, Y=%d | Deadzone: %d\r\n",
-               x_speed, cached_accel_x, cached_accel_y, x_speed_calc, y_speed_calc, deadzone);
-        last_movement_report = x_speed;
-
-        // Additional diagnostic information
-        if (cached_accel_x == 0 && cached_accel_y == 0) {
-            Report("WARNING: Accelerometer returning zero values - check I2C connection to device 0x18\r\n");
+        LOG_DEBUG("Ship control - Speed: X=%d/256 px/frame | Tilt: %d/256 (offset %d/256) | Accel raw: X=%d, Y=%d\r\n",
+               x_speed, ship_tilt.pos, ship_tilt.offset, cached_accel_x, cached_accel_y);
+        last_movement_report = FIX_ROUND(x_speed);
+    }
+    if (status != last_status) {
+        if (status == TILT_FAULT) {
+            LOG_WARN("WARNING: No usable accelerometer data (age %u us, %d read errors) - ship stopped\r\n",
+                   (unsigned int)accel_sample_age_us, ship_tilt.errors);
+        } else {
+            LOG_INFO("Accelerometer data OK - tilt control resumed\r\n");
         }
+        last_status = status;
     }
 }
 
-// ========================= AWS/IoT SECTION =========================
-// Build JSON message for AWS IoT
-void buildJson() {
-    snprintf(DATA1, sizeof(DATA1),
-        "{"
-        "\"state\": {\r\n"
-            "\"desired\" : {\r\n"
-                "\"highscore\" : \"%s\"\r\n"
-            "}"
-        "}"
-        "}\r\n\r\n", MessageTx);
+// Set up the tilt pipeline and measure the level offset while the board sits
+// still at boot. If it moved (or reads fail) the filter keeps a zero offset.
+void tiltInit() {
+    const TiltConfig cfg = {
+        TILT_ALPHA, TILT_BETA, TILT_DEADZONE, TILT_FULL, TILT_EXPO, SHIP_MAX_SPEED,
+        1,  // Tilting right reads negative X
+        TILT_MAX_ERRORS, ACCEL_MAX_AGE_US
+    };
+    int8_t samples[TILT_CALIB_SAMPLES];
+    AccelSample sample;
+    int count = 0;
+    int i;
+
+    tiltFilterInit(&ship_tilt, &cfg);
+    for (i = 0; i < TILT_CALIB_SAMPLES; i++) {
+        if (accelRead(&sample) == 0) {
+            samples[count++] = sample.x;
+        }
+        MAP_UtilsDelay(ACCEL_CALIB_DELAY);
+    }
+    if (count < TILT_CALIB_SAMPLES / 2 || tiltFilterCalibrate(&ship_tilt, samples, count) != 0) {
+        Report("Tilt calibration skipped (%d good samples or board moving) - using zero offset\r\n", count);
+        return;
+    }
+    Report("Tilt calibration: level offset %d/256 counts\r\n", ship_tilt.offset);
 }
 
+// ========================= AWS/IoT SECTION =========================
 // Set device time for secure connections
 static int set_time() {
     long retVal;
@@ -1187,146 +1744,33 @@ static int set_time() {
     return SUCCESS;
 }
 
-// Send message to AWS IoT via HTTP POST
-void awsMsg() {
-    UART_PRINT("Calling http_post with socket ID: %d\n\r", lRetVal);
-    http_post(lRetVal);
-    msgIndex = 0;
-    memset(MessageTx, 0, sizeof(MessageTx)); // Properly clear the buffer
-}
-
-static int http_get(int iTLSSockID) {
-    char acSendBuff[512];
-    char acRecvbuff[1460];
-    char* pcBufHeaders;
-    int lRetVal = 0;
-
-    // Compose GET request
-    pcBufHeaders = acSendBuff;
-    strcpy(pcBufHeaders, "GET /things/CC3200/shadow HTTP/1.1\r\n");
-    pcBufHeaders += strlen("GET /things/CC3200/shadow HTTP/1.1\r\n");
-    strcpy(pcBufHeaders, HOSTHEADER);
-    pcBufHeaders += strlen(HOSTHEADER);
-    strcpy(pcBufHeaders, CHEADER);
-    pcBufHeaders += strlen(CHEADER);
-    strcpy(pcBufHeaders, "\r\n");
-
-    UART_PRINT(acSendBuff);
+// Seconds since 1970 from the network processor's clock (set by set_time),
+// for leaderboard entries; 0 if it can't be read
+static uint32_t clockSeconds() {
+    SlDateTime now;
+    unsigned char option = SL_DEVICE_GENERAL_CONFIGURATION_DATE_TIME;
+    unsigned char len = sizeof(now);
+    long y, m, yoe, doy, days;
 
-    // Send GET request
-    lRetVal = sl_Send(iTLSSockID, acSendBuff, strlen(acSendBuff), 0);
-    if (lRetVal < 0) {
-        UART_PRINT("GET failed. Error Number: %i\n\r", lRetVal);
-        sl_Close(iTLSSockID);
-        return lRetVal;
+    if (sl_DevGet(SL_DEVICE_GENERAL_CONFIGURATION, &option, &len, (unsigned char *)&now) < 0) {
+        return 0;
     }
-
-    // Receive response
-    lRetVal = sl_Recv(iTLSSockID, &acRecvbuff[0], sizeof(acRecvbuff), 0);
-    if (lRetVal < 0) {
-        UART_PRINT("Receive failed. Error Number: %i\n\r", lRetVal);
-        return lRetVal;
-    } else {
-        acRecvbuff[lRetVal] = '\0'; // Null-terminate the response
-        UART_PRINT(acRecvbuff);
-        UART_PRINT("\n\r\n\r");        // Extract highscore from JSON response
-        char* highscore_ptr = strstr(acRecvbuff, "\"highscore\"");
-        if (highscore_ptr) {
-            char extractedHighscore[20] = {0};
-            // Try multiple format patterns to handle different JSON formatting
-            int parsed = 0;
-
-            // First try format with space: "highscore" : "value"
-            if (sscanf(highscore_ptr, "\"highscore\" : \"%19[^\"]\"", extractedHighscore) == 1) {
-                parsed = 1;
-            }
-            // Then try format without space: "highscore":"value"
-            else if (sscanf(highscore_ptr, "\"highscore\":\"%19[^\"]\"", extractedHighscore) == 1) {
-                parsed = 1;
-            }
-            // Try format with varying spaces: "highscore" :"value" or "highscore": "value"
-            else if (sscanf(highscore_ptr, "\"highscore\"%*[ :]%*[ ]\"%19[^\"]\"", extractedHighscore) == 1) {
-                parsed = 1;
-            }
-              if (parsed) {
-                UART_PRINT("Extracted highscore: %s\n\r", extractedHighscore);
-                // Convert to int
-                int highscore_value = atoi(extractedHighscore);
-                UART_PRINT("Highscore as integer: %d\n\r", highscore_value);
-                return highscore_value; // Return the parsed high score
-            } else {
-                UART_PRINT("Failed to parse highscore value from JSON\n\r");
-            }
-        } else {
-            UART_PRINT("highscore not found in response.\n\r");
-        }
-    }    return -1; // Return -1 to indicate failure
+    // Days from the civil date, with March as the first month of the year
+    y = (long)now.tm_year - (now.tm_mon <= 2);
+    m = (long)now.tm_mon;
+    yoe = y % 400;
+    doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + (long)now.tm_day - 1;
+    days = (y / 400) * 146097 + yoe * 365 + yoe / 4 - yoe / 100 + doy - 719468;
+    return (uint32_t)days * 86400UL + now.tm_hour * 3600UL + now.tm_min * 60UL + now.tm_sec;
 }
 
-// Get high score from AWS IoT
-int getHighScoreFromAWS() {
-    UART_PRINT("Retrieving high score from AWS IoT...\n\r");
-
-    // Use the global socket ID (lRetVal) for the GET request
-    int awsHighScore = http_get(lRetVal);
-
-    if (awsHighScore >= 0) {
-        UART_PRINT("Successfully retrieved AWS high score: %d\n\r", awsHighScore);
-        return awsHighScore;
-    } else {
-        UART_PRINT("Failed to retrieve high score from AWS, using default value 0\n\r");
-        return 0; // Return 0 as fallback if AWS retrieval fails
-    }
-}
-
-// Perform HTTP POST to AWS IoT endpoint
-static int http_post(int iTLSSockID){
-    char acSendBuff[512];
-    char acRecvbuff[1460];
-    char cCLLength[200];
-    char* pcBufHeaders;
-    int lRetVal = 0;
-    pcBufHeaders = acSendBuff;
-    strcpy(pcBufHeaders, POSTHEADER);
-    pcBufHeaders += strlen(POSTHEADER);
-    strcpy(pcBufHeaders, HOSTHEADER);
-    pcBufHeaders += strlen(HOSTHEADER);
-    strcpy(pcBufHeaders, CHEADER);
-    pcBufHeaders += strlen(CHEADER);
-    strcpy(pcBufHeaders, "\r\n\r\n");
-    int dataLength = strlen(DATA1);
-    strcpy(pcBufHeaders, CTHEADER);
-    pcBufHeaders += strlen(CTHEADER);
-    strcpy(pcBufHeaders, CLHEADER1);
-    pcBufHeaders += strlen(CLHEADER1);
-    sprintf(cCLLength, "%d", dataLength);
-    strcpy(pcBufHeaders, cCLLength);
-    pcBufHeaders += strlen(cCLLength);
-    strcpy(pcBufHeaders, CLHEADER2);
-    pcBufHeaders += strlen(CLHEADER2);
-    strcpy(pcBufHeaders, DATA1);
-    pcBufHeaders += strlen(DATA1);
-    int testDataLength = strlen(pcBufHeaders);
-    UART_PRINT(acSendBuff);
-    // Send the packet to the server
-    lRetVal = sl_Send(iTLSSockID, acSendBuff, strlen(acSendBuff), 0);
-    if(lRetVal < 0) {
-        UART_PRINT("POST failed. Error Number: %i\n\r",lRetVal);
-        sl_Close(iTLSSockID);
-        return lRetVal;
-    }
-    lRetVal = sl_Recv(iTLSSockID, &acRecvbuff[0], sizeof(acRecvbuff), 0);
-    if(lRetVal < 0) {
-        UART_PRINT("Received failed. Error Number: %i\n\r",lRetVal);
-        //sl_Close(iSSLSockID);
-        return lRetVal;
-    }
-    else {
-        acRecvbuff[lRetVal+1] = '\0';
-        UART_PRINT(acRecvbuff);
-        UART_PRINT("\n\r\n\r");
-    }
-    return 0;
+// A shadow response carried a different high score
+void onHighScoreChanged(int high_score) {
+    Report("AWS high score is now %d\r\n", high_score);
+    scoreCacheSeen(high_score);
+    if (current_game_state == GAME_STATE_START_SCREEN) {
+        drawStartHighScore(scoreCacheBest());
+    }
 }
 
 // ========================= TARGETS SECTION =========================
@@ -1380,14 +1824,16 @@ void initAsteroids() {
         asteroids[i].y = 0;
         asteroids[i].dx = 0;
         asteroids[i].dy = 0;
+        asteroids[i].px = 0;
+        asteroids[i].py = 0;
         asteroids[i].radius = 0;
         asteroids[i].sides = 0;
         asteroids[i].speed = 0;
+        asteroids[i].slot = -1;
     }
     spawnAsteroidInSlot(&asteroids[0], 0);
-    setAsteroidSlotUsed(0, 1);
-    Report("Dynamic asteroid system initialized with 1 asteroid: pos(%d,%d), velocity(%d,%d), radius=%d, speed=%d\r\n",
-           asteroids[0].x, asteroids[0].y, asteroids[0].dx, asteroids[0].dy, asteroids[0].radius, asteroids[0].speed);
+    Report("Dynamic asteroid system initialized with 1 asteroid: pos(%d,%d), velocity(%d,%d)/256, radius=%d, speed=%d\r\n",
+           asteroids[0].px, asteroids[0].py, asteroids[0].dx, asteroids[0].dy, asteroids[0].radius, asteroids[0].speed);
 }
 
 // ========================= DYNAMIC ASTEROID SPAWNING SYSTEM =========================
@@ -1413,7 +1859,7 @@ void checkScoreMilestones() {
                 current_num_asteroids++;
                 next_milestone = temp_milestone; // Set next milestone
 
-                Report("Score milestone reached! Score: %d, Level: %d, Active asteroids: %d, Next milestone: %d\r\n",
+                LOG_INFO("Score milestone reached! Score: %d, Level: %d, Active asteroids: %d, Next milestone: %d\r\n",
                        player_score, milestone_level, current_num_asteroids, next_milestone);
             }
         }
@@ -1431,8 +1877,8 @@ int isPositionSafe(int x, int y, int radius) {
         if (asteroids[i].radius == 0) continue;
 
         // Calculate distance between centers
-        int dx = x - asteroids[i].x;
-        int dy = y - asteroids[i].y;
+        int dx = x - FIX_TO_INT(asteroids[i].x);
+        int dy = y - FIX_TO_INT(asteroids[i].y);
         int distance_squared = dx * dx + dy * dy;
         int required_distance = radius + asteroids[i].radius + min_safe_distance;
 
@@ -1506,11 +1952,18 @@ void i2cInit() {
         if (writeResult == SUCCESS) {
             Report("Accelerometer configured successfully\r\n");
 
+            if (accelEnableDataReady() != SUCCESS) {
+                Report("Failed to enable accelerometer data-ready interrupt - polling instead\r\n");
+            }
+
             // Test read to verify functionality
             MAP_UtilsDelay(1000000); // 370ms delay for stabilization
-            int testX = readAccelX();
-            int testY = readAccelY();
-            Report("Initial accelerometer test read - X: %d, Y: %d\r\n", testX, testY);
+            AccelSample test;
+            if (accelRead(&test) == 0) {
+                Report("Initial accelerometer test read - X: %d, Y: %d\r\n", test.x, test.y);
+            } else {
+                Report("Initial accelerometer test read failed\r\n");
+            }
 
         } else {
             Report("Failed to activate accelerometer\r\n");
@@ -1521,13 +1974,33 @@ void i2cInit() {
 }
 
 void interruptInit() {
-    unsigned long ulStatus;
-    MAP_GPIOIntRegister(IR_SIGNAL.port, GPIOA0IntHandler);
-    MAP_GPIOIntTypeSet(IR_SIGNAL.port, IR_SIGNAL.pin, GPIO_RISING_EDGE);
-    ulStatus = MAP_GPIOIntStatus(IR_SIGNAL.port, false);
-    MAP_GPIOIntClear(IR_SIGNAL.port, ulStatus);
-    IR_intcount=0; IR_intflag=0;
-    MAP_GPIOIntEnable(IR_SIGNAL.port, IR_SIGNAL.pin);
+    IR_intcount=0;
+    irRingInit(&ir_edges);
+    irDecoderInit(&ir_decoder);
+    workQueueInit(&deferred_work);
+
+    // Interrupt-driven I2C for per-frame accelerometer reads (after SysTick,
+    // which times out stuck transfers)
+    i2cAsyncInit(&i2c_async_hw_ops, SysTickNow, I2C_ASYNC_TIMEOUT_TICKS);
+    i2cAsyncHwInit(1);  // i2cInit opened the bus in fast mode
+
+    // Accelerometer data-ready pulses (INT1, active high)
+    MAP_GPIOIntRegister(ACCEL_INT_GPIO_BASE, AccelDataReadyIntHandler);
+    MAP_GPIOIntTypeSet(ACCEL_INT_GPIO_BASE, ACCEL_INT_GPIO_PIN, GPIO_RISING_EDGE);
+    MAP_GPIOIntClear(ACCEL_INT_GPIO_BASE, ACCEL_INT_GPIO_PIN);
+    MAP_GPIOIntEnable(ACCEL_INT_GPIO_BASE, ACCEL_INT_GPIO_PIN);
+
+    // IR receiver: free-running 24-bit edge-time capture on both edges
+    MAP_PRCMPeripheralReset(PRCM_TIMERA3);
+    MAP_TimerConfigure(IR_TIMER_BASE, TIMER_CFG_SPLIT_PAIR | TIMER_CFG_B_CAP_TIME);
+    MAP_TimerControlEvent(IR_TIMER_BASE, IR_TIMER, TIMER_EVENT_BOTH_EDGES);
+    MAP_TimerPrescaleSet(IR_TIMER_BASE, IR_TIMER, 0xFF);
+    MAP_TimerLoadSet(IR_TIMER_BASE, IR_TIMER, 0xFFFF);
+    MAP_TimerIntRegister(IR_TIMER_BASE, IR_TIMER, IRCaptureIntHandler);
+    MAP_TimerIntClear(IR_TIMER_BASE, TIMER_CAPB_EVENT | TIMER_TIMB_TIMEOUT);
+    MAP_TimerIntEnable(IR_TIMER_BASE, TIMER_CAPB_EVENT | TIMER_TIMB_TIMEOUT);
+    MAP_TimerEnable(IR_TIMER_BASE, IR_TIMER);
+
     g_ulBase = TIMERA0_BASE;
     Timer_IF_Init(PRCM_TIMERA0, g_ulBase, TIMER_CFG_PERIODIC, TIMER_A, 0);
     Timer_IF_IntSetup(g_ulBase, TIMER_A, TimerBaseIntHandler);
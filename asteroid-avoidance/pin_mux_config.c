@@ -59,7 +59,6 @@ void PinMuxConfig(void)
     //
     PinModeSet(PIN_01, PIN_MODE_0);
     PinModeSet(PIN_04, PIN_MODE_0);
-    PinModeSet(PIN_08, PIN_MODE_0);
     PinModeSet(PIN_15, PIN_MODE_0);
     PinModeSet(PIN_21, PIN_MODE_0);
     PinModeSet(PIN_45, PIN_MODE_0);
@@ -73,10 +72,12 @@ void PinMuxConfig(void)
     //
     PRCMPeripheralClkEnable(PRCM_GPIOA0, PRCM_RUN_MODE_CLK);
     PRCMPeripheralClkEnable(PRCM_GPIOA1, PRCM_RUN_MODE_CLK);
+    PRCMPeripheralClkEnable(PRCM_GPIOA2, PRCM_RUN_MODE_CLK);
     PRCMPeripheralClkEnable(PRCM_GPIOA3, PRCM_RUN_MODE_CLK);
     PRCMPeripheralClkEnable(PRCM_GSPI, PRCM_RUN_MODE_CLK);
     PRCMPeripheralClkEnable(PRCM_UARTA0, PRCM_RUN_MODE_CLK);
     PRCMPeripheralClkEnable(PRCM_UARTA1, PRCM_RUN_MODE_CLK);
+    PRCMPeripheralClkEnable(PRCM_TIMERA3, PRCM_RUN_MODE_CLK);
 
     //
     // Configure PIN_64 for GPIOOutput
@@ -101,10 +102,15 @@ void PinMuxConfig(void)
     GPIODirModeSet(GPIOA0_BASE, 0x40, GPIO_DIR_MODE_OUT);
 
     //
-    // Configure PIN_62 for GPIO Input
+    // Configure PIN_62 for TimerCP7 GT_CCP07 (IR receiver input capture)
     //
-    PinTypeGPIO(PIN_62, PIN_MODE_0, false);
-    GPIODirModeSet(GPIOA0_BASE, 0x80, GPIO_DIR_MODE_IN);
+    PinTypeTimer(PIN_62, PIN_MODE_13);
+
+    //
+    // Configure PIN_08 for GPIO Input (accelerometer INT1 data ready)
+    //
+    PinTypeGPIO(PIN_08, PIN_MODE_0, false);
+    GPIODirModeSet(GPIOA2_BASE, 0x2, GPIO_DIR_MODE_IN);
 
     //
     // Configure PIN_03 for GPIO Input
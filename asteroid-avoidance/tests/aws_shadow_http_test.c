@@ -0,0 +1,265 @@
+//*****************************************************************************
+// aws_shadow_http_test.c - aws_shadow's REST transport against a versioned
+//                          fake shadow: 409 conflicts, re-read and merge
+//
+// aws_shadow keeps its queue and cache across awsShadowInit(), so the tests
+// run in order as one device's session, each starting from the state the
+// last one left.
+//*****************************************************************************
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "fake_shadow.h"
+#include "aws_shadow.h"
+#include "log.h"
+
+#define HOST            "example-ats.iot.us-east-1.amazonaws.com"
+#define TIMEOUT_TICKS   500
+#define MAX_POLLS       400
+
+volatile uint8_t log_level_mask = LOG_MASK(LOG_LEVEL_ERROR) | LOG_MASK(LOG_LEVEL_WARN);
+
+static int reports;
+static int changed_score = -1;
+static int changed_calls;
+
+int Report(const char *pcFormat, ...) {
+    (void)pcFormat;
+    reports++;
+    return 0;
+}
+
+static void onChange(int high_score) {
+    changed_score = high_score;
+    changed_calls++;
+}
+
+static LeaderboardEntry entry(const char *initials, uint32_t score, uint32_t time) {
+    LeaderboardEntry e;
+    memset(&e, 0, sizeof(e));
+    strcpy(e.initials, initials);
+    e.score = score;
+    e.time = time;
+    return e;
+}
+
+// Poll until nothing is queued or in flight; returns the polls taken, or -1
+static int pollUntilIdle(void) {
+    int i;
+    for (i = 0; i < MAX_POLLS; i++) {
+        awsShadowPoll();
+        fake_shadow_now++;
+        if (awsShadowIdle()) {
+            return i + 1;
+        }
+    }
+    return -1;
+}
+
+// A settled client sends nothing more
+static void checkQuiet(void) {
+    int gets = fake_shadow.gets;
+    int posts = fake_shadow.post_count;
+    int i;
+
+    for (i = 0; i < 50; i++) {
+        awsShadowPoll();
+        fake_shadow_now++;
+    }
+    CHECK_EQ(fake_shadow.gets, gets);
+    CHECK_EQ(fake_shadow.post_count, posts);
+}
+
+// Times "initials:score:time" is an entry of an encoded table
+static int countEntry(const char *text, const char *want) {
+    int n = 0;
+    int len = (int)strlen(want);
+
+    while (*text) {
+        int piece = (int)strcspn(text, ";");
+        if (piece == len && strncmp(text, want, len) == 0) {
+            n++;
+        }
+        text += piece;
+        if (*text == ';') {
+            text++;
+        }
+    }
+    return n;
+}
+
+// Every entry of the stored table appears in it once
+static void checkNoDuplicates(const char *text) {
+    Leaderboard lb;
+    char one[32];
+    int i;
+
+    CHECK_EQ(leaderboardDecode(&lb, text), 0);
+    for (i = 0; i < lb.count; i++) {
+        snprintf(one, sizeof(one), "%s:%lu:%lu", lb.entries[i].initials,
+                 (unsigned long)lb.entries[i].score, (unsigned long)lb.entries[i].time);
+        CHECK_EQ(countEntry(text, one), 1);
+    }
+}
+
+// No document yet: the read finds none and the first write creates it
+// unconditionally
+static void testFirstWriteCreates(void) {
+    LeaderboardEntry e = entry("AAA", 500, 1);
+    AwsShadowStats st;
+
+    CHECK_EQ(awsShadowSubmit(&e), 0);
+    awsShadowPostScore(500);
+    CHECK(!awsShadowIdle());
+    CHECK(pollUntilIdle() > 0);
+
+    CHECK_EQ(fake_shadow.gets, 1);
+    CHECK_EQ(fake_shadow.post_count, 1);
+    CHECK_EQ(fake_shadow.posts[0].status, 200);
+    CHECK_EQ(fake_shadow.posts[0].version, -1);
+    CHECK_EQ(fake_shadow.posts[0].score, 500);
+    CHECK(strcmp(fake_shadow.posts[0].board, "AAA:500:1") == 0);
+    CHECK_EQ(fake_shadow.version, 1);
+    CHECK_EQ(fake_shadow.score, 500);
+    CHECK_EQ(awsShadowHighScore(-1), 500);
+    CHECK_EQ(changed_score, 500);
+    CHECK_EQ(fake_shadow.malformed, 0);
+
+    awsShadowGetStats(&st);
+    CHECK_EQ(st.requests, 2);
+    CHECK_EQ(st.conflicts, 0);
+    checkQuiet();
+}
+
+// Another device wrote a better score and its own entry since our last read:
+// the post at the old version gets 409, the re-read brings in the rival's
+// table, and the entry goes out merged into it, once. The score no longer
+// beats the stored one, so it isn't posted again. The accepted answer
+// carries no table, so the client has to settle the entry from the post.
+static void testConflictMergesAfterReread(void) {
+    LeaderboardEntry e = entry("BOB", 600, 3);
+    Leaderboard view;
+    const ShadowPost *first, *second;
+    AwsShadowStats st;
+
+    fakeShadowWrite(700, "RIV:700:2;AAA:500:1");
+    CHECK_EQ(fake_shadow.version, 2);
+    fake_shadow.terse = 1;
+
+    CHECK_EQ(awsShadowSubmit(&e), 0);       // Ranked against the stale table
+    awsShadowPostScore(600);
+    CHECK(pollUntilIdle() > 0);
+    fake_shadow.terse = 0;
+
+    CHECK_EQ(fake_shadow.post_count, 3);
+    CHECK_EQ(fake_shadow.gets, 2);
+    first = &fake_shadow.posts[1];
+    second = &fake_shadow.posts[2];
+    CHECK_EQ(first->status, 409);
+    CHECK_EQ(first->version, 1);
+    CHECK_EQ(first->score, 600);
+    CHECK(strcmp(first->board, "BOB:600:3;AAA:500:1") == 0);
+    CHECK_EQ(second->status, 200);
+    CHECK_EQ(second->version, 2);
+    CHECK_EQ(second->score, -1);
+    CHECK(strcmp(second->board, "RIV:700:2;BOB:600:3;AAA:500:1") == 0);
+
+    // The rival's entry kept, ours added, nothing twice
+    CHECK_EQ(fake_shadow.version, 3);
+    CHECK_EQ(fake_shadow.score, 700);
+    CHECK_EQ(countEntry(fake_shadow.board, "RIV:700:2"), 1);
+    CHECK_EQ(countEntry(fake_shadow.board, "BOB:600:3"), 1);
+    CHECK_EQ(countEntry(fake_shadow.board, "AAA:500:1"), 1);
+    checkNoDuplicates(fake_shadow.board);
+    CHECK_EQ(fakeShadowPosts(200), 2);
+
+    CHECK_EQ(awsShadowHighScore(-1), 700);
+    CHECK_EQ(changed_score, 700);
+    awsShadowLeaderboard(&view);
+    CHECK_EQ(view.count, 3);
+    CHECK_EQ(leaderboardFind(&view, &e), 1);
+
+    awsShadowGetStats(&st);
+    CHECK_EQ(st.conflicts, 1);
+    CHECK_EQ(st.failures, 0);
+    checkQuiet();
+    CHECK_EQ(fakeShadowPosts(200), 2);
+}
+
+// A write racing ours just before it lands, with the answers trickling in a
+// few bytes per receive: our higher score still wins on the retry
+static void testConflictRetriesHigherScore(void) {
+    LeaderboardEntry e = entry("DOG", 900, 5);
+    const ShadowPost *last;
+    AwsShadowStats st;
+
+    fake_shadow.race_posts = 1;
+    fake_shadow.recv_chunk = 5;
+    CHECK_EQ(awsShadowSubmit(&e), 0);
+    awsShadowPostScore(900);
+    CHECK(pollUntilIdle() > 0);
+    fake_shadow.recv_chunk = 0;
+
+    CHECK_EQ(fake_shadow.post_count, 5);
+    CHECK_EQ(fake_shadow.gets, 3);
+    CHECK_EQ(fake_shadow.posts[3].status, 409);
+    CHECK_EQ(fake_shadow.posts[3].version, 3);
+    last = &fake_shadow.posts[4];
+    CHECK_EQ(last->status, 200);
+    CHECK_EQ(last->version, 4);
+    CHECK_EQ(last->score, 900);
+    CHECK(strcmp(last->board, "DOG:900:5;RIV:700:2;BOB:600:3;AAA:500:1") == 0);
+
+    CHECK_EQ(fake_shadow.score, 900);
+    CHECK_EQ(countEntry(fake_shadow.board, "DOG:900:5"), 1);
+    checkNoDuplicates(fake_shadow.board);
+    CHECK_EQ(awsShadowHighScore(-1), 900);
+    CHECK_EQ(fake_shadow.malformed, 0);
+
+    awsShadowGetStats(&st);
+    CHECK_EQ(st.conflicts, 2);
+    checkQuiet();
+}
+
+// Losing every race: after AWS_SHADOW_MAX_CONFLICTS retries the score and
+// entry are dropped rather than posted forever, and never stored
+static void testConflictLimit(void) {
+    LeaderboardEntry e = entry("EEL", 950, 6);
+    AwsShadowStats st;
+    int posts = fake_shadow.post_count;
+    int i;
+
+    fake_shadow.race_posts = AWS_SHADOW_MAX_CONFLICTS + 5;
+    CHECK_EQ(awsShadowSubmit(&e), 0);
+    awsShadowPostScore(950);
+    CHECK(pollUntilIdle() > 0);
+
+    CHECK_EQ(fake_shadow.post_count - posts, AWS_SHADOW_MAX_CONFLICTS + 1);
+    for (i = posts; i < fake_shadow.post_count; i++) {
+        CHECK_EQ(fake_shadow.posts[i].status, 409);
+        CHECK_EQ(fake_shadow.posts[i].score, 950);
+        CHECK_EQ(countEntry(fake_shadow.posts[i].board, "EEL:950:6"), 1);
+    }
+    CHECK_EQ(countEntry(fake_shadow.board, "EEL:950:6"), 0);
+    CHECK_EQ(fake_shadow.score, 900);
+
+    awsShadowGetStats(&st);
+    CHECK_EQ(st.conflicts, 2 + AWS_SHADOW_MAX_CONFLICTS + 1);
+    fake_shadow.race_posts = 0;
+    checkQuiet();
+}
+
+int main(void) {
+    fakeShadowReset();
+    awsShadowInit(HOST, fakeShadowClock, TIMEOUT_TICKS, onChange);
+
+    testFirstWriteCreates();
+    testConflictMergesAfterReread();
+    testConflictRetriesHigherScore();
+    testConflictLimit();
+    CHECK_EQ(fake_shadow.fails, 0);
+    return testExitCode("aws_shadow_http_test");
+}
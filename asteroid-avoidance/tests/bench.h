@@ -0,0 +1,33 @@
+//*****************************************************************************
+// bench.h - Wall-clock timing for the host benchmarks
+//
+// Host numbers only rank changes against each other; they say nothing
+// absolute about the 80 MHz Cortex-M4.
+//*****************************************************************************
+
+#ifndef TESTS_BENCH_H_
+#define TESTS_BENCH_H_
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+
+static double benchNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Keeps results alive so the optimizer can't drop the work being timed
+static volatile long bench_sink;
+
+static void benchReport(const char *name, long iterations, long bytes, double seconds) {
+    printf("%-34s %10ld iterations %9.1f ns/iter", name, iterations, seconds * 1e9 / iterations);
+    if (bytes > 0) {
+        printf(" %8.1f MB/s", bytes / seconds / 1e6);
+    }
+    printf("\n");
+}
+
+#endif /* TESTS_BENCH_H_ */
@@ -0,0 +1,315 @@
+//*****************************************************************************
+// fake_broker.c - MqttTransportOps stand-in with a scripted MQTT broker
+//*****************************************************************************
+
+#include "fake_broker.h"
+
+#include <string.h>
+
+FakeBroker fake_broker;
+uint32_t fake_broker_now;
+
+static char in[FAKE_BROKER_BUF_SIZE];      // From the client, not yet a whole packet
+static int in_len;
+static char out[FAKE_BROKER_BUF_SIZE];     // To the client
+static int out_len;
+static int out_pos;
+static int closing;                         // recv() reports a close when out[] is drained
+
+void fakeBrokerReset(void) {
+    memset(&fake_broker, 0, sizeof(fake_broker));
+    fake_broker.online = 1;
+    fake_broker.answer_connect = 1;
+    fake_broker.answer_subscribe = 1;
+    fake_broker.answer_publish = 1;
+    fake_broker.answer_ping = 1;
+    fake_broker_now = 0;
+    in_len = 0;
+    out_len = 0;
+    out_pos = 0;
+    closing = 0;
+}
+
+uint32_t fakeBrokerClock(void) {
+    return fake_broker_now;
+}
+
+void fakeBrokerDrop(int graceful) {
+    out_len = 0;
+    out_pos = 0;
+    in_len = 0;
+    if (graceful) {
+        closing = 1;
+    } else {
+        fake_broker.up = 0;
+    }
+}
+
+void fakeBrokerQueue(const char *data, int len) {
+    if (out_len + len <= FAKE_BROKER_BUF_SIZE) {
+        memcpy(out + out_len, data, len);
+        out_len += len;
+    }
+}
+
+static void queueAck(uint8_t type, uint8_t b0, uint8_t b1) {
+    char p[4];
+    p[0] = (char)(type << 4);
+    p[1] = 2;
+    p[2] = (char)b0;
+    p[3] = (char)b1;
+    fakeBrokerQueue(p, 4);
+}
+
+void fakeBrokerPublish(const char *topic, const char *payload, int qos, uint16_t id) {
+    char p[FAKE_BROKER_BUF_SIZE];
+    int topic_len = (int)strlen(topic);
+    int payload_len = (int)strlen(payload);
+    long remaining = 2 + topic_len + (qos ? 2 : 0) + payload_len;
+    int n = 0;
+
+    p[n++] = (char)((BROKER_PUBLISH << 4) | (qos ? 0x02 : 0));
+    do {
+        char b = (char)(remaining % 128);
+        remaining /= 128;
+        p[n++] = (char)(remaining ? b | 0x80 : b);
+    } while (remaining);
+    p[n++] = (char)(topic_len >> 8);
+    p[n++] = (char)topic_len;
+    memcpy(p + n, topic, topic_len);
+    n += topic_len;
+    if (qos) {
+        p[n++] = (char)(id >> 8);
+        p[n++] = (char)id;
+    }
+    memcpy(p + n, payload, payload_len);
+    fakeBrokerQueue(p, n + payload_len);
+}
+
+int fakeBrokerCount(uint8_t type) {
+    int i, n = 0;
+    for (i = 0; i < fake_broker.packets; i++) {
+        if (fake_broker.log[i].type == type) {
+            n++;
+        }
+    }
+    return n;
+}
+
+const BrokerPacket *fakeBrokerLast(uint8_t type) {
+    int i;
+    for (i = fake_broker.packets - 1; i >= 0; i--) {
+        if (fake_broker.log[i].type == type) {
+            return &fake_broker.log[i];
+        }
+    }
+    return NULL;
+}
+
+static void copyText(char *dst, int size, const uint8_t *src, int len) {
+    if (len > size - 1) {
+        len = size - 1;
+    }
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+// One whole packet from the client: log it and answer
+static void handle(const uint8_t *p, int body, int len) {
+    BrokerPacket *pkt;
+    const uint8_t *b = p + body;
+    int blen = len - body;
+    int n;
+
+    if (fake_broker.packets == FAKE_BROKER_MAX_PACKETS) {
+        return;
+    }
+    pkt = &fake_broker.log[fake_broker.packets++];
+    memset(pkt, 0, sizeof(*pkt));
+    pkt->type = p[0] >> 4;
+    pkt->flags = p[0] & 0x0F;
+
+    switch (pkt->type) {
+    case BROKER_CONNECT:
+        // "MQTT", level, flags, keep-alive, then the client ID
+        if (blen < 12 || memcmp(b, "\0\4MQTT\4", 7) != 0) {
+            fake_broker.malformed++;
+            break;
+        }
+        n = (b[10] << 8) | b[11];
+        copyText(pkt->text, sizeof(pkt->text), b + 12, n);
+        if (fake_broker.answer_connect) {
+            queueAck(BROKER_CONNACK, 0, fake_broker.connack_code);
+        }
+        break;
+    case BROKER_SUBSCRIBE: {
+        char suback[4 + 8];
+        int pos = 2;
+
+        pkt->id = (uint16_t)((b[0] << 8) | b[1]);
+        while (pos + 2 <= blen) {
+            n = (b[pos] << 8) | b[pos + 1];
+            if (pkt->topics == 0) {
+                copyText(pkt->text, sizeof(pkt->text), b + pos + 2, n);
+            }
+            pkt->topics++;
+            pos += 2 + n + 1;
+        }
+        if (pos != blen || pkt->flags != 0x02 || pkt->topics > 8) {
+            fake_broker.malformed++;
+            break;
+        }
+        if (fake_broker.answer_subscribe) {
+            suback[0] = (char)(BROKER_SUBACK << 4);
+            suback[1] = (char)(2 + pkt->topics);
+            suback[2] = (char)(pkt->id >> 8);
+            suback[3] = (char)pkt->id;
+            memset(suback + 4, 1, pkt->topics);     // Granted QoS 1
+            fakeBrokerQueue(suback, 4 + pkt->topics);
+        }
+        break;
+    }
+    case BROKER_PUBLISH:
+        n = (b[0] << 8) | b[1];
+        copyText(pkt->text, sizeof(pkt->text), b + 2, n);
+        n += 2;
+        if (pkt->flags & 0x06) {
+            pkt->id = (uint16_t)((b[n] << 8) | b[n + 1]);
+            n += 2;
+        }
+        pkt->payload_len = blen - n;
+        copyText(pkt->payload, sizeof(pkt->payload), b + n, blen - n);
+        if ((pkt->flags & 0x06) && fake_broker.answer_publish) {
+            queueAck(BROKER_PUBACK, (uint8_t)(pkt->id >> 8), (uint8_t)pkt->id);
+        }
+        break;
+    case BROKER_PUBACK:
+        pkt->id = (uint16_t)((b[0] << 8) | b[1]);
+        break;
+    case BROKER_PINGREQ:
+        if (fake_broker.answer_ping) {
+            char pingresp[2] = { (char)(BROKER_PINGRESP << 4), 0 };
+            fakeBrokerQueue(pingresp, 2);
+        }
+        break;
+    default:
+        fake_broker.malformed++;
+        break;
+    }
+}
+
+// Take whole packets off the front of in[]
+static void parseIn(void) {
+    for (;;) {
+        const uint8_t *p = (const uint8_t *)in;
+        long remaining = 0, mult = 1;
+        int pos = 1;
+
+        if (in_len < 2) {
+            return;
+        }
+        do {
+            if (pos >= in_len) {
+                return;
+            }
+            remaining += (p[pos] & 0x7F) * mult;
+            mult *= 128;
+        } while (p[pos++] & 0x80);
+        if (pos + remaining > in_len) {
+            return;
+        }
+        handle(p, pos, pos + (int)remaining);
+        in_len -= pos + (int)remaining;
+        memmove(in, in + pos + remaining, in_len);
+    }
+}
+
+static void brokerPoll(void) {
+}
+
+static int brokerAcquire(void) {
+    if (!fake_broker.up) {
+        if (!fake_broker.online) {
+            return -1;
+        }
+        fake_broker.up = 1;
+        fake_broker.connections++;
+        in_len = 0;
+        out_len = 0;
+        out_pos = 0;
+        closing = 0;
+    }
+    return 0;
+}
+
+static int brokerUp(void) {
+    return fake_broker.up;
+}
+
+static void brokerRelease(void) {
+    fake_broker.releases++;
+}
+
+static void brokerFail(long err) {
+    fake_broker.fails++;
+    fake_broker.last_fail = err;
+    fake_broker.up = 0;
+}
+
+static int brokerKeepAliveDue(void) {
+    return fake_broker.up && fake_broker.keepalive_due;
+}
+
+static long brokerSend(const char *data, int len) {
+    if (!fake_broker.up) {
+        return -1;
+    }
+    if (fake_broker.send_chunk && len > fake_broker.send_chunk) {
+        len = fake_broker.send_chunk;
+    }
+    if (in_len + len > FAKE_BROKER_BUF_SIZE) {
+        return MQTT_TRANSPORT_AGAIN;
+    }
+    memcpy(in + in_len, data, len);
+    in_len += len;
+    parseIn();
+    return len;
+}
+
+static long brokerRecv(char *buf, int len) {
+    int n = out_len - out_pos;
+
+    if (!fake_broker.up) {
+        return -1;
+    }
+    if (n == 0) {
+        if (closing) {
+            return 0;
+        }
+        return MQTT_TRANSPORT_AGAIN;
+    }
+    if (n > len) {
+        n = len;
+    }
+    if (fake_broker.recv_chunk && n > fake_broker.recv_chunk) {
+        n = fake_broker.recv_chunk;
+    }
+    memcpy(buf, out + out_pos, n);
+    out_pos += n;
+    if (out_pos == out_len) {
+        out_pos = 0;
+        out_len = 0;
+    }
+    return n;
+}
+
+const MqttTransportOps fake_broker_ops = {
+    brokerPoll,
+    brokerAcquire,
+    brokerUp,
+    brokerRelease,
+    brokerFail,
+    brokerKeepAliveDue,
+    brokerSend,
+    brokerRecv
+};
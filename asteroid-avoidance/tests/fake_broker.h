@@ -0,0 +1,84 @@
+//*****************************************************************************
+// fake_broker.h - MqttTransportOps stand-in with a scripted MQTT broker
+//
+// Bytes the client sends are parsed into whole packets and logged. By
+// default the broker answers the way AWS IoT does: CONNACK to CONNECT,
+// SUBACK granting QoS 1, PUBACK to a QoS 1 PUBLISH and PINGRESP to PINGREQ.
+// Each answer can be switched off to simulate a lost reply. The connection
+// can be refused or dropped, and sends and receives can be cut into small
+// pieces to exercise partial reads and writes.
+//*****************************************************************************
+
+#ifndef TESTS_FAKE_BROKER_H_
+#define TESTS_FAKE_BROKER_H_
+
+#include <stdint.h>
+
+#include "mqtt_client.h"
+
+#define FAKE_BROKER_MAX_PACKETS 32
+#define FAKE_BROKER_BUF_SIZE    2048
+
+// MQTT packet types
+#define BROKER_CONNECT          1
+#define BROKER_CONNACK          2
+#define BROKER_PUBLISH          3
+#define BROKER_PUBACK           4
+#define BROKER_SUBSCRIBE        8
+#define BROKER_SUBACK           9
+#define BROKER_PINGREQ          12
+#define BROKER_PINGRESP         13
+
+typedef struct {
+    uint8_t type;               // Upper nibble of the first byte
+    uint8_t flags;              // Lower nibble
+    uint16_t id;                // Packet ID where the type has one
+    char text[64];              // CONNECT client ID, PUBLISH topic, first SUBSCRIBE topic
+    int topics;                 // SUBSCRIBE topic count
+    char payload[256];          // PUBLISH payload (terminated)
+    int payload_len;
+} BrokerPacket;
+
+typedef struct {
+    // Behaviour
+    int online;                 // acquire() succeeds
+    uint8_t connack_code;       // 0 accepts the session
+    int answer_connect;
+    int answer_subscribe;
+    int answer_publish;         // PUBACK to QoS 1
+    int answer_ping;
+    int keepalive_due;          // Returned by keepAliveDue()
+    int send_chunk;             // Most bytes taken per send() (0: all)
+    int recv_chunk;             // Most bytes handed out per recv() (0: all)
+
+    // Observed
+    int up;
+    int connections;            // Successful acquire() calls
+    int fails;
+    long last_fail;
+    int releases;
+    BrokerPacket log[FAKE_BROKER_MAX_PACKETS];
+    int packets;
+    int malformed;              // Client bytes that didn't parse
+} FakeBroker;
+
+extern FakeBroker fake_broker;
+extern const MqttTransportOps fake_broker_ops;
+extern uint32_t fake_broker_now;    // Clock handed to mqttInit()
+
+void fakeBrokerReset(void);
+uint32_t fakeBrokerClock(void);
+
+// The connection drops: recv() reports a close once queued bytes are read
+// if graceful, else up() goes false at once. Queued replies are lost.
+void fakeBrokerDrop(int graceful);
+
+// Queue raw bytes for the client, or a PUBLISH (qos 0 or 1)
+void fakeBrokerQueue(const char *data, int len);
+void fakeBrokerPublish(const char *topic, const char *payload, int qos, uint16_t id);
+
+// Logged packets of a type (MQTT packet type number), and the last of them
+int fakeBrokerCount(uint8_t type);
+const BrokerPacket *fakeBrokerLast(uint8_t type);
+
+#endif /* TESTS_FAKE_BROKER_H_ */
@@ -0,0 +1,201 @@
+//*****************************************************************************
+// fake_i2c_bus.c - I2cBusOps stand-in with one simulated register device
+//*****************************************************************************
+
+#include "fake_i2c_bus.h"
+
+#include <string.h>
+
+FakeI2cBus fake_i2c;
+uint32_t fake_i2c_now;
+
+static uint8_t addr;            // From setAddress()
+static int receive;
+static uint8_t tx;              // From putByte()
+static uint8_t rx;
+static int rx_valid;
+static int in_burst;            // A START was issued and no stop yet
+static int burst_receive;
+static int burst_bytes;         // Bytes written in this burst (the first is the pointer)
+static uint32_t pending;        // Events of the step in flight
+static int hung;
+
+void fakeI2cReset(uint8_t device) {
+    memset(&fake_i2c, 0, sizeof(fake_i2c));
+    fake_i2c.device = device;
+    fake_i2c.nak_step = FAKE_I2C_NO_FAULT;
+    fake_i2c.timeout_step = FAKE_I2C_NO_FAULT;
+    fake_i2c.hang_step = FAKE_I2C_NO_FAULT;
+    fake_i2c_now = 0;
+    rx_valid = 0;
+    in_burst = 0;
+    pending = 0;
+    hung = 0;
+}
+
+uint32_t fakeI2cClock(void) {
+    return fake_i2c_now;
+}
+
+static void fakeSetAddress(uint8_t a, int r) {
+    addr = a;
+    receive = r;
+}
+
+static void fakePutByte(uint8_t data) {
+    tx = data;
+}
+
+static uint8_t fakeGetByte(void) {
+    if (!rx_valid) {
+        fake_i2c.misuse++;
+    }
+    rx_valid = 0;
+    return rx;
+}
+
+static void writeByte(void) {
+    if (burst_bytes++ == 0) {
+        fake_i2c.pointer = tx;
+    } else {
+        fake_i2c.regs[fake_i2c.pointer++] = tx;
+    }
+}
+
+static void readByte(void) {
+    rx = fake_i2c.regs[fake_i2c.pointer++];
+    rx_valid = 1;
+}
+
+// Start (or repeated start) addressing the device; 0 if nobody ACKs
+static int start(int is_receive) {
+    if (receive != is_receive) {
+        fake_i2c.misuse++;
+    }
+    in_burst = 1;
+    burst_receive = is_receive;
+    burst_bytes = 0;
+    return addr == fake_i2c.device;
+}
+
+static void fakeCommand(I2cBusCmd cmd) {
+    int step = fake_i2c.cmd_count;
+    int ack = 1;
+
+    if (fake_i2c.cmd_count < FAKE_I2C_MAX_CMDS) {
+        fake_i2c.cmds[fake_i2c.cmd_count] = cmd;
+    }
+    fake_i2c.cmd_count++;
+
+    if (cmd == I2C_BUS_SEND_ERROR_STOP || cmd == I2C_BUS_RECEIVE_ERROR_STOP) {
+        // Abandons the step in flight; no interrupt follows
+        in_burst = 0;
+        pending = 0;
+        hung = 0;
+        return;
+    }
+    if (!fake_i2c.irq_enabled || pending != 0 || hung) {
+        fake_i2c.misuse++;
+    }
+
+    switch (cmd) {
+    case I2C_BUS_SINGLE_SEND:
+    case I2C_BUS_SEND_START:
+        ack = start(0);
+        if (ack) {
+            writeByte();
+        }
+        in_burst = (cmd == I2C_BUS_SEND_START);
+        break;
+    case I2C_BUS_SEND_CONT:
+    case I2C_BUS_SEND_FINISH:
+        if (!in_burst || burst_receive) {
+            fake_i2c.misuse++;
+        }
+        writeByte();
+        in_burst = (cmd == I2C_BUS_SEND_CONT);
+        break;
+    case I2C_BUS_SINGLE_RECEIVE:
+    case I2C_BUS_RECEIVE_START:
+        ack = start(1);
+        if (ack) {
+            readByte();
+        }
+        in_burst = (cmd == I2C_BUS_RECEIVE_START);
+        break;
+    case I2C_BUS_RECEIVE_CONT:
+    case I2C_BUS_RECEIVE_FINISH:
+        if (!in_burst || !burst_receive) {
+            fake_i2c.misuse++;
+        }
+        readByte();
+        in_burst = (cmd == I2C_BUS_RECEIVE_CONT);
+        break;
+    default:
+        fake_i2c.misuse++;
+        break;
+    }
+
+    if (step == fake_i2c.hang_step) {
+        hung = 1;
+    } else if (step == fake_i2c.timeout_step) {
+        pending = I2C_BUS_EV_TIMEOUT;
+    } else if (!ack || step == fake_i2c.nak_step) {
+        pending = I2C_BUS_EV_ERROR;
+    } else {
+        pending = I2C_BUS_EV_DONE;
+    }
+}
+
+static void fakeEnableIrq(int on) {
+    fake_i2c.irq_enabled = on;
+}
+
+static void fakeRecover(void) {
+    fake_i2c.recoveries++;
+    in_burst = 0;
+    pending = 0;
+    hung = 0;
+    rx_valid = 0;
+}
+
+static unsigned long fakeLock(void) {
+    return (unsigned long)fake_i2c.lock_depth++;
+}
+
+static void fakeUnlock(unsigned long state) {
+    fake_i2c.lock_depth--;
+    if ((unsigned long)fake_i2c.lock_depth != state) {
+        fake_i2c.misuse++;
+    }
+}
+
+const I2cBusOps fake_i2c_ops = {
+    fakeSetAddress,
+    fakePutByte,
+    fakeGetByte,
+    fakeCommand,
+    fakeEnableIrq,
+    fakeRecover,
+    fakeLock,
+    fakeUnlock
+};
+
+uint32_t fakeI2cInterrupt(void) {
+    uint32_t events = pending;
+
+    if (events == 0 || !fake_i2c.irq_enabled) {
+        return 0;
+    }
+    pending = 0;
+    i2cAsyncIsr(events);
+    return events;
+}
+
+int fakeI2cRun(void) {
+    int n = 0;
+    while (fakeI2cInterrupt() != 0) {
+        n++;
+    }
+    return n;
+}
@@ -0,0 +1,54 @@
+//*****************************************************************************
+// fake_i2c_bus.h - I2cBusOps stand-in with one simulated register device
+//
+// Each byte step started through command() completes only when the test
+// calls fakeI2cInterrupt(), so a transfer can be interleaved with main-loop
+// code one interrupt at a time. Faults are armed per step: a NAK, a hardware
+// clock-low timeout, or a step that never completes at all.
+//*****************************************************************************
+
+#ifndef TESTS_FAKE_I2C_BUS_H_
+#define TESTS_FAKE_I2C_BUS_H_
+
+#include <stdint.h>
+
+#include "i2c_async.h"
+
+#define FAKE_I2C_MAX_CMDS   64
+#define FAKE_I2C_NO_FAULT   -1
+
+typedef struct {
+    // Device
+    uint8_t device;             // 7-bit address that ACKs
+    uint8_t regs[256];
+    uint8_t pointer;            // Register pointer (auto-increments)
+
+    // Faults, by step number (0 = first command since fakeI2cReset)
+    int nak_step;
+    int timeout_step;           // Ends in I2C_BUS_EV_TIMEOUT
+    int hang_step;              // Never interrupts
+
+    // Observed
+    I2cBusCmd cmds[FAKE_I2C_MAX_CMDS];
+    int cmd_count;
+    int irq_enabled;
+    int recoveries;
+    int lock_depth;
+    int misuse;                 // Calls the controller would not accept
+} FakeI2cBus;
+
+extern FakeI2cBus fake_i2c;
+extern const I2cBusOps fake_i2c_ops;
+extern uint32_t fake_i2c_now;   // Clock handed to i2cAsyncInit()
+
+void fakeI2cReset(uint8_t device);
+uint32_t fakeI2cClock(void);
+
+// Complete the step in flight and run the ISR. Returns the events delivered,
+// or 0 if no step is in flight (or it hangs).
+uint32_t fakeI2cInterrupt(void);
+
+// Interrupts until the bus goes quiet; returns how many were delivered
+int fakeI2cRun(void);
+
+#endif /* TESTS_FAKE_I2C_BUS_H_ */
@@ -0,0 +1,264 @@
+//*****************************************************************************
+// fake_shadow.c - tls_conn and socket stand-in with a versioned shadow server
+//*****************************************************************************
+
+#include "fake_shadow.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simplelink.h"
+#include "tls_conn.h"
+
+#define SOCKET      3
+
+FakeShadow fake_shadow;
+uint32_t fake_shadow_now;
+
+static int up;
+static char in[FAKE_SHADOW_BUF_SIZE + 1];   // From the client, not yet a whole request
+static int in_len;
+static char out[FAKE_SHADOW_BUF_SIZE];      // To the client
+static int out_len;
+static int out_pos;
+
+void fakeShadowReset(void) {
+    memset(&fake_shadow, 0, sizeof(fake_shadow));
+    fake_shadow.online = 1;
+    fake_shadow.score = -1;
+    fake_shadow_now = 0;
+    up = 0;
+    in_len = 0;
+    out_len = 0;
+    out_pos = 0;
+}
+
+uint32_t fakeShadowClock(void) {
+    return fake_shadow_now;
+}
+
+void fakeShadowWrite(long score, const char *board) {
+    fake_shadow.exists = 1;
+    fake_shadow.version++;
+    if (score >= 0) {
+        fake_shadow.score = score;
+    }
+    if (board) {
+        snprintf(fake_shadow.board, sizeof(fake_shadow.board), "%s", board);
+    }
+}
+
+int fakeShadowPosts(int status) {
+    int i, n = 0;
+    for (i = 0; i < fake_shadow.post_count; i++) {
+        if (fake_shadow.posts[i].status == status) {
+            n++;
+        }
+    }
+    return n;
+}
+
+static void respond(int status, const char *reason, const char *body) {
+    int n = snprintf(out + out_len, sizeof(out) - out_len,
+                     "HTTP/1.1 %d %s\r\n"
+                     "Content-Type: application/json\r\n"
+                     "Content-Length: %d\r\n"
+                     "Connection: keep-alive\r\n"
+                     "\r\n"
+                     "%s", status, reason, (int)strlen(body), body);
+    if (n > 0 && n < (int)sizeof(out) - out_len) {
+        out_len += n;
+    }
+}
+
+// The desired fields present (score -1, board NULL: left out) and the version
+static void document(char *doc, int size, long score, const char *board, long version) {
+    int n = snprintf(doc, size, "{\"state\":{\"desired\":{");
+    if (score >= 0) {
+        n += snprintf(doc + n, size - n, "\"highscore\":\"%ld\"%s", score, board ? "," : "");
+    }
+    if (board) {
+        n += snprintf(doc + n, size - n, "\"leaderboard\":\"%s\"", board);
+    }
+    snprintf(doc + n, size - n, "}},\"version\":%ld}", version);
+}
+
+static void handleGet(void) {
+    char doc[FAKE_SHADOW_BUF_SIZE / 2];
+
+    fake_shadow.gets++;
+    if (!fake_shadow.exists) {
+        respond(404, "Not Found", "{\"code\":404,\"message\":\"No shadow exists with name: 'CC3200'\"}");
+        return;
+    }
+    document(doc, sizeof(doc), fake_shadow.score, fake_shadow.board, fake_shadow.version);
+    respond(200, "OK", doc);
+}
+
+static void handlePost(const char *body) {
+    char doc[FAKE_SHADOW_BUF_SIZE / 2];
+    ShadowPost post;
+    const char *p;
+
+    memset(&post, 0, sizeof(post));
+    post.version = -1;
+    post.score = -1;
+    p = strstr(body, "\"version\":");
+    if (p) {
+        post.version = strtol(p + 10, NULL, 10);
+    }
+    p = strstr(body, "\"highscore\":\"");
+    if (p) {
+        post.score = strtol(p + 13, NULL, 10);
+    }
+    p = strstr(body, "\"leaderboard\":\"");
+    if (p) {
+        int len = (int)strcspn(p + 15, "\"");
+        post.has_board = 1;
+        if (len < (int)sizeof(post.board)) {
+            memcpy(post.board, p + 15, len);
+        } else {
+            fake_shadow.malformed++;
+        }
+    }
+
+    if (fake_shadow.race_posts > 0) {
+        // Another device's update lands first
+        fake_shadow.race_posts--;
+        fakeShadowWrite(-1, NULL);
+    }
+    if (post.version >= 0 && post.version != fake_shadow.version) {
+        post.status = 409;
+        respond(409, "Conflict", "{\"code\":409,\"message\":\"Version conflict\"}");
+    } else {
+        post.status = 200;
+        fakeShadowWrite(post.score, post.has_board ? post.board : NULL);
+        if (fake_shadow.terse) {
+            snprintf(doc, sizeof(doc), "{\"version\":%ld}", fake_shadow.version);
+        } else {
+            document(doc, sizeof(doc), post.score, post.has_board ? post.board : NULL,
+                     fake_shadow.version);
+        }
+        respond(200, "OK", doc);
+    }
+    if (fake_shadow.post_count < FAKE_SHADOW_MAX_POSTS) {
+        fake_shadow.posts[fake_shadow.post_count++] = post;
+    }
+}
+
+// Take whole requests off the front of in[]
+static void parseIn(void) {
+    for (;;) {
+        const char *end, *length;
+        long body_len = 0;
+        int total;
+        char body[FAKE_SHADOW_BUF_SIZE + 1];
+
+        in[in_len] = '\0';
+        end = strstr(in, "\r\n\r\n");
+        if (end == NULL) {
+            return;
+        }
+        length = strstr(in, "Content-Length:");
+        if (length && length < end) {
+            body_len = strtol(length + 15, NULL, 10);
+        }
+        total = (int)(end + 4 - in) + (int)body_len;
+        if (total > in_len) {
+            return;
+        }
+        memcpy(body, end + 4, body_len);
+        body[body_len] = '\0';
+
+        if (strncmp(in, "GET /things/CC3200/shadow ", 26) == 0 && body_len == 0) {
+            handleGet();
+        } else if (strncmp(in, "POST /things/CC3200/shadow ", 27) == 0 && body[0] == '{') {
+            handlePost(body);
+        } else {
+            fake_shadow.malformed++;
+        }
+        in_len -= total;
+        memmove(in, in + total, in_len);
+    }
+}
+
+static void drop(void) {
+    up = 0;
+    in_len = 0;
+    out_len = 0;
+    out_pos = 0;
+}
+
+void tlsConnPoll(int in_use) {
+    (void)in_use;
+}
+
+int tlsConnAcquire(void) {
+    if (!up && fake_shadow.online) {
+        up = 1;
+    }
+    return up ? SOCKET : -1;
+}
+
+void tlsConnRelease(void) {
+    fake_shadow.releases++;
+}
+
+void tlsConnClose(void) {
+    fake_shadow.closes++;
+    drop();
+}
+
+void tlsConnFail(long err) {
+    (void)err;
+    fake_shadow.fails++;
+    drop();
+}
+
+TlsConnState tlsConnState(void) {
+    return up ? TLS_CONN_UP : TLS_CONN_DOWN;
+}
+
+int tlsConnKeepAliveDue(void) {
+    return 0;
+}
+
+int16_t sl_Send(int16_t sd, const void *pBuf, int16_t Len, int16_t flags) {
+    (void)flags;
+    if (!up || sd != SOCKET) {
+        return -1;
+    }
+    if (in_len + Len > FAKE_SHADOW_BUF_SIZE) {
+        return SL_EAGAIN;
+    }
+    memcpy(in + in_len, pBuf, Len);
+    in_len += Len;
+    parseIn();
+    return Len;
+}
+
+int16_t sl_Recv(int16_t sd, void *pBuf, int16_t Len, int16_t flags) {
+    int n = out_len - out_pos;
+
+    (void)flags;
+    if (!up || sd != SOCKET) {
+        return -1;
+    }
+    if (n == 0) {
+        return SL_EAGAIN;
+    }
+    if (n > Len) {
+        n = Len;
+    }
+    if (fake_shadow.recv_chunk && n > fake_shadow.recv_chunk) {
+        n = fake_shadow.recv_chunk;
+    }
+    memcpy(pBuf, out + out_pos, n);
+    out_pos += n;
+    if (out_pos == out_len) {
+        out_pos = 0;
+        out_len = 0;
+    }
+    return (int16_t)n;
+}
@@ -0,0 +1,69 @@
+//*****************************************************************************
+// fake_shadow.h - tls_conn and socket stand-in with a versioned shadow server
+//
+// Defines the tls_conn functions and sl_Send()/sl_Recv(), so aws_shadow's
+// HTTP transport runs unchanged on the host. Requests are parsed once whole
+// and answered the way the AWS IoT REST API does: a GET returns the stored
+// document or 404, and a POST carrying a version other than the stored one
+// is refused with 409; otherwise the posted desired fields replace the
+// stored ones and the version goes up. Other devices' writes are simulated
+// between requests, or just before the next POSTs arrive, and every POST is
+// logged with what it carried.
+//*****************************************************************************
+
+#ifndef TESTS_FAKE_SHADOW_H_
+#define TESTS_FAKE_SHADOW_H_
+
+#include <stdint.h>
+
+#include "leaderboard.h"
+
+#define FAKE_SHADOW_MAX_POSTS   16
+#define FAKE_SHADOW_BUF_SIZE    2048
+
+typedef struct {
+    long version;               // "version" in the body, -1 if none
+    long score;                 // desired.highscore, -1 if none
+    int has_board;
+    char board[LEADERBOARD_TEXT_SIZE + 1];
+    int status;                 // Answer sent
+} ShadowPost;
+
+typedef struct {
+    // Stored document
+    int exists;                 // 0: GET answers 404
+    long version;
+    long score;
+    char board[LEADERBOARD_TEXT_SIZE + 1];
+
+    // Behaviour
+    int online;                 // tlsConnAcquire() succeeds
+    int race_posts;             // POSTs still to lose a race to another device's write
+    int terse;                  // Accepted POSTs answered with the version alone
+    int recv_chunk;             // Most bytes handed out per sl_Recv() (0: all)
+
+    // Observed
+    int gets;
+    ShadowPost posts[FAKE_SHADOW_MAX_POSTS];
+    int post_count;
+    int malformed;              // Requests that didn't parse
+    int releases;
+    int closes;
+    int fails;
+} FakeShadow;
+
+extern FakeShadow fake_shadow;
+extern uint32_t fake_shadow_now;    // Clock handed to awsShadowInit()
+
+void fakeShadowReset(void);
+uint32_t fakeShadowClock(void);
+
+// Another device writes the document: the version goes up (creating it if
+// needed) and score and board replace the stored ones (score -1, board
+// NULL: kept)
+void fakeShadowWrite(long score, const char *board);
+
+// POSTs answered with this status
+int fakeShadowPosts(int status);
+
+#endif /* TESTS_FAKE_SHADOW_H_ */
@@ -0,0 +1,88 @@
+//*****************************************************************************
+// http_parser_bench.c - http_parser throughput over the response corpus
+//
+// Each response in data/ is parsed whole, in 1460-byte reads (one TCP
+// segment) and in 64-byte reads, with a body callback that touches every
+// byte as a consumer would.
+//*****************************************************************************
+
+#include "bench.h"
+
+#include <string.h>
+
+#include "http_parser.h"
+
+#define DATA_DIR        "data/"
+#define MAX_RESPONSE    4096
+#define ITERATIONS      200000L
+
+static const char *const files[] = {
+    "shadow_get_200.http",
+    "shadow_update_409.http",
+    "chunked_trailer.http",
+};
+
+static unsigned long body_sum;
+
+static void onBody(void *user, const char *data, int len) {
+    int i;
+    (void)user;
+    for (i = 0; i < len; i++) {
+        body_sum += (unsigned char)data[i];
+    }
+}
+
+static void run(const char *name, const char *msg, int len, int piece) {
+    char label[64];
+    HttpParser p;
+    double start;
+    long it;
+
+    start = benchNow();
+    for (it = 0; it < ITERATIONS; it++) {
+        int pos = 0;
+        httpParserInit(&p, onBody, NULL);
+        while (pos < len && !p.done) {
+            int n = len - pos < piece ? len - pos : piece;
+            int ret = httpParserFeed(&p, msg + pos, n);
+            if (ret < 0) {
+                printf("%s: parse error %d\n", name, p.error);
+                return;
+            }
+            pos += ret;
+        }
+    }
+    if (piece == len) {
+        snprintf(label, sizeof(label), "%.*s whole", (int)strcspn(name, "."), name);
+    } else {
+        snprintf(label, sizeof(label), "%.*s %d B reads", (int)strcspn(name, "."), name, piece);
+    }
+    benchReport(label, ITERATIONS, (long)len * ITERATIONS, benchNow() - start);
+}
+
+int main(void) {
+    static char msg[MAX_RESPONSE];
+    unsigned int i;
+
+    for (i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        char path[256];
+        FILE *f;
+        int len;
+
+        snprintf(path, sizeof(path), DATA_DIR "%s", files[i]);
+        f = fopen(path, "rb");
+        if (f == NULL) {
+            printf("cannot open %s (run from tests/)\n", path);
+            return 1;
+        }
+        len = (int)fread(msg, 1, sizeof(msg), f);
+        fclose(f);
+
+        run(files[i], msg, len, len);
+        run(files[i], msg, len, 1460);
+        run(files[i], msg, len, 64);
+    }
+    printf("sizeof(HttpParser) = %u bytes\n", (unsigned int)sizeof(HttpParser));
+    bench_sink = (long)body_sum;
+    return 0;
+}
@@ -0,0 +1,325 @@
+//*****************************************************************************
+// http_parser_fuzz.c - Corpus checks and mutation fuzzing of http_parser
+//
+//   http_parser_fuzz [iterations [seed]]      (run from tests/)
+//
+// Every response in data/*.http must parse to its expected result however
+// it is split across reads. Mutated copies must then parse identically fed
+// whole and fed in random pieces, without touching memory out of bounds
+// (run under ASan) and without producing more body than input.
+//*****************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "http_parser.h"
+
+#define DATA_DIR        "data/"
+#define MAX_RESPONSE    4096
+#define MAX_SPLITS      6
+#define DEFAULT_ITERATIONS 20000L
+
+typedef struct {
+    const char *file;
+    int status;
+    long body_len;
+    int keep_alive;
+    int chunked;
+    int until_close;    // Complete only once the connection closes
+} CorpusEntry;
+
+static const CorpusEntry corpus[] = {
+    { "shadow_get_200.http",        200, 335, 1, 0, 0 },
+    { "shadow_update_200.http",     200, 254, 1, 0, 0 },
+    { "shadow_get_404.http",        404, 61,  1, 0, 0 },
+    { "shadow_update_409.http",     409, 60,  1, 0, 0 },
+    { "forbidden_403_close.http",   403, 72,  0, 0, 0 },
+    { "chunked_trailer.http",       200, 335, 1, 1, 0 },
+    { "close_delimited_10.http",    200, 335, 0, 0, 1 },
+    { "continue_then_204.http",     204, 0,   1, 0, 0 },
+};
+#define CORPUS_SIZE ((int)(sizeof(corpus) / sizeof(corpus[0])))
+
+typedef struct {
+    int result;                 // 0 complete, 1 incomplete, -1 error
+    int status;
+    HttpError error;
+    int consumed;               // -1 on error
+    unsigned long body_len;     // As delivered to the callback
+    uint32_t body_hash;
+    unsigned long parser_body_bytes;
+} Outcome;
+
+static char responses[CORPUS_SIZE][MAX_RESPONSE];
+static int response_len[CORPUS_SIZE];
+static uint32_t rng_state;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static void onBody(void *user, const char *data, int len) {
+    Outcome *o = (Outcome *)user;
+    int i;
+
+    for (i = 0; i < len; i++) {
+        o->body_hash = (o->body_hash ^ (unsigned char)data[i]) * 16777619UL;
+    }
+    o->body_len += len;
+}
+
+// Feed msg cut at the sorted offsets in splits[], then close the connection
+// if the response is still open
+static void parse(const char *msg, int len, const int *splits, int nsplits, Outcome *o) {
+    HttpParser p;
+    int pos = 0;
+    int k;
+
+    memset(o, 0, sizeof(*o));
+    o->body_hash = 2166136261UL;
+    httpParserInit(&p, onBody, o);
+    for (k = 0; k <= nsplits && pos < len && !p.done; k++) {
+        int end = k < nsplits ? splits[k] : len;
+        int ret;
+
+        if (end <= pos) {
+            continue;
+        }
+        ret = httpParserFeed(&p, msg + pos, end - pos);
+        if (ret < 0) {
+            o->result = -1;
+            break;
+        }
+        CHECK(ret <= end - pos);
+        CHECK(ret == end - pos || p.done);
+        pos += ret;
+    }
+    if (o->result == 0 && !p.done) {
+        o->result = httpParserFinish(&p) == 0 ? 0 : 1;
+    }
+    o->status = p.status;
+    o->error = p.error;
+    o->consumed = o->result < 0 ? -1 : pos;    // Where an error is caught depends on the split
+    o->parser_body_bytes = p.body_bytes;
+}
+
+static int sameOutcome(const Outcome *a, const Outcome *b) {
+    return a->result == b->result && a->status == b->status && a->error == b->error
+        && a->consumed == b->consumed && a->body_len == b->body_len
+        && a->body_hash == b->body_hash;
+}
+
+static int loadCorpus(void) {
+    int i;
+
+    for (i = 0; i < CORPUS_SIZE; i++) {
+        char path[256];
+        FILE *f;
+
+        snprintf(path, sizeof(path), DATA_DIR "%s", corpus[i].file);
+        f = fopen(path, "rb");
+        if (f == NULL) {
+            printf("cannot open %s (run from tests/)\n", path);
+            return -1;
+        }
+        response_len[i] = (int)fread(responses[i], 1, MAX_RESPONSE, f);
+        fclose(f);
+    }
+    return 0;
+}
+
+static void checkExpected(int i, const Outcome *o, const Outcome *whole) {
+    CHECK_EQ(o->result, 0);
+    CHECK_EQ(o->status, corpus[i].status);
+    CHECK_EQ(o->body_len, corpus[i].body_len);
+    CHECK_EQ(o->consumed, response_len[i]);
+    CHECK(sameOutcome(o, whole));
+}
+
+// The corpus at every single split point, every byte on its own, and a
+// sample of split pairs
+static void testCorpus(void) {
+    HttpParser p;
+    int i, a, b;
+
+    for (i = 0; i < CORPUS_SIZE; i++) {
+        const char *msg = responses[i];
+        int len = response_len[i];
+        Outcome whole, o;
+        static int bytewise[MAX_RESPONSE];
+
+        parse(msg, len, NULL, 0, &whole);
+        checkExpected(i, &whole, &whole);
+        CHECK_EQ(whole.parser_body_bytes, corpus[i].body_len);
+
+        // Framing results
+        httpParserInit(&p, NULL, NULL);
+        httpParserFeed(&p, msg, len);
+        CHECK_EQ(p.keep_alive, corpus[i].keep_alive);
+        CHECK_EQ(p.chunked, corpus[i].chunked);
+        CHECK_EQ(p.done, !corpus[i].until_close);
+
+        for (a = 0; a <= len; a++) {
+            parse(msg, len, &a, 1, &o);
+            checkExpected(i, &o, &whole);
+        }
+        for (a = 0; a < len; a++) {
+            bytewise[a] = a + 1;
+        }
+        parse(msg, len, bytewise, len, &o);
+        checkExpected(i, &o, &whole);
+        for (a = 1; a < len; a += 5) {
+            for (b = a + 1; b < len; b += 11) {
+                int s[2] = {a, b};
+                parse(msg, len, s, 2, &o);
+                checkExpected(i, &o, &whole);
+            }
+        }
+    }
+}
+
+// Any prefix of a sized response is truncated when the connection closes;
+// a pipelined next response is left unconsumed
+static void testTruncateAndPipeline(void) {
+    static char buf[2 * MAX_RESPONSE];
+    int i, cut;
+
+    for (i = 0; i < CORPUS_SIZE; i++) {
+        Outcome o;
+        if (corpus[i].until_close) {
+            continue;
+        }
+        for (cut = 0; cut < response_len[i]; cut++) {
+            parse(responses[i], cut, NULL, 0, &o);
+            CHECK(o.result != 0);
+            CHECK(o.body_len <= (unsigned long)corpus[i].body_len);
+        }
+        memcpy(buf, responses[i], response_len[i]);
+        memcpy(buf + response_len[i], responses[0], response_len[0]);
+        parse(buf, response_len[i] + response_len[0], NULL, 0, &o);
+        CHECK_EQ(o.result, 0);
+        CHECK_EQ(o.consumed, response_len[i]);
+    }
+}
+
+static const char *const tokens[] = {
+    "\r\n", "\r\n\r\n", ":", " ", "0", "9", "f", "-1", "99999999999", "ffffffffff",
+    "content-length: ", "Content-Length: 0\r\n", "transfer-encoding: chunked\r\n",
+    "connection: close\r\n", "HTTP/1.1 ", "HTTP/1.0 100 Continue\r\n\r\n", ";x=y", "\0"
+};
+#define NUM_TOKENS ((int)(sizeof(tokens) / sizeof(tokens[0])))
+
+static int mutate(char *m, int len) {
+    int n = 1 + (int)(rng() % 4);
+
+    while (n-- > 0) {
+        int at = len > 0 ? (int)(rng() % (uint32_t)len) : 0;
+        switch (rng() % 5) {
+        case 0:     // Replace a byte
+            if (len > 0) {
+                m[at] = (char)rng();
+            }
+            break;
+        case 1:     // Flip a bit
+            if (len > 0) {
+                m[at] ^= (char)(1 << (rng() % 8));
+            }
+            break;
+        case 2: {   // Delete a run
+            int run = 1 + (int)(rng() % 8);
+            if (at + run > len) {
+                run = len - at;
+            }
+            memmove(m + at, m + at + run, len - at - run);
+            len -= run;
+            break;
+        }
+        case 3: {   // Insert a token
+            const char *t = tokens[rng() % NUM_TOKENS];
+            int tl = t[0] ? (int)strlen(t) : 1;
+            if (len + tl <= MAX_RESPONSE) {
+                memmove(m + at + tl, m + at, len - at);
+                memcpy(m + at, t, tl);
+                len += tl;
+            }
+            break;
+        }
+        default: {  // Duplicate a slice
+            int run = 1 + (int)(rng() % 64);
+            if (at + run > len) {
+                run = len - at;
+            }
+            if (len + run <= MAX_RESPONSE) {
+                memmove(m + at + run, m + at, len - at);
+                len += run;
+            }
+            break;
+        }
+        }
+    }
+    return len;
+}
+
+static void fuzz(long iterations) {
+    static char m[MAX_RESPONSE];
+    long it, complete = 0, rejected = 0;
+
+    for (it = 0; it < iterations; it++) {
+        int src = (int)(rng() % CORPUS_SIZE);
+        int len, ns, k, j;
+        int s[MAX_SPLITS];
+        Outcome whole, split;
+
+        memcpy(m, responses[src], response_len[src]);
+        len = mutate(m, response_len[src]);
+
+        ns = 1 + (int)(rng() % MAX_SPLITS);
+        for (k = 0; k < ns; k++) {
+            s[k] = (int)(rng() % (uint32_t)(len + 1));
+            for (j = k; j > 0 && s[j] < s[j - 1]; j--) {
+                int t = s[j];
+                s[j] = s[j - 1];
+                s[j - 1] = t;
+            }
+        }
+        parse(m, len, NULL, 0, &whole);
+        parse(m, len, s, ns, &split);
+
+        CHECK(sameOutcome(&whole, &split));
+        CHECK(whole.body_len <= (unsigned long)len);
+        CHECK(whole.consumed <= len);
+        if (whole.result == 0) {
+            CHECK_EQ(whole.parser_body_bytes, whole.body_len);
+            complete++;
+        } else if (whole.result < 0) {
+            CHECK(whole.error != HTTP_ERR_NONE);
+            rejected++;
+        }
+        if (test_failures > 20) {
+            printf("stopping after iteration %ld\n", it);
+            break;
+        }
+    }
+    printf("fuzz: %ld mutations, %ld complete, %ld rejected\n", it, complete, rejected);
+}
+
+int main(int argc, char **argv) {
+    long iterations = argc > 1 ? atol(argv[1]) : DEFAULT_ITERATIONS;
+
+    rng_state = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 0x2545F491UL;
+    if (rng_state == 0) {
+        rng_state = 1;
+    }
+    if (loadCorpus() < 0) {
+        return 1;
+    }
+    testCorpus();
+    testTruncateAndPipeline();
+    fuzz(iterations);
+    return testExitCode("http_parser_fuzz");
+}
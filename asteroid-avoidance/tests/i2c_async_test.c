@@ -0,0 +1,308 @@
+//*****************************************************************************
+// i2c_async_test.c - i2c_async state machine on the fake I2C bus
+//*****************************************************************************
+
+#include <string.h>
+
+#include "test.h"
+#include "fake_i2c_bus.h"
+#include "i2c_async.h"
+#include "accel.h"
+
+#define TIMEOUT_TICKS   1000
+#define OTHER_ADDR      0x19    // Nobody answers here
+
+static int done_calls;
+static I2cAsyncXfer *last_done;
+
+// The polled driver must not be touched by the async paths
+static int polled_calls;
+
+int I2C_IF_Write(unsigned char ucDevAddr, unsigned char *pucData,
+                 unsigned char ucLen, unsigned char ucStop) {
+    (void)ucDevAddr; (void)pucData; (void)ucLen; (void)ucStop;
+    polled_calls++;
+    return -1;
+}
+
+int I2C_IF_ReadFrom(unsigned char ucDevAddr, unsigned char *pucWrDataBuf,
+                    unsigned char ucWrLen, unsigned char *pucRdDataBuf,
+                    unsigned char ucRdLen) {
+    (void)ucDevAddr; (void)pucWrDataBuf; (void)ucWrLen; (void)pucRdDataBuf; (void)ucRdLen;
+    polled_calls++;
+    return -1;
+}
+
+static void onDone(I2cAsyncXfer *xfer) {
+    done_calls++;
+    last_done = xfer;
+}
+
+static void setUp(void) {
+    int i;
+
+    fakeI2cReset(ACCEL_I2C_ADDR);
+    for (i = 0; i < 256; i++) {
+        fake_i2c.regs[i] = (uint8_t)(0xA0 + i);
+    }
+    i2cAsyncInit(&fake_i2c_ops, fakeI2cClock, TIMEOUT_TICKS);
+    i2c_async_errors = 0;
+    i2c_async_timeouts = 0;
+    done_calls = 0;
+    last_done = NULL;
+}
+
+static void readXfer(I2cAsyncXfer *x, uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t len) {
+    memset(x, 0, sizeof(*x));
+    x->addr = addr;
+    x->reg = reg;
+    x->len = len;
+    x->buf = buf;
+    x->done = onDone;
+}
+
+static void writeXfer(I2cAsyncXfer *x, uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t len) {
+    readXfer(x, addr, reg, buf, len);
+    x->write = 1;
+}
+
+// A 6-byte burst advances one byte per interrupt, with main-loop work in
+// between: a second transfer queues behind it and starts on its own
+static void testBurstSplitAcrossInterrupts(void) {
+    static const I2cBusCmd expected[] = {
+        I2C_BUS_SEND_START, I2C_BUS_RECEIVE_START, I2C_BUS_RECEIVE_CONT,
+        I2C_BUS_RECEIVE_CONT, I2C_BUS_RECEIVE_CONT, I2C_BUS_RECEIVE_CONT,
+        I2C_BUS_RECEIVE_FINISH
+    };
+    I2cAsyncXfer burst, cfg;
+    uint8_t buf[6];
+    uint8_t value = 0x5A;
+    int i;
+
+    setUp();
+    memset(buf, 0, sizeof(buf));
+    readXfer(&burst, ACCEL_I2C_ADDR, 0x02, buf, sizeof(buf));
+    CHECK_EQ(i2cAsyncSubmit(&burst), 0);
+    CHECK(!i2cAsyncIdle());
+    CHECK(fake_i2c.irq_enabled);
+
+    for (i = 0; i < 7; i++) {
+        CHECK_EQ(burst.status, I2C_ASYNC_PENDING);
+        CHECK_EQ(done_calls, 0);
+        if (i == 3) {
+            // Mid-burst: a resubmit is refused, another transfer queues
+            CHECK_EQ(i2cAsyncSubmit(&burst), -1);
+            writeXfer(&cfg, ACCEL_I2C_ADDR, 0x20, &value, 1);
+            CHECK_EQ(i2cAsyncSubmit(&cfg), 0);
+        }
+        // Slow interrupts add up past the timeout, but each step restarts it
+        fake_i2c_now += TIMEOUT_TICKS / 2;
+        i2cAsyncPoll();
+        CHECK_EQ(fakeI2cInterrupt(), I2C_BUS_EV_DONE);
+    }
+    CHECK_EQ(burst.status, I2C_ASYNC_OK);
+    CHECK_EQ(done_calls, 1);
+    for (i = 0; i < 6; i++) {
+        CHECK_EQ(buf[i], 0xA2 + i);
+    }
+    CHECK_EQ(fake_i2c.cmd_count, 8);    // The queued write has started
+    for (i = 0; i < 7; i++) {
+        CHECK_EQ(fake_i2c.cmds[i], expected[i]);
+    }
+
+    CHECK_EQ(cfg.status, I2C_ASYNC_PENDING);
+    CHECK_EQ(fakeI2cRun(), 2);
+    CHECK_EQ(cfg.status, I2C_ASYNC_OK);
+    CHECK(last_done == &cfg);
+    CHECK_EQ(fake_i2c.regs[0x20], 0x5A);
+    CHECK_EQ(fake_i2c.cmds[8], I2C_BUS_SEND_FINISH);
+    CHECK(i2cAsyncIdle());
+    CHECK(!fake_i2c.irq_enabled);
+    CHECK_EQ(fake_i2c.misuse, 0);
+}
+
+// The accelerometer's burst through the engine, as the game loop runs it
+static void testAccelBurst(void) {
+    AccelSample s = {0, 0};
+
+    setUp();
+    fake_i2c.regs[ACCEL_REG_Y] = (uint8_t)-12;
+    fake_i2c.regs[ACCEL_REG_X] = 34;
+    CHECK_EQ(accelReadAsyncStart(), 0);
+    CHECK_EQ(accelReadAsyncStart(), -1);
+    CHECK_EQ(accelReadAsyncResult(&s), 0);
+    CHECK_EQ(fakeI2cRun(), 1 + ACCEL_BURST_LEN);
+    CHECK_EQ(accelReadAsyncResult(&s), 1);
+    CHECK_EQ(s.x, 34);
+    CHECK_EQ(s.y, -12);
+    CHECK_EQ(accelReadAsyncResult(&s), 0);
+    CHECK_EQ(polled_calls, 0);
+    CHECK_EQ(fake_i2c.misuse, 0);
+}
+
+// No ACK for the address: the transfer fails with an error stop and the
+// next one in the queue still goes through
+static void testAddressNak(void) {
+    I2cAsyncXfer bad, good;
+    uint8_t buf1[2], buf2[2];
+
+    setUp();
+    readXfer(&bad, OTHER_ADDR, 0x03, buf1, sizeof(buf1));
+    readXfer(&good, ACCEL_I2C_ADDR, 0x03, buf2, sizeof(buf2));
+    CHECK_EQ(i2cAsyncSubmit(&bad), 0);
+    CHECK_EQ(i2cAsyncSubmit(&good), 0);
+
+    CHECK_EQ(fakeI2cInterrupt(), I2C_BUS_EV_ERROR);
+    CHECK_EQ(bad.status, I2C_ASYNC_ERR_NACK);
+    CHECK_EQ(fake_i2c.cmds[1], I2C_BUS_SEND_ERROR_STOP);
+    CHECK_EQ(i2c_async_errors, 1);
+    CHECK_EQ(fake_i2c.recoveries, 0);
+
+    CHECK_EQ(fakeI2cRun(), 3);
+    CHECK_EQ(good.status, I2C_ASYNC_OK);
+    CHECK_EQ(buf2[0], 0xA3);
+    CHECK_EQ(buf2[1], 0xA4);
+    CHECK(i2cAsyncIdle());
+    CHECK_EQ(fake_i2c.misuse, 0);
+}
+
+// NAK on a data byte part way through a write, and on a byte being read
+static void testDataNak(void) {
+    I2cAsyncXfer w, r;
+    uint8_t data[3] = {1, 2, 3};
+    uint8_t buf[4];
+
+    setUp();
+    writeXfer(&w, ACCEL_I2C_ADDR, 0x40, data, sizeof(data));
+    fake_i2c.nak_step = 2;      // Register, first byte, then the second byte
+    CHECK_EQ(i2cAsyncSubmit(&w), 0);
+    CHECK_EQ(fakeI2cRun(), 3);
+    CHECK_EQ(w.status, I2C_ASYNC_ERR_NACK);
+    CHECK_EQ(fake_i2c.cmds[3], I2C_BUS_SEND_ERROR_STOP);
+    CHECK(i2cAsyncIdle());
+
+    readXfer(&r, ACCEL_I2C_ADDR, 0x03, buf, sizeof(buf));
+    fake_i2c.nak_step = fake_i2c.cmd_count + 2;    // Register, RECEIVE_START, then the CONT
+    CHECK_EQ(i2cAsyncSubmit(&r), 0);
+    CHECK_EQ(fakeI2cRun(), 3);
+    CHECK_EQ(r.status, I2C_ASYNC_ERR_NACK);
+    CHECK_EQ(fake_i2c.cmds[fake_i2c.cmd_count - 1], I2C_BUS_RECEIVE_ERROR_STOP);
+    CHECK_EQ(i2c_async_errors, 2);
+    CHECK_EQ(done_calls, 2);
+    CHECK(!fake_i2c.irq_enabled);
+    CHECK_EQ(fake_i2c.misuse, 0);
+}
+
+// A step that never interrupts is caught by the poll-side timeout: the
+// controller is reset and the bus works again afterwards
+static void testTimeoutRecovery(void) {
+    I2cAsyncXfer hung, next;
+    uint8_t buf1[4], buf2[2];
+
+    setUp();
+    readXfer(&hung, ACCEL_I2C_ADDR, 0x03, buf1, sizeof(buf1));
+    readXfer(&next, ACCEL_I2C_ADDR, 0x10, buf2, sizeof(buf2));
+    fake_i2c.hang_step = 2;     // First RECEIVE_CONT
+    CHECK_EQ(i2cAsyncSubmit(&hung), 0);
+    CHECK_EQ(i2cAsyncSubmit(&next), 0);
+    CHECK_EQ(fakeI2cRun(), 2);
+    CHECK_EQ(hung.status, I2C_ASYNC_PENDING);
+
+    fake_i2c_now += TIMEOUT_TICKS;
+    i2cAsyncPoll();
+    CHECK_EQ(hung.status, I2C_ASYNC_PENDING);     // Not past the limit yet
+    fake_i2c_now += 1;
+    i2cAsyncPoll();
+    CHECK_EQ(hung.status, I2C_ASYNC_ERR_TIMEOUT);
+    CHECK_EQ(i2c_async_timeouts, 1);
+    CHECK_EQ(fake_i2c.recoveries, 1);
+    CHECK_EQ(fake_i2c.cmds[3], I2C_BUS_RECEIVE_ERROR_STOP);
+
+    // The queued transfer starts on the recovered controller
+    CHECK_EQ(fakeI2cRun(), 3);
+    CHECK_EQ(next.status, I2C_ASYNC_OK);
+    CHECK_EQ(buf2[0], 0xB0);
+    CHECK_EQ(buf2[1], 0xB1);
+
+    // A late interrupt with nothing queued only masks the bus again
+    i2cAsyncIsr(I2C_BUS_EV_DONE);
+    CHECK(i2cAsyncIdle());
+    CHECK(!fake_i2c.irq_enabled);
+    CHECK_EQ(fake_i2c.lock_depth, 0);
+    CHECK_EQ(fake_i2c.misuse, 0);
+}
+
+// The controller's own clock-low timeout takes the same recovery path
+static void testClockLowTimeout(void) {
+    I2cAsyncXfer w, r;
+    uint8_t value = 7;
+    uint8_t buf[1];
+
+    setUp();
+    writeXfer(&w, ACCEL_I2C_ADDR, 0x30, &value, 1);
+    fake_i2c.timeout_step = 1;
+    CHECK_EQ(i2cAsyncSubmit(&w), 0);
+    CHECK_EQ(fakeI2cRun(), 2);
+    CHECK_EQ(w.status, I2C_ASYNC_ERR_TIMEOUT);
+    CHECK_EQ(fake_i2c.recoveries, 1);
+    CHECK_EQ(i2c_async_timeouts, 1);
+    CHECK_EQ(i2c_async_errors, 0);
+
+    readXfer(&r, ACCEL_I2C_ADDR, 0x03, buf, 1);
+    CHECK_EQ(i2cAsyncSubmit(&r), 0);
+    CHECK_EQ(fakeI2cRun(), 2);
+    CHECK_EQ(fake_i2c.cmds[fake_i2c.cmd_count - 1], I2C_BUS_SINGLE_RECEIVE);
+    CHECK_EQ(r.status, I2C_ASYNC_OK);
+    CHECK_EQ(buf[0], 0xA3);
+    CHECK_EQ(fake_i2c.misuse, 0);
+}
+
+// A done callback may resubmit its own descriptor (continuous sampling);
+// it starts after the callback returns, behind nothing else
+static int resubmits_left;
+
+static void resubmit(I2cAsyncXfer *xfer) {
+    done_calls++;
+    if (resubmits_left-- > 0) {
+        CHECK_EQ(i2cAsyncSubmit(xfer), 0);
+    }
+}
+
+static void testResubmitFromCallback(void) {
+    I2cAsyncXfer x;
+    uint8_t buf[2];
+
+    setUp();
+    readXfer(&x, ACCEL_I2C_ADDR, 0x03, buf, sizeof(buf));
+    x.done = resubmit;
+    resubmits_left = 2;
+    CHECK_EQ(i2cAsyncSubmit(&x), 0);
+    CHECK_EQ(fakeI2cRun(), 3 * 3);
+    CHECK_EQ(done_calls, 3);
+    CHECK_EQ(x.status, I2C_ASYNC_OK);
+    CHECK(i2cAsyncIdle());
+    CHECK_EQ(fake_i2c.misuse, 0);
+}
+
+static void testRejects(void) {
+    I2cAsyncXfer x;
+    uint8_t buf[1];
+
+    setUp();
+    readXfer(&x, ACCEL_I2C_ADDR, 0x03, buf, 0);
+    CHECK_EQ(i2cAsyncSubmit(&x), -1);
+    CHECK(i2cAsyncIdle());
+    CHECK_EQ(fake_i2c.cmd_count, 0);
+}
+
+int main(void) {
+    testBurstSplitAcrossInterrupts();
+    testAccelBurst();
+    testAddressNak();
+    testDataNak();
+    testTimeoutRecovery();
+    testClockLowTimeout();
+    testResubmitFromCallback();
+    testRejects();
+    return testExitCode("i2c_async_test");
+}
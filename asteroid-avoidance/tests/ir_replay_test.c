@@ -0,0 +1,366 @@
+//*****************************************************************************
+// ir_replay_test.c - Edge streams through ir_ring and ir_decoder on the host
+//
+// Builds NEC, SIRC and RC5 edge traces the way the capture ISR timestamps
+// them, pushes them into the ring on a simulated clock and drains it the way
+// processIREdges() in main.c does, at frame-rate and stalled rates.
+//*****************************************************************************
+
+#include <stdint.h>
+#include <string.h>
+
+#include "test.h"
+#include "ir_ring.h"
+#include "ir_decoder.h"
+
+#define TICKS_PER_US        80          // Capture timer runs at the 80 MHz system clock
+#define MAX_EDGES           4096
+#define MAX_EVENTS          64
+#define FRAME_PERIOD_US     22222       // 45 FPS main loop
+#define MARK_STRETCH_US     60          // Demodulating receivers lengthen marks
+#define JITTER_PCT          8
+#define RC5_LONGEST_US      (2 * 889 * 130 / 100)
+
+typedef struct {
+    uint32_t ticks;
+    uint32_t level;
+} TraceEdge;
+
+typedef struct {
+    IrEventType type;
+    IrProtocolId protocol;
+    uint16_t address;
+    uint16_t command;
+    uint32_t ticks;     // Drain that reported it
+} Seen;
+
+// Trace under construction
+static TraceEdge trace[MAX_EDGES];
+static int trace_len;
+static uint32_t trace_time;
+static uint32_t jitter_seed;
+
+// Consumer side, as in main.c
+static IrEdgeRing ring;
+static IrDecoder decoder;
+static uint32_t last_edge_time;
+static uint32_t overflows_seen;
+static uint32_t capture_tick;       // Latest edge offered to the ring
+static unsigned long popped;
+static Seen seen[MAX_EVENTS];
+static int seen_count;
+
+static void traceStart(uint32_t ticks) {
+    trace_len = 0;
+    trace_time = ticks;
+    jitter_seed = 12345;
+}
+
+static uint32_t jitter(uint32_t width_us) {
+    int pct;
+    jitter_seed = jitter_seed * 1103515245UL + 12345;
+    pct = (int)((jitter_seed >> 16) % (2 * JITTER_PCT + 1)) - JITTER_PCT;
+    return (uint32_t)((int)width_us * (100 + pct) / 100);
+}
+
+// One mark or space; the edge that ends it is what the ISR timestamps
+static void pulse(int is_mark, uint32_t width_us) {
+    width_us = jitter(is_mark ? width_us + MARK_STRETCH_US : width_us - MARK_STRETCH_US);
+    trace_time += width_us * TICKS_PER_US;
+    trace[trace_len].ticks = trace_time;
+    trace[trace_len].level = is_mark ? 1 : 0;
+    trace_len++;
+}
+
+// Idle line before the next frame
+static void gap(uint32_t us) {
+    trace_time += us * TICKS_PER_US;
+    trace[trace_len].ticks = trace_time;
+    trace[trace_len].level = 0;
+    trace_len++;
+}
+
+static uint32_t necRaw(uint8_t address, uint8_t command) {
+    return (uint32_t)address << 24 | (uint32_t)(uint8_t)~address << 16
+         | (uint32_t)command << 8 | (uint8_t)~command;
+}
+
+static void necFrame(uint8_t address, uint8_t command) {
+    uint32_t raw = necRaw(address, command);
+    int i;
+
+    pulse(1, 9000);
+    pulse(0, 4500);
+    for (i = 31; i >= 0; i--) {
+        pulse(1, 562);
+        pulse(0, (raw >> i) & 1 ? 1687 : 562);
+    }
+    pulse(1, 562);
+}
+
+static void necRepeat(void) {
+    pulse(1, 9000);
+    pulse(0, 2250);
+    pulse(1, 562);
+}
+
+static void sircFrame(uint8_t address, uint8_t command) {
+    uint32_t raw = (uint32_t)address << 7 | command;
+    int i;
+
+    pulse(1, 2400);
+    for (i = 0; i < 12; i++) {
+        pulse(0, 600);
+        pulse(1, (raw >> i) & 1 ? 1200 : 600);
+    }
+}
+
+// Half-bits merged into pulses. The first start bit's leading space and a
+// final 0 bit's trailing space merge into the idle line, so neither has an
+// edge of its own.
+static void rc5Frame(int toggle, uint8_t address, uint8_t command) {
+    uint32_t raw = 3UL << 12 | (uint32_t)toggle << 11 | (uint32_t)address << 6 | command;
+    int halves[28];
+    int i, run;
+
+    for (i = 0; i < 14; i++) {
+        int bit = (raw >> (13 - i)) & 1;
+        halves[2 * i] = !bit;
+        halves[2 * i + 1] = bit;
+    }
+    for (i = 1; i < 28; i += run) {
+        for (run = 1; i + run < 28 && halves[i + run] == halves[i]; run++) {
+        }
+        if (i + run == 28 && !halves[i]) {
+            break;
+        }
+        pulse(halves[i], 889 * run);
+    }
+}
+
+static void consumerStart(uint32_t ticks) {
+    irRingInit(&ring);
+    irDecoderInit(&decoder);
+    last_edge_time = ticks;
+    overflows_seen = 0;
+    capture_tick = ticks;
+    popped = 0;
+    seen_count = 0;
+}
+
+static void record(IrEventType type, const IrEvent *ev, uint32_t now) {
+    if ((type == IR_EVENT_FRAME || type == IR_EVENT_REPEAT) && seen_count < MAX_EVENTS) {
+        seen[seen_count].type = type;
+        seen[seen_count].protocol = ev->protocol;
+        seen[seen_count].address = ev->address;
+        seen[seen_count].command = ev->command;
+        seen[seen_count].ticks = now;
+        seen_count++;
+    }
+}
+
+// processIREdges() at time now
+static void drain(uint32_t now) {
+    IrEdge edge;
+    IrEvent ev;
+
+    if (ring.overflows != overflows_seen) {
+        overflows_seen = ring.overflows;
+        irDecoderReset(&decoder);
+    }
+    while (irRingPop(&ring, &edge)) {
+        uint32_t width_us = (edge.timestamp - last_edge_time) / TICKS_PER_US;
+        last_edge_time = edge.timestamp;
+        popped++;
+        record(irDecoderFeed(&decoder, edge.level == 1, width_us, &ev), &ev, now);
+    }
+    record(irDecoderIdle(&decoder, (now - capture_tick) / TICKS_PER_US, &ev), &ev, now);
+}
+
+static void capture(const TraceEdge *edge) {
+    capture_tick = edge->ticks;
+    irRingPush(&ring, edge->ticks, edge->level);
+}
+
+// Push the trace on its own timeline, draining every period_us except
+// during [stall_from, stall_from + stall_us), then run on for tail_us
+static void replay(uint32_t start, uint32_t period_us, uint32_t stall_from_us,
+                   uint32_t stall_us, uint32_t tail_us) {
+    uint32_t next = start + period_us * TICKS_PER_US;
+    uint32_t stall_from = start + stall_from_us * TICKS_PER_US;
+    uint32_t end;
+    int i;
+
+    for (i = 0; i < trace_len; i++) {
+        while ((int32_t)(trace[i].ticks - next) >= 0) {
+            if (stall_us == 0 || next - stall_from >= stall_us * TICKS_PER_US) {
+                drain(next);
+            }
+            next += period_us * TICKS_PER_US;
+        }
+        capture(&trace[i]);
+    }
+    end = trace_time + tail_us * TICKS_PER_US;
+    while ((int32_t)(end - next) >= 0) {
+        drain(next);
+        next += period_us * TICKS_PER_US;
+    }
+}
+
+static void checkSeen(int index, IrEventType type, IrProtocolId protocol,
+                      uint16_t address, uint16_t command) {
+    CHECK(index < seen_count);
+    if (index < seen_count) {
+        CHECK_EQ(seen[index].type, type);
+        CHECK_EQ(seen[index].protocol, protocol);
+        CHECK_EQ(seen[index].address, address);
+        CHECK_EQ(seen[index].command, command);
+    }
+}
+
+// All three protocols with held buttons, drained once per game frame.
+// Starts just before the 32-bit timestamp wraps.
+static void testMixedStream(void) {
+    uint32_t start = 0xFFFFFFFFUL - 100000UL * TICKS_PER_US;
+
+    traceStart(start);
+    gap(50000);
+    necFrame(0x20, 0x15);
+    gap(40000);
+    necRepeat();
+    gap(96000);
+    necRepeat();
+    gap(200000);
+    sircFrame(0x01, 0x12);
+    gap(25000);
+    sircFrame(0x01, 0x12);
+    gap(25000);
+    sircFrame(0x01, 0x12);
+    gap(200000);
+    rc5Frame(0, 0x05, 0x21);    // Ends in 1
+    gap(89000);
+    rc5Frame(0, 0x05, 0x21);    // Resent while held
+    gap(200000);
+    rc5Frame(1, 0x05, 0x10);    // Ends in 0, then nothing
+
+    consumerStart(start);
+    replay(start, FRAME_PERIOD_US, 0, 0, 100000);
+
+    CHECK_EQ(seen_count, 9);
+    checkSeen(0, IR_EVENT_FRAME, IR_PROTO_NEC, 0x20, 0x15);
+    checkSeen(1, IR_EVENT_REPEAT, IR_PROTO_NEC, 0x20, 0x15);
+    checkSeen(2, IR_EVENT_REPEAT, IR_PROTO_NEC, 0x20, 0x15);
+    checkSeen(3, IR_EVENT_FRAME, IR_PROTO_SIRC, 0x01, 0x12);
+    checkSeen(4, IR_EVENT_REPEAT, IR_PROTO_SIRC, 0x01, 0x12);
+    checkSeen(5, IR_EVENT_REPEAT, IR_PROTO_SIRC, 0x01, 0x12);
+    checkSeen(6, IR_EVENT_FRAME, IR_PROTO_RC5, 0x05, 0x21);
+    checkSeen(7, IR_EVENT_REPEAT, IR_PROTO_RC5, 0x05, 0x21);
+    checkSeen(8, IR_EVENT_FRAME, IR_PROTO_RC5, 0x05, 0x10);
+    CHECK_EQ(ring.overflows, 0);
+    CHECK_EQ(popped, trace_len);
+}
+
+// An RC5 frame ending in 0 has no closing edge; it must still be reported
+// by the first drain after its trailing space outgrows a double half-bit
+static void testRc5TrailingZero(void) {
+    uint32_t start = 1000;
+    uint32_t due;
+
+    traceStart(start);
+    gap(30000);
+    rc5Frame(0, 0x1F, 0x3E);
+
+    consumerStart(start);
+    replay(start, 1000, 0, 0, 20000);
+
+    CHECK_EQ(seen_count, 1);
+    checkSeen(0, IR_EVENT_FRAME, IR_PROTO_RC5, 0x1F, 0x3E);
+    due = trace_time + (RC5_LONGEST_US + 1000) * TICKS_PER_US;
+    CHECK(seen_count == 1 && (int32_t)(due - seen[0].ticks) >= 0);
+}
+
+// Back-to-back NEC frames with minimal gaps: a drain every 100 ms still
+// keeps up (about 90 edges), with head and tail wrapping during the run
+static void testBackToBack(void) {
+    uint32_t start = 5000;
+    int i;
+
+    traceStart(start);
+    for (i = 0; i < 10; i++) {
+        gap(10000);
+        necFrame(0x20, (uint8_t)(0x40 + i));
+    }
+
+    consumerStart(start);
+    ring.head = ring.tail = 0xFFFFFFFFUL - 40;
+    replay(start, 100000, 0, 0, 50000);
+
+    CHECK_EQ(seen_count, 10);
+    for (i = 0; i < 10; i++) {
+        checkSeen(i, IR_EVENT_FRAME, IR_PROTO_NEC, 0x20, 0x40 + i);
+    }
+    CHECK_EQ(ring.overflows, 0);
+    CHECK(ring.high_water < IR_RING_SIZE);
+    CHECK_EQ(popped, trace_len);
+}
+
+// A stall across three frames (204 edges) overflows the ring by exactly the
+// edges beyond its size. The first frame is intact, the second is cut short
+// and reported as nothing, and decoding recovers with the fourth.
+static void testStall(void) {
+    uint32_t start = 7000;
+    int i;
+
+    traceStart(start);
+    for (i = 0; i < 4; i++) {
+        gap(i < 3 ? 10000 : 50000);     // The loop catches up before the fourth
+        necFrame(0x20, (uint8_t)(0x50 + i));
+    }
+    CHECK_EQ(trace_len, 4 * 68);
+
+    consumerStart(start);
+    replay(start, FRAME_PERIOD_US, 0, (trace[3 * 68 - 1].ticks - start) / TICKS_PER_US + 1, 50000);
+
+    CHECK_EQ(ring.overflows, 3 * 68 - IR_RING_SIZE);
+    CHECK_EQ(ring.high_water, IR_RING_SIZE);
+    CHECK_EQ(popped + ring.overflows, trace_len);
+    CHECK_EQ(seen_count, 2);
+    checkSeen(0, IR_EVENT_FRAME, IR_PROTO_NEC, 0x20, 0x50);
+    checkSeen(1, IR_EVENT_FRAME, IR_PROTO_NEC, 0x20, 0x53);
+}
+
+// Sustained overload (4 FPS): edges are lost but nothing is misdecoded, and
+// every edge is either delivered or counted
+static void testOverload(void) {
+    uint32_t start = 9000;
+    int i, j;
+
+    traceStart(start);
+    for (i = 0; i < 12; i++) {
+        gap(10000);
+        necFrame(0x20, (uint8_t)(0x60 + i));
+    }
+
+    consumerStart(start);
+    replay(start, 250000, 0, 0, 300000);
+
+    CHECK(ring.overflows > 0);
+    CHECK_EQ(popped + ring.overflows, trace_len);
+    CHECK(seen_count > 0 && seen_count < 12);
+    for (i = 0, j = 0; i < seen_count; i++) {
+        // In order, each one a frame that was sent
+        while (j < 12 && seen[i].command != 0x60 + j) {
+            j++;
+        }
+        CHECK(j < 12 && seen[i].type == IR_EVENT_FRAME && seen[i].address == 0x20);
+    }
+}
+
+int main(void) {
+    testMixedStream();
+    testRc5TrailingZero();
+    testBackToBack();
+    testStall();
+    testOverload();
+    return testExitCode("ir_replay_test");
+}
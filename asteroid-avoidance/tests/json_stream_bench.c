@@ -0,0 +1,125 @@
+//*****************************************************************************
+// json_stream_bench.c - json_stream cost over the shadow documents
+//
+// Each document in data/ is run through the MQTT client's eight-field
+// table whole and in 64-byte reads, against the strstr/sscanf "highscore"
+// lookup aws_shadow used before json_stream. The old lookup reads only the
+// first match and is shown for scale, not as an equivalent.
+//*****************************************************************************
+
+#include "bench.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "json_stream.h"
+
+#define DATA_DIR        "data/"
+#define MAX_DOC         1024
+#define ITERATIONS      200000L
+
+static const char *const files[] = {
+    "shadow_get.json",
+    "shadow_update_accepted.json",
+    "shadow_delta.json",
+    "shadow_pretty.json",
+};
+
+static char board[160];
+static char token[24];
+
+static JsonField fields[] = {
+    { "state.desired.highscore", JSON_INT },
+    { "state.reported.highscore", JSON_INT },
+    { "state.highscore", JSON_INT },
+    { "state.desired.leaderboard", JSON_STRING, board, sizeof(board) },
+    { "state.leaderboard", JSON_STRING, board, sizeof(board) },
+    { "version", JSON_INT },
+    { "code", JSON_INT },
+    { "clientToken", JSON_STRING, token, sizeof(token) }
+};
+#define NUM_FIELDS ((int)(sizeof(fields) / sizeof(fields[0])))
+
+// The lookup json_stream replaced
+static int oldParse(const char *doc) {
+    char value[20] = {0};
+    const char *p = strstr(doc, "\"highscore\"");
+
+    if (p == NULL) {
+        return -1;
+    }
+    if (sscanf(p, "\"highscore\"%*[ :]\"%19[^\"]\"", value) == 1) {
+        return atoi(value);
+    }
+    return -1;
+}
+
+static void runStream(const char *name, const char *doc, int len, int piece) {
+    char label[64];
+    JsonStream js;
+    double start;
+    long it, sum = 0;
+
+    start = benchNow();
+    for (it = 0; it < ITERATIONS; it++) {
+        int pos;
+        jsonStreamInit(&js, fields, NUM_FIELDS);
+        for (pos = 0; pos < len; pos += piece) {
+            jsonStreamFeed(&js, doc + pos, len - pos < piece ? len - pos : piece);
+        }
+        if (jsonStreamFinish(&js) < 0) {
+            printf("%s: parse error %d\n", name, js.error);
+            return;
+        }
+        sum += fields[5].num;
+    }
+    if (piece == len) {
+        snprintf(label, sizeof(label), "%.*s whole", (int)strcspn(name, "."), name);
+    } else {
+        snprintf(label, sizeof(label), "%.*s %d B reads", (int)strcspn(name, "."), name, piece);
+    }
+    benchReport(label, ITERATIONS, (long)len * ITERATIONS, benchNow() - start);
+    bench_sink += sum;
+}
+
+static void runOld(const char *name, const char *doc, int len) {
+    char label[64];
+    double start;
+    long it, sum = 0;
+
+    start = benchNow();
+    for (it = 0; it < ITERATIONS; it++) {
+        sum += oldParse(doc);
+    }
+    snprintf(label, sizeof(label), "%.*s old lookup", (int)strcspn(name, "."), name);
+    benchReport(label, ITERATIONS, (long)len * ITERATIONS, benchNow() - start);
+    printf("  old lookup highscore = %d\n", oldParse(doc));
+    bench_sink += sum;
+}
+
+int main(void) {
+    static char doc[MAX_DOC + 1];
+    unsigned int i;
+
+    for (i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        char path[256];
+        FILE *f;
+        int len;
+
+        snprintf(path, sizeof(path), DATA_DIR "%s", files[i]);
+        f = fopen(path, "rb");
+        if (f == NULL) {
+            printf("cannot open %s (run from tests/)\n", path);
+            return 1;
+        }
+        len = (int)fread(doc, 1, MAX_DOC, f);
+        fclose(f);
+        doc[len] = '\0';
+
+        runStream(files[i], doc, len, len);
+        runStream(files[i], doc, len, 64);
+        runOld(files[i], doc, len);
+    }
+    printf("sizeof(JsonStream) = %u bytes\n", (unsigned int)sizeof(JsonStream));
+    return 0;
+}
@@ -0,0 +1,372 @@
+//*****************************************************************************
+// json_stream_fuzz.c - Shadow document checks and mutation fuzzing of
+//                      json_stream
+//
+//   json_stream_fuzz [iterations [seed]]      (run from tests/)
+//
+// Every document in data/shadow_*.json must yield its expected fields with
+// the MQTT client's field table however it is split across reads. Mutated
+// copies must then give the same result fed whole and fed in random
+// pieces, without touching memory out of bounds (run under ASan) and
+// without overrunning a string field.
+//*****************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "json_stream.h"
+#include "leaderboard.h"
+
+#define DATA_DIR        "data/"
+#define MAX_DOC         1024
+#define MAX_SPLITS      6
+#define DEFAULT_ITERATIONS 20000L
+#define BOARD_SIZE      (LEADERBOARD_TEXT_SIZE + 1)
+#define TOKEN_SIZE      24
+
+// aws_shadow.c's MQTT table, with a buffer per string field
+enum {
+    F_DESIRED, F_REPORTED, F_DELTA, F_DESIRED_BOARD, F_DELTA_BOARD, F_VERSION, F_CODE,
+    F_TOKEN, NUM_FIELDS
+};
+
+typedef struct {
+    const char *file;
+    const char *values[NUM_FIELDS];     // Expected text of each field; NULL if absent
+} DocEntry;
+
+static const DocEntry docs[] = {
+    { "shadow_get.json",
+      { "1250", "1200", NULL, "ACE:1250:1792231200;BOB:980:1792144800;CAT:410:1792058400",
+        NULL, "42", NULL, NULL } },
+    // Metadata ahead of state, as AWS sometimes orders an update reply
+    { "shadow_update_accepted.json",
+      { "1300", NULL, NULL,
+        "ACE:1300:1792231300;ACE:1250:1792231200;BOB:980:1792144800;CAT:410:1792058400",
+        NULL, "43", NULL, "cc3200-7" } },
+    { "shadow_delta.json",
+      { NULL, NULL, "1500", NULL, "DAN:1500:1792231390;ACE:1300:1792231300", "44", NULL,
+        NULL } },
+    { "shadow_rejected.json",
+      { NULL, NULL, NULL, NULL, NULL, NULL, "409", "cc3200-8" } },
+    // Pretty printed, numeric values, escapes, and a same-named key in an
+    // array. Only the integer part of 7.5e3 is kept.
+    { "shadow_pretty.json",
+      { "7", "99", NULL, NULL, NULL, "3", NULL, NULL } },
+};
+#define NUM_DOCS ((int)(sizeof(docs) / sizeof(docs[0])))
+
+typedef struct {
+    int result;                 // 0 complete, 1 truncated, -1 error
+    JsonError error;
+    uint8_t found[NUM_FIELDS];
+    long num[NUM_FIELDS];
+    char board[BOARD_SIZE];
+    char delta_board[BOARD_SIZE];
+    char token[TOKEN_SIZE];
+} Outcome;
+
+static char texts[NUM_DOCS][MAX_DOC];
+static int text_len[NUM_DOCS];
+static uint32_t rng_state;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// Feed doc cut at the sorted offsets in splits[]; str_size limits the
+// string fields
+static void parse(const char *doc, int len, const int *splits, int nsplits, int str_size,
+                  Outcome *o) {
+    JsonField fields[NUM_FIELDS] = {
+        { "state.desired.highscore", JSON_INT },
+        { "state.reported.highscore", JSON_INT },
+        { "state.highscore", JSON_INT },
+        { "state.desired.leaderboard", JSON_STRING },
+        { "state.leaderboard", JSON_STRING },
+        { "version", JSON_INT },
+        { "code", JSON_INT },
+        { "clientToken", JSON_STRING }
+    };
+    JsonStream js;
+    int pos = 0;
+    int k, i;
+
+    memset(o, 0, sizeof(*o));
+    fields[F_DESIRED_BOARD].str = o->board;
+    fields[F_DESIRED_BOARD].str_size = (uint8_t)(str_size < BOARD_SIZE ? str_size : BOARD_SIZE);
+    fields[F_DELTA_BOARD].str = o->delta_board;
+    fields[F_DELTA_BOARD].str_size = fields[F_DESIRED_BOARD].str_size;
+    fields[F_TOKEN].str = o->token;
+    fields[F_TOKEN].str_size = (uint8_t)(str_size < TOKEN_SIZE ? str_size : TOKEN_SIZE);
+
+    jsonStreamInit(&js, fields, NUM_FIELDS);
+    for (k = 0; k <= nsplits; k++) {
+        int end = k < nsplits ? splits[k] : len;
+        if (end <= pos) {
+            continue;
+        }
+        if (jsonStreamFeed(&js, doc + pos, end - pos) < 0) {
+            o->result = -1;
+            break;
+        }
+        pos = end;
+    }
+    if (o->result == 0 && jsonStreamFinish(&js) < 0) {
+        o->result = js.error == JSON_ERR_TRUNCATED ? 1 : -1;
+    }
+    o->error = js.error;
+    for (i = 0; i < NUM_FIELDS; i++) {
+        o->found[i] = fields[i].found;
+        o->num[i] = fields[i].type == JSON_INT ? fields[i].num : 0;
+    }
+}
+
+static int sameOutcome(const Outcome *a, const Outcome *b) {
+    return memcmp(a, b, sizeof(*a)) == 0;
+}
+
+static int loadDocs(void) {
+    int i;
+
+    for (i = 0; i < NUM_DOCS; i++) {
+        char path[256];
+        FILE *f;
+
+        snprintf(path, sizeof(path), DATA_DIR "%s", docs[i].file);
+        f = fopen(path, "rb");
+        if (f == NULL) {
+            printf("cannot open %s (run from tests/)\n", path);
+            return -1;
+        }
+        text_len[i] = (int)fread(texts[i], 1, MAX_DOC, f);
+        fclose(f);
+    }
+    return 0;
+}
+
+static void checkExpected(int d, const Outcome *o, const Outcome *whole) {
+    int i;
+
+    CHECK_EQ(o->result, 0);
+    for (i = 0; i < NUM_FIELDS; i++) {
+        const char *want = docs[d].values[i];
+        CHECK_EQ(o->found[i], want != NULL);
+        if (want == NULL) {
+            continue;
+        }
+        switch (i) {
+        case F_DESIRED_BOARD:
+            CHECK(strcmp(o->board, want) == 0);
+            break;
+        case F_DELTA_BOARD:
+            CHECK(strcmp(o->delta_board, want) == 0);
+            break;
+        case F_TOKEN:
+            CHECK(strcmp(o->token, want) == 0);
+            break;
+        default:
+            CHECK_EQ(o->num[i], atol(want));
+            break;
+        }
+    }
+    CHECK(sameOutcome(o, whole));
+}
+
+// The documents at every single split point, every byte on its own, and a
+// sample of split pairs
+static void testDocs(void) {
+    int d, a, b;
+
+    for (d = 0; d < NUM_DOCS; d++) {
+        const char *doc = texts[d];
+        int len = text_len[d];
+        static int bytewise[MAX_DOC];
+        Outcome whole, o;
+
+        parse(doc, len, NULL, 0, 255, &whole);
+        checkExpected(d, &whole, &whole);
+        for (a = 0; a <= len; a++) {
+            parse(doc, len, &a, 1, 255, &o);
+            checkExpected(d, &o, &whole);
+        }
+        for (a = 0; a < len; a++) {
+            bytewise[a] = a + 1;
+        }
+        parse(doc, len, bytewise, len, 255, &o);
+        checkExpected(d, &o, &whole);
+        for (a = 1; a < len; a += 5) {
+            for (b = a + 1; b < len; b += 11) {
+                int s[2] = {a, b};
+                parse(doc, len, s, 2, 255, &o);
+                checkExpected(d, &o, &whole);
+            }
+        }
+    }
+}
+
+// Strings are cut to fit their buffer, still terminated and still found
+static void testTruncatedString(void) {
+    Outcome o;
+
+    parse(texts[0], text_len[0], NULL, 0, 8, &o);
+    CHECK_EQ(o.result, 0);
+    CHECK_EQ(o.found[F_DESIRED_BOARD], 1);
+    CHECK(strcmp(o.board, "ACE:125") == 0);
+    CHECK_EQ(o.num[F_DESIRED], 1250);
+}
+
+// Any prefix of a document is truncated; broken syntax and deep nesting
+// are rejected
+static void testMalformed(void) {
+    static const char *const bad[] = {
+        "{\"a\":}", "{\"a\" 1}", "{\"a\":tru}", "{\"a\":\"\x01\"}", "{} x", "{\"a\":-}",
+        "{\"a\":1,}", "{\"a\":[1,]}", "{\"a\":\"\\q\"}", "{'a':1}"
+    };
+    char deep[JSON_MAX_DEPTH + 2];
+    Outcome o;
+    int d, cut;
+    unsigned int i;
+
+    for (d = 0; d < NUM_DOCS; d++) {
+        // Stop short of the trailing newline, after which the document is whole
+        for (cut = 0; cut < text_len[d] - 1; cut++) {
+            parse(texts[d], cut, NULL, 0, 255, &o);
+            CHECK(o.result != 0);
+        }
+    }
+    for (i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        parse(bad[i], (int)strlen(bad[i]), NULL, 0, 255, &o);
+        CHECK_EQ(o.result, -1);
+        CHECK_EQ(o.error, JSON_ERR_SYNTAX);
+    }
+
+    memset(deep, '[', sizeof(deep));
+    parse(deep, JSON_MAX_DEPTH, NULL, 0, 255, &o);
+    CHECK_EQ(o.result, 1);
+    parse(deep, JSON_MAX_DEPTH + 1, NULL, 0, 255, &o);
+    CHECK_EQ(o.result, -1);
+    CHECK_EQ(o.error, JSON_ERR_DEPTH);
+}
+
+static const char *const tokens[] = {
+    "{", "}", "[", "]", "\"", ",", ":", "0", "-", ".", "e", "\\", "\\u00", "true", "null",
+    "\"highscore\":", "\"state\":{", "\"version\":", "\0"
+};
+#define NUM_TOKENS ((int)(sizeof(tokens) / sizeof(tokens[0])))
+
+static int mutate(char *m, int len) {
+    int n = 1 + (int)(rng() % 4);
+
+    while (n-- > 0) {
+        int at = len > 0 ? (int)(rng() % (uint32_t)len) : 0;
+        switch (rng() % 5) {
+        case 0:     // Replace a byte
+            if (len > 0) {
+                m[at] = (char)rng();
+            }
+            break;
+        case 1:     // Flip a bit
+            if (len > 0) {
+                m[at] ^= (char)(1 << (rng() % 8));
+            }
+            break;
+        case 2: {   // Delete a run
+            int run = 1 + (int)(rng() % 8);
+            if (at + run > len) {
+                run = len - at;
+            }
+            memmove(m + at, m + at + run, len - at - run);
+            len -= run;
+            break;
+        }
+        case 3: {   // Insert a token
+            const char *t = tokens[rng() % NUM_TOKENS];
+            int tl = t[0] ? (int)strlen(t) : 1;
+            if (len + tl <= MAX_DOC) {
+                memmove(m + at + tl, m + at, len - at);
+                memcpy(m + at, t, tl);
+                len += tl;
+            }
+            break;
+        }
+        default: {  // Duplicate a slice
+            int run = 1 + (int)(rng() % 64);
+            if (at + run > len) {
+                run = len - at;
+            }
+            if (len + run <= MAX_DOC) {
+                memmove(m + at + run, m + at, len - at);
+                len += run;
+            }
+            break;
+        }
+        }
+    }
+    return len;
+}
+
+static void fuzz(long iterations) {
+    static char m[MAX_DOC];
+    long it, complete = 0, rejected = 0;
+
+    for (it = 0; it < iterations; it++) {
+        int src = (int)(rng() % NUM_DOCS);
+        int str_size = 1 + (int)(rng() % 32);
+        int len, ns, k, j;
+        int s[MAX_SPLITS];
+        Outcome whole, split;
+
+        memcpy(m, texts[src], text_len[src]);
+        len = mutate(m, text_len[src]);
+
+        ns = 1 + (int)(rng() % MAX_SPLITS);
+        for (k = 0; k < ns; k++) {
+            s[k] = (int)(rng() % (uint32_t)(len + 1));
+            for (j = k; j > 0 && s[j] < s[j - 1]; j--) {
+                int t = s[j];
+                s[j] = s[j - 1];
+                s[j - 1] = t;
+            }
+        }
+        parse(m, len, NULL, 0, str_size, &whole);
+        parse(m, len, s, ns, str_size, &split);
+
+        CHECK(sameOutcome(&whole, &split));
+        CHECK(strlen(whole.board) < (size_t)str_size);
+        CHECK(strlen(whole.token) < (size_t)str_size);
+        if (whole.result == 0) {
+            complete++;
+        } else if (whole.result < 0) {
+            CHECK(whole.error != JSON_ERR_NONE);
+            rejected++;
+        }
+        if (test_failures > 20) {
+            printf("stopping after iteration %ld\n", it);
+            break;
+        }
+    }
+    printf("fuzz: %ld mutations, %ld complete, %ld rejected\n", it, complete, rejected);
+}
+
+int main(int argc, char **argv) {
+    long iterations = argc > 1 ? atol(argv[1]) : DEFAULT_ITERATIONS;
+
+    rng_state = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 0x9E3779B9UL;
+    if (rng_state == 0) {
+        rng_state = 1;
+    }
+    if (loadDocs() < 0) {
+        return 1;
+    }
+    testDocs();
+    testTruncatedString();
+    testMalformed();
+    fuzz(iterations);
+    return testExitCode("json_stream_fuzz");
+}
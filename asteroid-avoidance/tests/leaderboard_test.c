@@ -0,0 +1,244 @@
+//*****************************************************************************
+// leaderboard_test.c - Ordering, merging and the text codec of leaderboard
+//*****************************************************************************
+
+#include <string.h>
+
+#include "test.h"
+#include "leaderboard.h"
+
+static LeaderboardEntry entry(const char *initials, uint32_t score, uint32_t time) {
+    LeaderboardEntry e;
+    memset(&e, 0, sizeof(e));
+    strcpy(e.initials, initials);
+    e.score = score;
+    e.time = time;
+    return e;
+}
+
+static int sameEntry(const LeaderboardEntry *a, const char *initials, uint32_t score,
+                     uint32_t time) {
+    return strcmp(a->initials, initials) == 0 && a->score == score && a->time == time;
+}
+
+// Slots past count are never read, so only the live entries are compared
+static int sameBoard(const Leaderboard *a, const Leaderboard *b) {
+    int i;
+
+    if (a->count != b->count) {
+        return 0;
+    }
+    for (i = 0; i < a->count; i++) {
+        if (!sameEntry(&a->entries[i], b->entries[i].initials, b->entries[i].score,
+                       b->entries[i].time)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Best first, whatever the insert order; ties go to the earlier time, then
+// initials, so every device sorts them alike
+static void testOrdering(void) {
+    Leaderboard lb;
+    LeaderboardEntry e;
+
+    leaderboardClear(&lb);
+    e = entry("BOB", 500, 20);
+    CHECK_EQ(leaderboardInsert(&lb, &e), 0);
+    e = entry("ACE", 900, 30);
+    CHECK_EQ(leaderboardInsert(&lb, &e), 0);
+    e = entry("CAT", 500, 10);              // Same score, earlier
+    CHECK_EQ(leaderboardInsert(&lb, &e), 1);
+    e = entry("AAA", 500, 20);              // Same score and time: initials
+    CHECK_EQ(leaderboardInsert(&lb, &e), 2);
+    e = entry("ZED", 1, 0);
+    CHECK_EQ(leaderboardInsert(&lb, &e), 4);
+
+    CHECK_EQ(lb.count, 5);
+    CHECK(sameEntry(&lb.entries[0], "ACE", 900, 30));
+    CHECK(sameEntry(&lb.entries[1], "CAT", 500, 10));
+    CHECK(sameEntry(&lb.entries[2], "AAA", 500, 20));
+    CHECK(sameEntry(&lb.entries[3], "BOB", 500, 20));
+    CHECK(sameEntry(&lb.entries[4], "ZED", 1, 0));
+
+    // An identical entry is found, not added again
+    e = entry("BOB", 500, 20);
+    CHECK_EQ(leaderboardFind(&lb, &e), 3);
+    CHECK_EQ(leaderboardInsert(&lb, &e), 3);
+    CHECK_EQ(lb.count, 5);
+    e = entry("BOB", 500, 21);
+    CHECK_EQ(leaderboardFind(&lb, &e), -1);
+
+    leaderboardRemove(&lb, 0);
+    leaderboardRemove(&lb, 9);              // Out of range: ignored
+    CHECK_EQ(lb.count, 4);
+    CHECK(sameEntry(&lb.entries[0], "CAT", 500, 10));
+}
+
+// A full table drops its last entry for a better one and refuses worse ones
+static void testFullTable(void) {
+    Leaderboard lb;
+    LeaderboardEntry e;
+    int i;
+
+    leaderboardClear(&lb);
+    for (i = 0; i < LEADERBOARD_SIZE; i++) {
+        e = entry("P", (uint32_t)(100 * (i + 1)), 0);
+        leaderboardInsert(&lb, &e);
+    }
+    CHECK_EQ(lb.count, LEADERBOARD_SIZE);
+    CHECK_EQ(lb.entries[LEADERBOARD_SIZE - 1].score, 100);
+
+    e = entry("LOW", 50, 0);
+    CHECK_EQ(leaderboardRank(&lb, &e), -1);
+    CHECK_EQ(leaderboardInsert(&lb, &e), -1);
+    e = entry("TIE", 100, 1);               // Same score as the last, later
+    CHECK_EQ(leaderboardInsert(&lb, &e), -1);
+    e = entry("TIE", 100, 0);               // Same score and time, initials after "P"
+    CHECK_EQ(leaderboardRank(&lb, &e), -1);
+    e = entry("AAA", 100, 0);               // ...and before it
+    CHECK_EQ(leaderboardRank(&lb, &e), LEADERBOARD_SIZE - 1);
+
+    e = entry("TOP", 10000, 0);
+    CHECK_EQ(leaderboardRank(&lb, &e), 0);
+    CHECK_EQ(leaderboardInsert(&lb, &e), 0);
+    CHECK_EQ(lb.count, LEADERBOARD_SIZE);
+    CHECK(sameEntry(&lb.entries[0], "TOP", 10000, 0));
+    CHECK_EQ(lb.entries[LEADERBOARD_SIZE - 1].score, 200);
+}
+
+// Merging is order independent and never duplicates an entry both hold
+static void testMerge(void) {
+    Leaderboard a, b, ab, ba;
+    LeaderboardEntry e;
+    int i;
+
+    leaderboardClear(&a);
+    leaderboardClear(&b);
+    for (i = 0; i < 6; i++) {
+        e = entry("AAA", (uint32_t)(1000 - 70 * i), (uint32_t)i);
+        leaderboardInsert(&a, &e);
+        e = entry("BBB", (uint32_t)(980 - 70 * i), (uint32_t)i);
+        leaderboardInsert(&b, &e);
+    }
+    e = entry("ACE", 500, 7);               // In both
+    leaderboardInsert(&a, &e);
+    leaderboardInsert(&b, &e);
+
+    ab = a;
+    leaderboardMerge(&ab, &b);
+    ba = b;
+    leaderboardMerge(&ba, &a);
+    CHECK_EQ(ab.count, LEADERBOARD_SIZE);
+    CHECK(sameBoard(&ab, &ba));
+    for (i = 1; i < ab.count; i++) {
+        CHECK(ab.entries[i - 1].score >= ab.entries[i].score);
+        CHECK(leaderboardFind(&ab, &ab.entries[i]) == i);
+    }
+    CHECK(sameEntry(&ab.entries[0], "AAA", 1000, 0));
+    CHECK(sameEntry(&ab.entries[1], "BBB", 980, 0));
+
+    // Merging a table into itself changes nothing
+    ba = ab;
+    leaderboardMerge(&ba, &ab);
+    CHECK(sameBoard(&ab, &ba));
+}
+
+static void testCodecRoundTrip(void) {
+    char text[LEADERBOARD_TEXT_SIZE];
+    Leaderboard lb, back;
+    LeaderboardEntry e;
+    int i, len;
+
+    leaderboardClear(&lb);
+    CHECK_EQ(leaderboardEncode(&lb, text, sizeof(text)), 0);
+    CHECK_EQ(text[0], '\0');
+    CHECK_EQ(leaderboardDecode(&back, ""), 0);
+    CHECK_EQ(back.count, 0);
+
+    e = entry("ACE", 1250, 1792231200UL);
+    leaderboardInsert(&lb, &e);
+    e = entry("B0B", 0, 0);
+    leaderboardInsert(&lb, &e);
+    e = entry("C", 980, 1792144800UL);
+    leaderboardInsert(&lb, &e);
+    CHECK_EQ(leaderboardEncode(&lb, text, sizeof(text)), (int)strlen(text));
+    CHECK(strcmp(text, "ACE:1250:1792231200;C:980:1792144800;B0B:0:0") == 0);
+    CHECK_EQ(leaderboardDecode(&back, text), 0);
+    CHECK(sameBoard(&back, &lb));
+
+    // The longest table fits LEADERBOARD_TEXT_SIZE exactly
+    leaderboardClear(&lb);
+    for (i = 0; i < LEADERBOARD_SIZE; i++) {
+        e = entry("ZZZ", 0xFFFFFFFFUL - (uint32_t)i, 0xFFFFFFFFUL);
+        leaderboardInsert(&lb, &e);
+    }
+    len = leaderboardEncode(&lb, text, sizeof(text));
+    CHECK_EQ(len, LEADERBOARD_TEXT_SIZE - 2);
+    CHECK_EQ(leaderboardDecode(&back, text), 0);
+    CHECK(sameBoard(&back, &lb));
+
+    // One byte short of the text and terminator fails without overrunning
+    memset(text, '#', sizeof(text));
+    CHECK_EQ(leaderboardEncode(&lb, text, len), -1);
+    CHECK_EQ(text[len], '#');
+    CHECK_EQ(leaderboardEncode(&lb, text, len + 1), len);
+    CHECK_EQ(leaderboardEncode(&lb, text, 0), -1);
+}
+
+// Another device's table is re-sorted and capped, and anything malformed is
+// rejected with the table left as it was
+static void testDecodeUntrusted(void) {
+    static const char *const bad[] = {
+        ":1:2",                 // No initials
+        "ABCD:1:2",             // Too long
+        "ab:1:2",               // Lower case
+        "A-B:1:2",
+        "A:1",
+        "A::2",
+        "A:1:",
+        "A:-1:2",
+        "A:1:2:3",
+        "A:4294967296:2",       // Over 32 bits
+        "A:1:99999999999",
+        "A:1:2;;B:3:4",
+        "A:1:2,B:3:4",
+        "A:1:2 ",
+        "A 1 2",
+    };
+    Leaderboard lb;
+    unsigned int i;
+
+    CHECK_EQ(leaderboardDecode(&lb, "LOW:5:1;TOP:50:1;MID:20:1"), 0);
+    CHECK_EQ(lb.count, 3);
+    CHECK(sameEntry(&lb.entries[0], "TOP", 50, 1));
+    CHECK(sameEntry(&lb.entries[2], "LOW", 5, 1));
+
+    CHECK_EQ(leaderboardDecode(&lb, "A:4294967295:4294967295"), 0);
+    CHECK_EQ(lb.entries[0].score, 0xFFFFFFFFUL);
+
+    CHECK_EQ(leaderboardDecode(&lb, "A:1:1;B:2:1;C:3:1;D:4:1;E:5:1;F:6:1;G:7:1;H:8:1;I:9:1;J:10:1"), 0);
+    CHECK_EQ(lb.count, LEADERBOARD_SIZE);
+    CHECK(sameEntry(&lb.entries[0], "J", 10, 1));
+    CHECK(sameEntry(&lb.entries[LEADERBOARD_SIZE - 1], "C", 3, 1));
+
+    // Duplicates collapse
+    CHECK_EQ(leaderboardDecode(&lb, "A:1:1;A:1:1"), 0);
+    CHECK_EQ(lb.count, 1);
+
+    for (i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        CHECK_EQ(leaderboardDecode(&lb, bad[i]), -1);
+        CHECK_EQ(lb.count, 1);
+        CHECK(sameEntry(&lb.entries[0], "A", 1, 1));
+    }
+}
+
+int main(void) {
+    testOrdering();
+    testFullTable();
+    testMerge();
+    testCodecRoundTrip();
+    testDecodeUntrusted();
+    return testExitCode("leaderboard_test");
+}
@@ -0,0 +1,418 @@
+//*****************************************************************************
+// mqtt_client_test.c - mqtt_client session, QoS 1 and timeouts against the
+//                      fake broker
+//*****************************************************************************
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "fake_broker.h"
+#include "mqtt_client.h"
+#include "log.h"
+
+#define TIMEOUT_TICKS   500
+#define CLIENT_ID       "cc3200-test"
+#define MAX_POLLS       200
+
+static const char *const subs[] = {
+    "$aws/things/t/shadow/get/accepted",
+    "$aws/things/t/shadow/update/delta",
+};
+
+volatile uint8_t log_level_mask = LOG_MASK(LOG_LEVEL_ERROR) | LOG_MASK(LOG_LEVEL_WARN);
+
+static int reports;
+static int connected_calls;
+static int published_calls;
+static int message_sub;
+static long message_len;
+static char message[256];
+static int message_got;
+static int message_ends;
+
+int Report(const char *pcFormat, ...) {
+    (void)pcFormat;
+    reports++;
+    return 0;
+}
+
+static void onConnected(void) {
+    connected_calls++;
+}
+
+static void onMessageStart(int sub, long len) {
+    message_sub = sub;
+    message_len = len;
+    message_got = 0;
+}
+
+static void onMessageData(const char *data, int len) {
+    if (message_got + len < (int)sizeof(message)) {
+        memcpy(message + message_got, data, len);
+        message[message_got + len] = '\0';
+    }
+    message_got += len;
+}
+
+static void onMessageEnd(void) {
+    message_ends++;
+}
+
+static void onPublished(void) {
+    published_calls++;
+}
+
+static const MqttHandlers handlers = {
+    onConnected, onMessageStart, onMessageData, onMessageEnd, onPublished
+};
+
+static void setUp(void) {
+    fakeBrokerReset();
+    mqttInit(&fake_broker_ops, CLIENT_ID, subs, 2, &handlers, fakeBrokerClock, TIMEOUT_TICKS);
+    reports = 0;
+    connected_calls = 0;
+    published_calls = 0;
+    message_sub = -1;
+    message_len = -1;
+    message_got = 0;
+    message_ends = 0;
+}
+
+// Polls until subscribed; how many it took, or -1
+static int pollUntilReady(void) {
+    int i;
+    for (i = 1; i <= MAX_POLLS; i++) {
+        mqttPoll();
+        if (mqttReady()) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void pollTimes(int n) {
+    while (n-- > 0) {
+        mqttPoll();
+    }
+}
+
+static void checkSession(int connections) {
+    const BrokerPacket *connect = fakeBrokerLast(BROKER_CONNECT);
+    const BrokerPacket *subscribe = fakeBrokerLast(BROKER_SUBSCRIBE);
+
+    CHECK(connect != NULL && strcmp(connect->text, CLIENT_ID) == 0);
+    CHECK(subscribe != NULL && subscribe->topics == 2);
+    CHECK(subscribe != NULL && strcmp(subscribe->text, subs[0]) == 0);
+    CHECK_EQ(fake_broker.connections, connections);
+    CHECK_EQ(fakeBrokerCount(BROKER_CONNECT), connections);
+    CHECK_EQ(fakeBrokerCount(BROKER_SUBSCRIBE), connections);
+    CHECK_EQ(fake_broker.malformed, 0);
+}
+
+// CONNECT, CONNACK, SUBSCRIBE, SUBACK: one packet each way per poll
+static void testConnectSubscribe(void) {
+    MqttStats stats;
+
+    setUp();
+    fake_broker.online = 0;
+    pollTimes(3);
+    CHECK(!mqttReady());
+    CHECK_EQ(fake_broker.packets, 0);
+
+    fake_broker.online = 1;
+    CHECK_EQ(pollUntilReady(), 2);
+    checkSession(1);
+    CHECK_EQ(connected_calls, 1);
+    CHECK(fake_broker.log[0].type == BROKER_CONNECT);
+    CHECK(fake_broker.log[1].type == BROKER_SUBSCRIBE);
+    mqttGetStats(&stats);
+    CHECK_EQ(stats.sessions, 1);
+    CHECK_EQ(stats.errors, 0);
+    CHECK(fake_broker.releases >= 1);
+}
+
+// The same handshake with every send cut to 3 bytes and every read to 1
+static void testConnectPartialIo(void) {
+    setUp();
+    fake_broker.send_chunk = 3;
+    fake_broker.recv_chunk = 1;
+    CHECK(pollUntilReady() > 2);
+    checkSession(1);
+    CHECK_EQ(connected_calls, 1);
+}
+
+// A refused CONNACK and a CONNACK that never comes both drop the connection
+static void testConnectRefusedAndTimeout(void) {
+    MqttStats stats;
+
+    setUp();
+    fake_broker.connack_code = 5;           // Not authorized
+    mqttPoll();
+    CHECK(!mqttReady());
+    CHECK_EQ(fake_broker.fails, 1);
+    CHECK_EQ(fake_broker.last_fail, 5);
+
+    setUp();
+    fake_broker.answer_connect = 0;
+    pollTimes(2);
+    fake_broker_now = TIMEOUT_TICKS;
+    mqttPoll();
+    CHECK_EQ(fake_broker.fails, 0);
+    fake_broker_now = TIMEOUT_TICKS + 1;
+    mqttPoll();
+    CHECK_EQ(fake_broker.fails, 1);
+    CHECK(!fake_broker.up);
+    mqttGetStats(&stats);
+    CHECK_EQ(stats.errors, 1);
+    CHECK_EQ(stats.sessions, 0);
+
+    // And the next poll starts over
+    fake_broker.answer_connect = 1;
+    CHECK(pollUntilReady() > 0);
+    CHECK_EQ(fake_broker.connections, 2);
+}
+
+// QoS 1 out: one in flight until its PUBACK. QoS 1 in: streamed to the
+// handlers and acknowledged with its own packet ID.
+static void testQos1(void) {
+    static const char payload[] = "{\"state\":{\"desired\":{\"highscore\":\"1500\"}}}";
+    const BrokerPacket *pub;
+    const BrokerPacket *ack;
+    MqttStats stats;
+
+    setUp();
+    CHECK_EQ(mqttPublish("t/update", payload, (int)strlen(payload), 1), -1);    // Not ready
+    CHECK(pollUntilReady() > 0);
+
+    CHECK_EQ(mqttPublish("t/update", payload, (int)strlen(payload), 1), 0);
+    CHECK(mqttBusy());
+    CHECK_EQ(mqttPublish("t/update", "{}", 2, 1), -1);                         // One at a time
+    fake_broker_now = 40;
+    mqttPoll();
+    pub = fakeBrokerLast(BROKER_PUBLISH);
+    CHECK(pub != NULL);
+    if (pub != NULL) {
+        CHECK_EQ(pub->flags, 0x02);         // QoS 1, no DUP
+        CHECK(strcmp(pub->text, "t/update") == 0);
+        CHECK(strcmp(pub->payload, payload) == 0);
+        CHECK(pub->id != 0);
+    }
+    // The PUBACK was read in the same poll
+    CHECK(!mqttBusy());
+    CHECK_EQ(published_calls, 1);
+    mqttGetStats(&stats);
+    CHECK_EQ(stats.publishes, 1);
+    CHECK_EQ(stats.acks, 1);
+    CHECK_EQ(stats.retransmits, 0);
+
+    // A PUBACK for another ID is ignored
+    CHECK_EQ(mqttPublish("t/update", "{}", 2, 1), 0);
+    fake_broker.answer_publish = 0;
+    mqttPoll();
+    fakeBrokerQueue("\x40\x02\x7f\x7f", 4);
+    mqttPoll();
+    CHECK(mqttBusy());
+    pub = fakeBrokerLast(BROKER_PUBLISH);
+    if (pub != NULL) {
+        char puback[4] = { 0x40, 0x02, (char)(pub->id >> 8), (char)pub->id };
+        fakeBrokerQueue(puback, 4);
+    }
+    mqttPoll();
+    CHECK(!mqttBusy());
+    CHECK_EQ(published_calls, 2);
+
+    // Incoming, in 5-byte reads
+    fake_broker.recv_chunk = 5;
+    fakeBrokerPublish(subs[1], payload, 1, 0x1234);
+    pollTimes(30);
+    CHECK_EQ(message_sub, 1);
+    CHECK_EQ(message_len, (long)strlen(payload));
+    CHECK(strcmp(message, payload) == 0);
+    CHECK_EQ(message_ends, 1);
+    ack = fakeBrokerLast(BROKER_PUBACK);
+    CHECK(ack != NULL && ack->id == 0x1234);
+
+    // Not one of ours: skipped, but still acknowledged
+    fakeBrokerPublish("some/other/topic", "ignored", 1, 0x0042);
+    pollTimes(30);
+    CHECK_EQ(message_ends, 1);
+    ack = fakeBrokerLast(BROKER_PUBACK);
+    CHECK(ack != NULL && ack->id == 0x0042);
+    mqttGetStats(&stats);
+    CHECK_EQ(stats.messages, 1);
+    CHECK_EQ(fake_broker.malformed, 0);
+}
+
+// A QoS 1 publish whose PUBACK was lost with the connection goes out again
+// with DUP and the same packet ID once the new session is subscribed
+static void testDupAfterReconnect(void) {
+    const BrokerPacket *first;
+    uint16_t id;
+    int i, sub_at = -1, dup_at = -1;
+    MqttStats stats;
+
+    setUp();
+    CHECK(pollUntilReady() > 0);
+    fake_broker.answer_publish = 0;
+    CHECK_EQ(mqttPublish("t/update", "{\"n\":1}", 7, 1), 0);
+    mqttPoll();
+    first = fakeBrokerLast(BROKER_PUBLISH);
+    CHECK(first != NULL && first->flags == 0x02);
+    id = first != NULL ? first->id : 0;
+    CHECK(mqttBusy());
+
+    // Server closes the connection
+    fakeBrokerDrop(1);
+    mqttPoll();
+    CHECK(!mqttReady());
+    CHECK_EQ(fake_broker.fails, 1);
+    CHECK(mqttBusy());                      // Kept for the resend
+    CHECK_EQ(mqttPublish("t/update", "{}", 2, 1), -1);
+
+    fake_broker.answer_publish = 1;
+    CHECK(pollUntilReady() > 0);
+    mqttPoll();
+    checkSession(2);
+    for (i = 0; i < fake_broker.packets; i++) {
+        if (fake_broker.log[i].type == BROKER_SUBSCRIBE) {
+            sub_at = i;
+        } else if (fake_broker.log[i].type == BROKER_PUBLISH && (fake_broker.log[i].flags & 0x08)) {
+            dup_at = i;
+        }
+    }
+    CHECK(dup_at > sub_at);
+    CHECK(dup_at >= 0 && fake_broker.log[dup_at].flags == 0x0A);
+    CHECK(dup_at >= 0 && fake_broker.log[dup_at].id == id);
+    CHECK(dup_at >= 0 && strcmp(fake_broker.log[dup_at].payload, "{\"n\":1}") == 0);
+    CHECK(!mqttBusy());
+    CHECK_EQ(published_calls, 1);
+    CHECK_EQ(connected_calls, 2);
+    mqttGetStats(&stats);
+    CHECK_EQ(stats.publishes, 2);
+    CHECK_EQ(stats.retransmits, 1);
+    CHECK_EQ(stats.acks, 1);
+    CHECK_EQ(stats.sessions, 2);
+}
+
+// A publish cut off before it was fully sent never reached the broker: it
+// goes out whole again, without DUP
+static void testPartialPublishResent(void) {
+    const BrokerPacket *pub;
+    MqttStats stats;
+
+    setUp();
+    CHECK(pollUntilReady() > 0);
+    fake_broker.send_chunk = 4;
+    CHECK_EQ(mqttPublish("t/update", "{\"n\":2}", 7, 1), 0);
+    mqttPoll();
+    CHECK_EQ(fakeBrokerCount(BROKER_PUBLISH), 0);
+    fakeBrokerDrop(0);
+    mqttPoll();
+    CHECK(!mqttReady());
+
+    fake_broker.send_chunk = 0;
+    CHECK(pollUntilReady() > 0);
+    mqttPoll();
+    CHECK_EQ(fakeBrokerCount(BROKER_PUBLISH), 1);
+    pub = fakeBrokerLast(BROKER_PUBLISH);
+    CHECK(pub != NULL && pub->flags == 0x02);
+    CHECK(pub != NULL && strcmp(pub->payload, "{\"n\":2}") == 0);
+    CHECK(!mqttBusy());
+    mqttGetStats(&stats);
+    CHECK_EQ(stats.retransmits, 0);
+}
+
+// A PUBACK that never comes drops the connection after the timeout
+static void testPubackTimeout(void) {
+    setUp();
+    CHECK(pollUntilReady() > 0);
+    fake_broker.answer_publish = 0;
+    fake_broker_now = 1000;
+    CHECK_EQ(mqttPublish("t/update", "{}", 2, 1), 0);
+    mqttPoll();
+    fake_broker_now = 1000 + TIMEOUT_TICKS;
+    mqttPoll();
+    CHECK(mqttReady());
+    fake_broker_now = 1000 + TIMEOUT_TICKS + 1;
+    mqttPoll();
+    CHECK(!mqttReady());
+    CHECK_EQ(fake_broker.fails, 1);
+    CHECK(mqttBusy());
+}
+
+// PINGREQ when the transport says the link is quiet; a missing PINGRESP
+// drops the connection after the timeout, and the client reconnects
+static void testPing(void) {
+    MqttStats stats;
+
+    setUp();
+    CHECK(pollUntilReady() > 0);
+    mqttPoll();
+    CHECK_EQ(fakeBrokerCount(BROKER_PINGREQ), 0);
+
+    fake_broker.keepalive_due = 1;
+    mqttPoll();
+    fake_broker.keepalive_due = 0;
+    CHECK_EQ(fakeBrokerCount(BROKER_PINGREQ), 1);
+    mqttPoll();
+    mqttGetStats(&stats);
+    CHECK_EQ(stats.pings, 1);
+
+    // Answered: nothing happens at the timeout
+    fake_broker_now = 10 * TIMEOUT_TICKS;
+    mqttPoll();
+    CHECK(mqttReady());
+    CHECK_EQ(fake_broker.fails, 0);
+
+    // Unanswered
+    fake_broker.answer_ping = 0;
+    fake_broker.keepalive_due = 1;
+    mqttPoll();
+    fake_broker.keepalive_due = 0;
+    CHECK_EQ(fakeBrokerCount(BROKER_PINGREQ), 2);
+    fake_broker.keepalive_due = 1;          // Still due: no second ping while one is out
+    mqttPoll();
+    fake_broker.keepalive_due = 0;
+    CHECK_EQ(fakeBrokerCount(BROKER_PINGREQ), 2);
+    fake_broker_now += TIMEOUT_TICKS;
+    mqttPoll();
+    CHECK(mqttReady());
+    fake_broker_now += 1;
+    mqttPoll();
+    CHECK(!mqttReady());
+    CHECK_EQ(fake_broker.fails, 1);
+    mqttGetStats(&stats);
+    CHECK_EQ(stats.errors, 1);
+    CHECK_EQ(stats.pings, 2);
+    CHECK(reports >= 1);
+
+    fake_broker.answer_ping = 1;
+    CHECK(pollUntilReady() > 0);
+    checkSession(2);
+}
+
+// A malformed length drops the connection instead of desynchronizing
+static void testMalformed(void) {
+    setUp();
+    CHECK(pollUntilReady() > 0);
+    fakeBrokerQueue("\x30\xff\xff\xff\xff\x01", 6);
+    mqttPoll();
+    CHECK(!mqttReady());
+    CHECK_EQ(fake_broker.fails, 1);
+    CHECK(pollUntilReady() > 0);
+}
+
+int main(void) {
+    testConnectSubscribe();
+    testConnectPartialIo();
+    testConnectRefusedAndTimeout();
+    testQos1();
+    testDupAfterReconnect();
+    testPartialPublishResent();
+    testPubackTimeout();
+    testPing();
+    testMalformed();
+    return testExitCode("mqtt_client_test");
+}
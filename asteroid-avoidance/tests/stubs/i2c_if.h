@@ -0,0 +1,16 @@
+//*****************************************************************************
+// i2c_if.h - Host stand-in for the SDK's polled I2C interface
+//
+// Only the prototypes; a test that links a module using them defines them.
+//*****************************************************************************
+
+#ifndef TESTS_STUBS_I2C_IF_H_
+#define TESTS_STUBS_I2C_IF_H_
+
+int I2C_IF_Write(unsigned char ucDevAddr, unsigned char *pucData,
+                 unsigned char ucLen, unsigned char ucStop);
+int I2C_IF_ReadFrom(unsigned char ucDevAddr, unsigned char *pucWrDataBuf,
+                    unsigned char ucWrLen, unsigned char *pucRdDataBuf,
+                    unsigned char ucRdLen);
+
+#endif /* TESTS_STUBS_I2C_IF_H_ */
@@ -0,0 +1,18 @@
+//*****************************************************************************
+// simplelink.h - Host stand-in for the SimpleLink socket API
+//
+// Only what the request code around a borrowed socket needs; a test that
+// links such a module defines sl_Send() and sl_Recv().
+//*****************************************************************************
+
+#ifndef TESTS_STUBS_SIMPLELINK_H_
+#define TESTS_STUBS_SIMPLELINK_H_
+
+#include <stdint.h>
+
+#define SL_EAGAIN   (-11)   // Non-blocking socket: try again
+
+int16_t sl_Send(int16_t sd, const void *pBuf, int16_t Len, int16_t flags);
+int16_t sl_Recv(int16_t sd, void *pBuf, int16_t Len, int16_t flags);
+
+#endif /* TESTS_STUBS_SIMPLELINK_H_ */
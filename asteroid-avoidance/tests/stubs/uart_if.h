@@ -0,0 +1,13 @@
+//*****************************************************************************
+// uart_if.h - Host stand-in for the UART console interface
+//
+// Only the prototype log.h needs; a test that links a module logging through
+// it defines Report().
+//*****************************************************************************
+
+#ifndef TESTS_STUBS_UART_IF_H_
+#define TESTS_STUBS_UART_IF_H_
+
+int Report(const char *pcFormat, ...);
+
+#endif /* TESTS_STUBS_UART_IF_H_ */
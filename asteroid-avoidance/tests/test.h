@@ -0,0 +1,38 @@
+//*****************************************************************************
+// test.h - Minimal assertions for the host-built tests
+//
+// A failed check prints its location and the test keeps going; main()
+// returns testExitCode() so make stops on the first failing binary.
+//*****************************************************************************
+
+#ifndef TESTS_TEST_H_
+#define TESTS_TEST_H_
+
+#include <stdio.h>
+
+static int test_checks;
+static int test_failures;
+
+#define CHECK(cond) do { \
+        test_checks++; \
+        if (!(cond)) { \
+            test_failures++; \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) do { \
+        long long a_ = (long long)(actual), e_ = (long long)(expected); \
+        test_checks++; \
+        if (a_ != e_) { \
+            test_failures++; \
+            printf("%s:%d: %s == %lld, expected %lld\n", __FILE__, __LINE__, #actual, a_, e_); \
+        } \
+    } while (0)
+
+static int testExitCode(const char *name) {
+    printf("%s: %d checks, %d failed\n", name, test_checks, test_failures);
+    return test_failures ? 1 : 0;
+}
+
+#endif /* TESTS_TEST_H_ */
@@ -0,0 +1,46 @@
+//*****************************************************************************
+// tilt_filter_bench.c - Cost of one sample through the tilt pipeline
+//
+// One tiltFilterSample() plus tiltFilterOutput() per iteration, as the game
+// runs them per accelerometer sample, over a noisy tilt sweep.
+//*****************************************************************************
+
+#include "bench.h"
+
+#include "tilt_filter.h"
+
+#define SWEEP_LEN       1024
+#define ITERATIONS      20000000L
+
+static const TiltConfig game_cfg = {
+    FIX_FROM_RATIO(1, 2), FIX_FROM_RATIO(1, 10), FIX_FROM_RATIO(3, 2), INT_TO_FIX(18),
+    FIX_FROM_RATIO(1, 2), FIX_FROM_RATIO(2, 1), 1, 5, 250000
+};
+
+int main(void) {
+    static int sweep[SWEEP_LEN];
+    uint32_t seed = 1;
+    TiltFilter f;
+    fix8_t v;
+    long sum = 0;
+    double start;
+    long i;
+
+    // -40..40 counts and back, with +/-2 counts of noise
+    for (i = 0; i < SWEEP_LEN; i++) {
+        int phase = (int)(i % 160);
+        seed = seed * 1103515245UL + 12345;
+        sweep[i] = (phase < 80 ? phase - 40 : 120 - phase) + (int)((seed >> 16) % 5) - 2;
+    }
+
+    tiltFilterInit(&f, &game_cfg);
+    start = benchNow();
+    for (i = 0; i < ITERATIONS; i++) {
+        tiltFilterSample(&f, sweep[i & (SWEEP_LEN - 1)]);
+        tiltFilterOutput(&f, 0, &v);
+        sum += v;
+    }
+    benchReport("tilt sample+output", ITERATIONS, 0, benchNow() - start);
+    bench_sink = sum;
+    return 0;
+}
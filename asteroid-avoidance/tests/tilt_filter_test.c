@@ -0,0 +1,164 @@
+//*****************************************************************************
+// tilt_filter_test.c - Calibration, filter response and output curve
+//*****************************************************************************
+
+#include "test.h"
+#include "tilt_filter.h"
+
+// The game's tuning (main.c)
+static const TiltConfig game_cfg = {
+    FIX_FROM_RATIO(1, 2),       // alpha
+    FIX_FROM_RATIO(1, 10),      // beta
+    FIX_FROM_RATIO(3, 2),       // deadzone
+    INT_TO_FIX(18),             // full tilt
+    FIX_FROM_RATIO(1, 2),       // expo
+    FIX_FROM_RATIO(2, 1),       // max speed
+    1,                          // invert
+    5,                          // max errors
+    250000                      // max age
+};
+
+static fix8_t absFix(fix8_t v) {
+    return v < 0 ? -v : v;
+}
+
+static void testCalibrateStill(void) {
+    static const int8_t still[16] = {3, 4, 2, 3, 3, 5, 3, 2, 4, 3, 3, 1, 3, 4, 3, 2};
+    TiltFilter f;
+    fix8_t v;
+    int i;
+
+    tiltFilterInit(&f, &game_cfg);
+    CHECK_EQ(tiltFilterCalibrate(&f, still, 16), 0);
+    CHECK_EQ(f.offset, 48 * FIX_ONE / 16);
+
+    // Resting at the calibrated level steers nowhere
+    for (i = 0; i < 50; i++) {
+        tiltFilterSample(&f, still[i % 16]);
+        CHECK_EQ(tiltFilterOutput(&f, 0, &v), TILT_OK);
+        CHECK_EQ(v, 0);
+    }
+}
+
+// Picked up, tilted or bumped while calibrating: the offset is kept
+static void testCalibrateMoving(void) {
+    static const int8_t ramp[16] = {0, 1, 1, 2, 3, 3, 4, 5, 5, 6, 7, 7, 8, 9, 9, 10};
+    static const int8_t bump[16] = {2, 2, 3, 2, 2, 2, -9, 2, 3, 2, 2, 2, 3, 2, 2, 2};
+    static const int8_t edge[4] = {-3, 3, 0, 0};        // Spread 6: still accepted
+    static const int8_t over[4] = {-3, 4, 0, 0};        // Spread 7
+    TiltFilter f;
+
+    tiltFilterInit(&f, &game_cfg);
+    f.offset = INT_TO_FIX(1);
+    CHECK_EQ(tiltFilterCalibrate(&f, ramp, 16), -1);
+    CHECK_EQ(f.offset, INT_TO_FIX(1));
+    CHECK_EQ(tiltFilterCalibrate(&f, bump, 16), -1);
+    CHECK_EQ(f.offset, INT_TO_FIX(1));
+    CHECK_EQ(tiltFilterCalibrate(&f, over, 4), -1);
+    CHECK_EQ(tiltFilterCalibrate(&f, ramp, 0), -1);
+    CHECK_EQ(f.offset, INT_TO_FIX(1));
+    CHECK_EQ(tiltFilterCalibrate(&f, edge, 4), 0);
+    CHECK_EQ(f.offset, 0);
+}
+
+// A step of 12 counts: 90% within 3 samples (48 ms at 62.5 Hz), bounded
+// overshoot, and settled to within 0.05 counts after 20 samples
+static void testStepResponse(void) {
+    TiltFilter f;
+    fix8_t peak = 0;
+    fix8_t v;
+    int i;
+
+    tiltFilterInit(&f, &game_cfg);
+    for (i = 0; i < 5; i++) {
+        tiltFilterSample(&f, 0);
+    }
+    CHECK_EQ(f.pos, 0);
+    for (i = 0; i < 40; i++) {
+        tiltFilterSample(&f, 12);
+        if (i == 2) {
+            CHECK(f.pos >= INT_TO_FIX(12) * 9 / 10);
+        }
+        if (f.pos > peak) {
+            peak = f.pos;
+        }
+        if (i >= 20) {
+            CHECK(absFix(f.pos - INT_TO_FIX(12)) <= FIX_FROM_RATIO(1, 20));
+        }
+    }
+    CHECK(peak <= INT_TO_FIX(12) * 115 / 100);
+
+    // Tilting right reads negative, and the game inverts it
+    CHECK_EQ(tiltFilterOutput(&f, 0, &v), TILT_OK);
+    CHECK(v < 0);
+    // (1 - expo) t + expo t^3 with t = 10.5 / 16.5, times 2 px/frame
+    CHECK(absFix(-v - FIX_FROM_RATIO(894, 1000)) <= FIX_FROM_RATIO(1, 50));
+
+    // And back to level, without drifting past it
+    for (i = 0; i < 40; i++) {
+        tiltFilterSample(&f, 0);
+    }
+    CHECK(absFix(f.pos) <= FIX_FROM_RATIO(1, 20));
+    CHECK_EQ(tiltFilterOutput(&f, 0, &v), TILT_OK);
+    CHECK_EQ(v, 0);
+}
+
+static void testOutputCurve(void) {
+    TiltFilter f;
+    fix8_t v;
+
+    tiltFilterInit(&f, &game_cfg);
+    CHECK_EQ(tiltFilterOutput(&f, 0, &v), TILT_FAULT);    // Nothing sampled yet
+
+    // Just inside the deadzone
+    tiltFilterSample(&f, -1);
+    CHECK_EQ(tiltFilterOutput(&f, 0, &v), TILT_OK);
+    CHECK_EQ(v, 0);
+
+    // Past full tilt both ways saturates at max speed
+    tiltFilterInit(&f, &game_cfg);
+    tiltFilterSample(&f, -60);
+    CHECK_EQ(tiltFilterOutput(&f, 0, &v), TILT_OK);
+    CHECK_EQ(v, FIX_FROM_RATIO(2, 1));
+    tiltFilterInit(&f, &game_cfg);
+    tiltFilterSample(&f, 60);
+    CHECK_EQ(tiltFilterOutput(&f, 0, &v), TILT_OK);
+    CHECK_EQ(v, -FIX_FROM_RATIO(2, 1));
+}
+
+// Failed reads hold the estimate until max_errors, then fault; one good
+// sample clears it. Old samples fault too.
+static void testFaults(void) {
+    TiltFilter f;
+    fix8_t v;
+    int i;
+
+    tiltFilterInit(&f, &game_cfg);
+    tiltFilterSample(&f, 60);
+    for (i = 0; i < 4; i++) {
+        tiltFilterError(&f);
+        CHECK_EQ(tiltFilterOutput(&f, 0, &v), TILT_OK);
+        CHECK(v != 0);
+    }
+    tiltFilterError(&f);
+    CHECK_EQ(tiltFilterOutput(&f, 0, &v), TILT_FAULT);
+    CHECK_EQ(v, 0);
+    for (i = 0; i < 100; i++) {
+        tiltFilterError(&f);
+    }
+    tiltFilterSample(&f, 60);
+    CHECK_EQ(tiltFilterOutput(&f, 0, &v), TILT_OK);
+
+    CHECK_EQ(tiltFilterOutput(&f, 250000, &v), TILT_OK);
+    CHECK_EQ(tiltFilterOutput(&f, 250001, &v), TILT_FAULT);
+    CHECK_EQ(v, 0);
+}
+
+int main(void) {
+    testCalibrateStill();
+    testCalibrateMoving();
+    testStepResponse();
+    testOutputCurve();
+    testFaults();
+    return testExitCode("tilt_filter_test");
+}
@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+"""Decode binary log frames from a LOG_BINARY build of the game.
+
+The device sends format-string IDs and raw argument words instead of text
+(see utils/log.h). This tool reads the format strings from the .logstr
+section of the linked .out file and rebuilds the messages. Plain text on
+the console (Report() output) is passed through unchanged.
+
+    python3 logdecode.py Debug/asteroid-avoidance.out /dev/ttyACM0
+    python3 logdecode.py Debug/asteroid-avoidance.out capture.bin
+    python3 logdecode.py Debug/asteroid-avoidance.out --dump
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+LOG_BIN_SYNC = 0xA5
+LEVEL_NAMES = {1: "E", 2: "W", 3: "I", 4: "D", 5: "T"}
+
+SHT_NOBITS = 8
+SPEC_RE = re.compile(
+    r"%(?P<flags>[-+ #0]*)(?P<width>\d+)?(?:\.(?P<prec>\d+))?"
+    r"(?P<length>hh|h|ll|l|z|j|t)?(?P<conv>[diouxXcsp%])")
+
+
+class Image:
+    """Sections of a 32-bit little-endian ELF file (TI .out or GCC .elf)."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+            raise ValueError("%s: not a 32-bit little-endian ELF file" % path)
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x2E)
+
+        headers = []
+        for i in range(shnum):
+            headers.append(struct.unpack_from("<IIIIIIIIII", data, shoff + i * shentsize))
+        names_off = headers[shstrndx][4]
+
+        self.sections = {}
+        self.loaded = []
+        for (name, sh_type, _flags, addr, offset, size, _l, _i, _a, _e) in headers:
+            end = data.index(b"\0", names_off + name)
+            sec_name = data[names_off + name:end].decode("ascii", "replace")
+            contents = b"" if sh_type == SHT_NOBITS else data[offset:offset + size]
+            self.sections[sec_name] = contents
+            if addr and contents and sec_name != ".logstr":
+                self.loaded.append((addr, contents))
+
+    def log_string(self, msg_id):
+        table = self.sections.get(".logstr")
+        if table is None:
+            raise ValueError("no .logstr section: was the image built with LOG_BINARY?")
+        if msg_id >= len(table):
+            return None
+        return _cstring(table, msg_id)
+
+    def string_at(self, addr):
+        for base, contents in self.loaded:
+            if base <= addr < base + len(contents):
+                return _cstring(contents, addr - base)
+        return "<0x%08X>" % addr
+
+
+def _cstring(buf, start):
+    end = buf.find(b"\0", start)
+    if end < 0:
+        end = len(buf)
+    return buf[start:end].decode("latin-1")
+
+
+def format_message(image, fmt, args):
+    """Apply C format fmt to 32-bit argument words."""
+    args = list(args)
+    out = []
+    pos = 0
+    for m in SPEC_RE.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        conv = m.group("conv")
+        if conv == "%":
+            out.append("%")
+            continue
+        if not args:
+            out.append("<missing>")
+            continue
+        word = args.pop(0)
+        spec = "%" + m.group("flags") + (m.group("width") or "")
+        if m.group("prec"):
+            spec += "." + m.group("prec")
+        if conv in "di":
+            value = word - (1 << 32) if word & 0x80000000 else word
+            out.append((spec + "d") % value)
+        elif conv == "s":
+            out.append((spec + "s") % image.string_at(word))
+        elif conv == "c":
+            out.append((spec + "c") % chr(word & 0xFF))
+        elif conv == "p":
+            out.append("0x%08x" % word)
+        else:
+            out.append((spec + ("d" if conv == "u" else conv)) % word)
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def decode(image, stream, out, show_level):
+    """Copy text through and expand binary frames until stream ends."""
+    while True:
+        b = stream.read(1)
+        if not b:
+            return
+        if b[0] != LOG_BIN_SYNC:
+            out.write(b.decode("latin-1"))
+            continue
+        header = _read_exact(stream, 3)
+        if header is None:
+            return
+        level, nargs = header[0] >> 4, header[0] & 0x0F
+        msg_id = header[1] | (header[2] << 8)
+        payload = _read_exact(stream, 4 * nargs)
+        if payload is None:
+            return
+        args = struct.unpack("<%dI" % nargs, payload)
+        fmt = image.log_string(msg_id)
+        if fmt is None:
+            text = "<unknown log id 0x%04X: %s>\r\n" % (msg_id, " ".join("0x%X" % a for a in args))
+        else:
+            text = format_message(image, fmt, args)
+        if show_level:
+            text = "[%s] %s" % (LEVEL_NAMES.get(level, "?"), text)
+        out.write(text)
+        out.flush()
+
+
+def _read_exact(stream, n):
+    buf = b""
+    while len(buf) < n:
+        chunk = stream.read(n - len(buf))
+        if not chunk:
+            return None
+        buf += chunk
+    return buf
+
+
+def open_input(name, baud):
+    if name == "-":
+        return sys.stdin.buffer
+    if name.startswith("/dev/") or name.upper().startswith("COM"):
+        import serial  # pyserial, only needed for live capture
+        return serial.Serial(name, baud)
+    return open(name, "rb")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("image", help="linked .out/.elf file of the running build")
+    parser.add_argument("input", nargs="?", default="-",
+                        help="serial port, capture file, or - for stdin")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--levels", action="store_true", help="prefix messages with their level")
+    parser.add_argument("--dump", action="store_true", help="list the string table and exit")
+    opts = parser.parse_args()
+
+    image = Image(opts.image)
+    if opts.dump:
+        table = image.sections.get(".logstr", b"")
+        msg_id = 0
+        while msg_id < len(table):
+            if table[msg_id] == 0:
+                msg_id += 1
+                continue
+            text = image.log_string(msg_id)
+            print("0x%04X %r" % (msg_id, text))
+            msg_id += len(text.encode("latin-1")) + 1
+        return
+
+    try:
+        decode(image, open_input(opts.input, opts.baud), sys.stdout, opts.levels)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
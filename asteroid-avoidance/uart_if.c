@@ -56,8 +56,10 @@
 #endif
 
 #include "uart_if.h"
+#include "utils/uart_log.h"
 
 #define IS_SPACE(x)       (x == 32 ? 1 : 0)
+#define REPORT_BUF_SIZE   256
 
 //*****************************************************************************
 // Global variable indicating command is present
@@ -109,10 +111,7 @@ Message(const char *str)
 #ifndef NOTERM
     if(str != NULL)
     {
-        while(*str!='\0')
-        {
-            MAP_UARTCharPut(CONSOLE,*str++);
-        }
+        uartLogWrite(str, strlen(str));
     }
 #endif
 }
@@ -295,43 +294,26 @@ int Report(const char *pcFormat, ...)
  int iRet = 0;
 #ifndef NOTERM
 
-  char *pcBuff, *pcTemp;
-  int iSize = 256;
- 
+  //
+  // Format into a fixed buffer (no heap) and queue it for the TX interrupt;
+  // longer messages are truncated
+  //
+  char cBuf[REPORT_BUF_SIZE];
   va_list list;
-  pcBuff = (char*)malloc(iSize);
-  if(pcBuff == NULL)
+
+  va_start(list,pcFormat);
+  iRet = vsnprintf(cBuf,sizeof(cBuf),pcFormat,list);
+  va_end(list);
+  if(iRet < 0)
   {
       return -1;
   }
-  while(1)
+  if(iRet >= (int)sizeof(cBuf))
   {
-      va_start(list,pcFormat);
-      iRet = vsnprintf(pcBuff,iSize,pcFormat,list);
-      va_end(list);
-      if(iRet > -1 && iRet < iSize)
-      {
-          break;
-      }
-      else
-      {
-          iSize*=2;
-          if((pcTemp=realloc(pcBuff,iSize))==NULL)
-          { 
-              Message("Could not reallocate memory\n\r");
-              iRet = -1;
-              break;
-          }
-          else
-          {
-              pcBuff=pcTemp;
-          }
-          
-      }
+      iRet = sizeof(cBuf) - 1;
   }
-  Message(pcBuff);
-  free(pcBuff);
-  
+  uartLogWrite(cBuf, iRet);
+
 #endif
   return iRet;
 }
@@ -0,0 +1,77 @@
+//*****************************************************************************
+// accel.c - Direct BMA222 accelerometer driver (burst register reads)
+//*****************************************************************************
+
+#include "accel.h"
+
+#include "i2c_if.h"
+#include "i2c_async.h"
+
+static uint8_t accel_async_buf[ACCEL_BURST_LEN];
+static I2cAsyncXfer accel_xfer;
+static volatile int accel_async_result = 0;    // 1 new sample, -1 failed, 0 consumed
+
+static void decode(const uint8_t *buf, AccelSample *out) {
+    // 8-bit two's complement per axis
+    out->x = (int8_t)buf[ACCEL_REG_X - ACCEL_REG_FIRST];
+    out->y = (int8_t)buf[ACCEL_REG_Y - ACCEL_REG_FIRST];
+}
+
+// Completion callback, interrupt context
+static void accelXferDone(I2cAsyncXfer *xfer) {
+    accel_async_result = (xfer->status == I2C_ASYNC_OK) ? 1 : -1;
+}
+
+int accelReadRaw(unsigned char *buf) {
+    unsigned char reg = ACCEL_REG_FIRST;
+    return I2C_IF_ReadFrom(ACCEL_I2C_ADDR, &reg, 1, buf, ACCEL_BURST_LEN) < 0 ? -1 : 0;
+}
+
+int accelRead(AccelSample *out) {
+    unsigned char buf[ACCEL_BURST_LEN];
+
+    if (accelReadRaw(buf) < 0) {
+        return -1;
+    }
+    decode(buf, out);
+    return 0;
+}
+
+static int writeReg(unsigned char reg, unsigned char value) {
+    unsigned char data[2];
+    data[0] = reg;
+    data[1] = value;
+    return I2C_IF_Write(ACCEL_I2C_ADDR, data, 2, 1) < 0 ? -1 : 0;
+}
+
+int accelEnableDataReady(void) {
+    if (writeReg(ACCEL_REG_PMU_BW, ACCEL_BW_31HZ) < 0
+            || writeReg(ACCEL_REG_INT_OUT_CTRL, ACCEL_INT1_PUSH_PULL_HIGH) < 0
+            || writeReg(ACCEL_REG_INT_MAP_1, ACCEL_INT_MAP_1_INT1_DATA) < 0
+            || writeReg(ACCEL_REG_INT_EN_1, ACCEL_INT_EN_1_DATA) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+int accelReadAsyncStart(void) {
+    accel_xfer.addr = ACCEL_I2C_ADDR;
+    accel_xfer.reg = ACCEL_REG_FIRST;
+    accel_xfer.len = ACCEL_BURST_LEN;
+    accel_xfer.write = 0;
+    accel_xfer.buf = accel_async_buf;
+    accel_xfer.done = accelXferDone;
+    return i2cAsyncSubmit(&accel_xfer);
+}
+
+int accelReadAsyncResult(AccelSample *out) {
+    int result = accel_async_result;
+    if (result != 0) {
+        // Nothing is in flight once a result is posted, so clearing is safe
+        if (result == 1) {
+            decode(accel_async_buf, out);
+        }
+        accel_async_result = 0;
+    }
+    return result;
+}
@@ -0,0 +1,57 @@
+//*****************************************************************************
+// accel.h - Direct BMA222 accelerometer driver (burst register reads)
+//*****************************************************************************
+
+#ifndef UTILS_ACCEL_H_
+#define UTILS_ACCEL_H_
+
+#include <stdint.h>
+
+#define ACCEL_I2C_ADDR      0x18
+#define ACCEL_REG_FIRST     0x03    // First data register in the burst
+#define ACCEL_BURST_LEN     3       // 0x03..0x05
+
+// Axis registers as mounted on the board: register 0x3 tracks the game's Y
+// axis and 0x5 its X axis (tilt left/right)
+#define ACCEL_REG_Y         0x03
+#define ACCEL_REG_X         0x05
+
+// Data-ready interrupt setup (the BMA222 has no FIFO, so each INT1 pulse
+// announces exactly one new sample)
+#define ACCEL_REG_PMU_BW        0x10
+#define ACCEL_REG_INT_EN_1      0x17
+#define ACCEL_REG_INT_MAP_1     0x1A
+#define ACCEL_REG_INT_OUT_CTRL  0x20
+#define ACCEL_BW_31HZ           0x0A    // 31.25 Hz filter bandwidth, new data at 62.5 Hz
+#define ACCEL_INT_EN_1_DATA     0x10
+#define ACCEL_INT_MAP_1_INT1_DATA 0x01
+#define ACCEL_INT1_PUSH_PULL_HIGH 0x01
+#define ACCEL_SAMPLE_PERIOD_US  16000
+
+typedef struct {
+    int8_t x;
+    int8_t y;
+} AccelSample;
+
+// Read ACCEL_BURST_LEN contiguous data registers starting at ACCEL_REG_FIRST
+// in one write + repeated-start read. buf must hold ACCEL_BURST_LEN bytes.
+// Returns 0, or -1 on an I2C error (buf contents are then undefined).
+int accelReadRaw(unsigned char *buf);
+
+// Burst read and decode both axes. Returns 0, or -1 on an I2C error in which
+// case *out is left untouched.
+int accelRead(AccelSample *out);
+
+// Set the data rate and route the new-data interrupt to INT1 (active high,
+// push-pull). Polled I2C, for init only. Returns 0, or -1 on an I2C error.
+int accelEnableDataReady(void);
+
+// Non-blocking variant on the interrupt-driven I2C engine: start a burst
+// read, and pick up its result later (e.g. next frame, after rendering).
+// Start returns -1 if a read is already in flight. Result returns 1 and
+// fills *out for a new sample, 0 if none has completed since the last call,
+// or -1 if the last read failed.
+int accelReadAsyncStart(void);
+int accelReadAsyncResult(AccelSample *out);
+
+#endif /* UTILS_ACCEL_H_ */
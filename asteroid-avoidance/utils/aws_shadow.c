@@ -0,0 +1,696 @@
+//*****************************************************************************
+// aws_shadow.c - Non-blocking AWS IoT device shadow client for the high score
+//*****************************************************************************
+
+#include "aws_shadow.h"
+
+#include <string.h>
+
+#include "simplelink.h"
+#include "http_request.h"
+#include "json_stream.h"
+#include "leaderboard.h"
+#include "tls_conn.h"
+#ifdef AWS_SHADOW_HTTP
+#include "http_parser.h"
+#else
+#include "mqtt_client.h"
+#include "mqtt_tls.h"
+#endif
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_INFO
+#include "log.h"
+
+#define POST_BODY_PREFIX    "{\"state\":{\"desired\":{"
+#define POST_BODY_SCORE     "\"highscore\":\""
+#define POST_BODY_BOARD     "\"leaderboard\":\""
+#define POST_BODY_STATE_END "}}"
+#define POST_BODY_VERSION   ",\"version\":"
+#define POST_BODY_END       "}"
+#define POST_BODY_MAX       (sizeof(POST_BODY_PREFIX) + sizeof(POST_BODY_SCORE) + \
+                             sizeof(POST_BODY_BOARD) + LEADERBOARD_TEXT_SIZE + \
+                             sizeof(POST_BODY_STATE_END) + sizeof(POST_BODY_VERSION) + \
+                             sizeof(POST_BODY_END) + 20)
+
+// One more than the longest valid text, so a full buffer means truncated
+#define BOARD_TEXT_SIZE     (LEADERBOARD_TEXT_SIZE + 1)
+
+#define HTTP_OK             200
+#define HTTP_NOT_FOUND      404     // No shadow document yet
+#define HTTP_CONFLICT       409     // Version in the update didn't match
+
+typedef enum {
+    SHADOW_IDLE,
+    SHADOW_SENDING,
+    SHADOW_RECEIVING
+} ShadowState;
+
+static uint32_t (*shadow_now)(void);
+static uint32_t shadow_timeout;
+static AwsShadowChanged shadow_changed;
+
+static ShadowState shadow_state = SHADOW_IDLE;
+static uint32_t shadow_started;
+static int get_pending = 0;
+static int post_pending = 0;
+static int post_score = 0;
+static int post_conflicts = 0;          // 409s seen for the queued score or entries
+static int read_first = 0;              // Read the shadow before posting (version unknown or stale)
+static int inflight_read = 0;           // The request in flight is a GET
+static int inflight_post = -1;          // Score being posted, -1 if none
+static int high_score = -1;             // -1 until a response carried one
+
+static Leaderboard board;               // Shadow's table as last seen
+static Leaderboard pending;             // Local entries the shadow doesn't have yet
+static Leaderboard inflight_entries;    // Entries merged into the post in flight
+static char board_text[BOARD_TEXT_SIZE];
+
+static int shadow_ready = 0;            // Requests composed
+static char *post_body;                 // POST_BODY_PREFIX already in place
+static JsonStream json;
+static long shadow_version = -1;        // Shadow document version, -1 until seen, 0 if none exists
+
+static AwsShadowStats stats;
+
+static void transportInit(const char *host);
+static int transportOnline(void);
+static void transportPoll(void);
+
+void awsShadowInit(const char *host, uint32_t (*now)(void), uint32_t timeout_ticks,
+                   AwsShadowChanged on_change) {
+    shadow_now = now;
+    shadow_timeout = timeout_ticks;
+    shadow_changed = on_change;
+    shadow_state = SHADOW_IDLE;
+
+    transportInit(host);
+    if (shadow_ready) {
+        memcpy(post_body, POST_BODY_PREFIX, sizeof(POST_BODY_PREFIX) - 1);
+    } else {
+        LOG_ERROR("Shadow: host name or client ID too long for the request buffers\r\n");
+    }
+}
+
+int awsShadowOnline(void) {
+    return transportOnline();
+}
+
+void awsShadowRequestGet(void) {
+    get_pending = 1;
+}
+
+void awsShadowPostScore(int score) {
+    if (post_pending && score <= post_score) {
+        return;
+    }
+    post_score = score;
+    post_pending = 1;
+    post_conflicts = 0;
+    if (shadow_version < 0) {
+        read_first = 1;
+    }
+}
+
+int awsShadowSubmit(const LeaderboardEntry *entry) {
+    Leaderboard view;
+
+    awsShadowLeaderboard(&view);
+    if (leaderboardRank(&view, entry) < 0 || leaderboardInsert(&pending, entry) < 0) {
+        return -1;
+    }
+    post_conflicts = 0;
+    if (shadow_version < 0) {
+        read_first = 1;
+    }
+    return leaderboardInsert(&view, entry);
+}
+
+void awsShadowLeaderboard(Leaderboard *out) {
+    *out = board;
+    leaderboardMerge(out, &pending);
+}
+
+int awsShadowHighScore(int fallback) {
+    return high_score >= 0 ? high_score : fallback;
+}
+
+int awsShadowIdle(void) {
+    return shadow_state == SHADOW_IDLE && !get_pending && !post_pending && !pending.count &&
+           !read_first;
+}
+
+void awsShadowGetStats(AwsShadowStats *out) {
+    *out = stats;
+}
+
+void awsShadowPoll(void) {
+    transportPoll();
+}
+
+// The request in flight goes back in the queue unless a newer one replaced
+// it. Entries stay pending until the shadow has them.
+static void requeue(void) {
+    shadow_state = SHADOW_IDLE;
+    if (inflight_read) {
+        get_pending = 1;
+    } else if (inflight_post >= 0 && (!post_pending || inflight_post > post_score)) {
+        post_score = inflight_post;
+        post_pending = 1;
+    }
+}
+
+// Drop pending entries the shadow's table holds, or that no longer make it
+static void prunePending(void) {
+    int i = 0;
+    while (i < pending.count) {
+        if (leaderboardFind(&board, &pending.entries[i]) >= 0 ||
+                leaderboardRank(&board, &pending.entries[i]) < 0) {
+            leaderboardRemove(&pending, i);
+        } else {
+            i++;
+        }
+    }
+}
+
+// Non-zero if a request is waiting to be sent
+static int requestQueued(void) {
+    if (post_pending && high_score >= 0 && post_score <= high_score) {
+        // The shadow already holds this score or a better one
+        LOG_INFO("Shadow: score %d not above %d, not posted\r\n", post_score, high_score);
+        post_pending = 0;
+        if (!pending.count) {
+            read_first = 0;
+        }
+    }
+    return (post_pending || pending.count || get_pending || read_first) && shadow_ready;
+}
+
+// Take the next queued request and mark it in flight (inflight_read, or
+// the score and entries posted)
+static void nextRequest(void) {
+    // Writes first, so a following read sees the new score, unless the
+    // write needs a fresh version
+    if ((post_pending || pending.count) && !read_first) {
+        inflight_read = 0;
+        inflight_post = post_pending ? post_score : -1;
+        inflight_entries = pending;
+        post_pending = 0;
+    } else {
+        inflight_read = 1;
+        inflight_post = -1;
+        get_pending = 0;
+    }
+    shadow_started = shadow_now();
+    stats.requests++;
+}
+
+// The score if one is in flight, and the shadow's table merged with the
+// pending entries (merge on write: a 409 means it is merged again with a
+// fresh read); then the version. Returns the body length.
+static int buildPostBody(void) {
+    char *body = post_body;
+    int n = sizeof(POST_BODY_PREFIX) - 1;
+
+    if (inflight_post >= 0) {
+        memcpy(body + n, POST_BODY_SCORE, sizeof(POST_BODY_SCORE) - 1);
+        n += sizeof(POST_BODY_SCORE) - 1;
+        n += httpFormatUint(body + n, (unsigned long)inflight_post);
+        body[n++] = '"';
+    }
+    if (inflight_entries.count) {
+        Leaderboard merged = board;
+        leaderboardMerge(&merged, &inflight_entries);
+        if (inflight_post >= 0) {
+            body[n++] = ',';
+        }
+        memcpy(body + n, POST_BODY_BOARD, sizeof(POST_BODY_BOARD) - 1);
+        n += sizeof(POST_BODY_BOARD) - 1;
+        n += leaderboardEncode(&merged, body + n, LEADERBOARD_TEXT_SIZE);
+        body[n++] = '"';
+    }
+    memcpy(body + n, POST_BODY_STATE_END, sizeof(POST_BODY_STATE_END) - 1);
+    n += sizeof(POST_BODY_STATE_END) - 1;
+    if (shadow_version > 0) {
+        // AWS applies the update only if the shadow is still at this
+        // version, else rejects it with 409
+        memcpy(body + n, POST_BODY_VERSION, sizeof(POST_BODY_VERSION) - 1);
+        n += sizeof(POST_BODY_VERSION) - 1;
+        n += httpFormatUint(body + n, (unsigned long)shadow_version);
+    }
+    return n;
+}
+
+// The answer to the request in flight arrived with this status. Returns 0
+// if its document should be applied.
+static int requestDone(int status) {
+    uint32_t ticks = shadow_now() - shadow_started;
+
+    shadow_state = SHADOW_IDLE;
+    if (ticks > stats.max_ticks) {
+        stats.max_ticks = ticks;
+    }
+    if (inflight_read) {
+        // The read a conditional post was waiting for
+        read_first = 0;
+        if (status == HTTP_NOT_FOUND) {
+            LOG_INFO("Shadow: no document yet\r\n");
+            shadow_version = 0;     // The first write creates it
+            leaderboardClear(&board);
+            return -1;
+        }
+    }
+    if (status == HTTP_CONFLICT && !inflight_read) {
+        // Another device wrote since our last read: re-read, then post
+        // again only if the score still beats the one stored, with the
+        // entries merged into the table read
+        stats.conflicts++;
+        if (++post_conflicts > AWS_SHADOW_MAX_CONFLICTS) {
+            LOG_WARN("Shadow: score %d and %d entries dropped after %d conflicts\r\n",
+                     inflight_post, pending.count, post_conflicts - 1);
+            leaderboardClear(&pending);
+        } else if (inflight_post >= 0 && (!post_pending || inflight_post > post_score)) {
+            post_score = inflight_post;
+            post_pending = 1;
+        }
+        read_first = 1;
+        return -1;
+    }
+    if (status < 200 || status > 299) {
+        LOG_WARN("Shadow: status %d\r\n", status);
+        stats.failures++;
+        if (!inflight_read) {
+            // Refused, not lost: sending the same entries again won't help
+            leaderboardClear(&pending);
+        }
+        return -1;
+    }
+    stats.responses++;
+    if (!inflight_read) {
+        int i;
+        post_conflicts = 0;
+        // The shadow has the table as posted, even if the answer omits it
+        leaderboardMerge(&board, &inflight_entries);
+        for (i = 0; i < inflight_entries.count; i++) {
+            int at = leaderboardFind(&pending, &inflight_entries.entries[i]);
+            if (at >= 0) {
+                leaderboardRemove(&pending, at);
+            }
+        }
+    }
+    return 0;
+}
+
+// Cache the version, leaderboard and high score of a parsed document: the
+// score devices post (desired, or a delta against it), else one reported by
+// a device
+static void applyDocument(const JsonField *version, const JsonField *desired,
+                          const JsonField *delta, const JsonField *reported,
+                          const JsonField *table) {
+    int score = -1;
+
+    if (version->found) {
+        shadow_version = version->num;
+    }
+    if (table->found) {
+        if (strlen(table->str) >= BOARD_TEXT_SIZE - 1 || leaderboardDecode(&board, table->str) < 0) {
+            LOG_WARN("Shadow: bad leaderboard ignored\r\n");
+        } else {
+            prunePending();
+        }
+    }
+    if (desired->found) {
+        score = (int)desired->num;
+    } else if (delta && delta->found) {
+        score = (int)delta->num;
+    } else if (reported->found) {
+        score = (int)reported->num;
+    }
+    LOG_DEBUG("Shadow: highscore %d, version %ld\r\n", score, shadow_version);
+    if (score >= 0 && score != high_score) {
+        high_score = score;
+        if (shadow_changed) {
+            shadow_changed(score);
+        }
+    }
+}
+
+#ifdef AWS_SHADOW_HTTP
+//*****************************************************************************
+// REST over HTTPS: one request at a time on the kept-alive connection
+//*****************************************************************************
+
+#define SHADOW_PATH "/things/CC3200/shadow"
+
+// Constant parts of the requests; Host and Content-Length are added once at init
+#define GET_HEAD            "GET " SHADOW_PATH " HTTP/1.1\r\n" \
+                            "Connection: Keep-Alive\r\n"
+#define POST_HEAD           "POST " SHADOW_PATH " HTTP/1.1\r\n" \
+                            "Connection: Keep-Alive\r\n" \
+                            "Content-Type: application/json; charset=utf-8\r\n"
+
+static int shadow_sock = -1;            // Borrowed from tls_conn while a request runs
+static char get_buf[AWS_SHADOW_GET_SIZE];
+static char post_buf[AWS_SHADOW_POST_SIZE];
+static HttpRequest get_req;
+static HttpRequest post_req;
+static const char *tx_data;             // get_buf or post_buf
+static int tx_len = 0;
+static int tx_sent = 0;
+static char rx_buf[AWS_SHADOW_RX_SIZE];
+static HttpParser parser;
+
+// Shadow document fields read from every response body
+enum { FIELD_DESIRED, FIELD_REPORTED, FIELD_BOARD, FIELD_VERSION, FIELD_COUNT };
+static JsonField fields[FIELD_COUNT] = {
+    { "state.desired.highscore", JSON_INT },
+    { "state.reported.highscore", JSON_INT },
+    { "state.desired.leaderboard", JSON_STRING, board_text, sizeof(board_text) },
+    { "version", JSON_INT }
+};
+
+static void transportInit(const char *host) {
+    int room;
+
+    shadow_sock = -1;
+    // Everything but the score is composed here, once
+    shadow_ready = httpRequestInit(&get_req, get_buf, sizeof(get_buf),
+                                   HTTP_HEAD(GET_HEAD), host, 0) == 0 &&
+                   httpRequestInit(&post_req, post_buf, sizeof(post_buf),
+                                   HTTP_HEAD(POST_HEAD), host, 1) == 0;
+    if (shadow_ready) {
+        post_body = httpRequestBody(&post_req, &room);
+        shadow_ready = room >= (int)POST_BODY_MAX;
+    }
+}
+
+static int transportOnline(void) {
+    return tlsConnState() == TLS_CONN_UP;
+}
+
+// Transport error: the socket's state is unknown, so the connection is
+// dropped and the request queued again
+static void shadowFail(const char *what, long err) {
+    LOG_ERROR("Shadow: %s failed (%ld)\r\n", what, err);
+    stats.failures++;
+    tlsConnFail(err);
+    shadow_sock = -1;
+    requeue();
+}
+
+// Body bytes from the HTTP parser go straight to the JSON extractor
+static void onBody(void *user, const char *data, int len) {
+    (void)user;
+    jsonStreamFeed(&json, data, len);
+}
+
+static void handleResponse(void) {
+    if (requestDone(parser.status) < 0) {
+        return;
+    }
+    if (jsonStreamFinish(&json) < 0) {
+        if (parser.body_bytes) {
+            LOG_WARN("Shadow: bad JSON body (error %d)\r\n", json.error);
+        }
+        return;
+    }
+    applyDocument(&fields[FIELD_VERSION], &fields[FIELD_DESIRED], NULL, &fields[FIELD_REPORTED],
+                  &fields[FIELD_BOARD]);
+}
+
+static void transportPoll(void) {
+    long ret;
+    int n;
+
+    tlsConnPoll(shadow_state != SHADOW_IDLE);
+
+    if (shadow_state == SHADOW_IDLE) {
+        // An idle connection gets a read before the server drops it; it
+        // also refreshes the cached score
+        if (tlsConnKeepAliveDue()) {
+            get_pending = 1;
+        }
+        if (!requestQueued()) {
+            return;
+        }
+        // Requests wait while the connection is being (re)established
+        shadow_sock = tlsConnAcquire();
+        if (shadow_sock < 0) {
+            return;
+        }
+        nextRequest();
+        if (!inflight_read) {
+            n = buildPostBody();
+            memcpy(post_body + n, POST_BODY_END, sizeof(POST_BODY_END) - 1);
+            tx_data = post_buf;
+            tx_len = httpRequestFinish(&post_req, n + (int)sizeof(POST_BODY_END) - 1);
+        } else {
+            tx_data = get_buf;
+            tx_len = get_req.len;
+        }
+        tx_sent = 0;
+        httpParserInit(&parser, onBody, NULL);
+        jsonStreamInit(&json, fields, FIELD_COUNT);
+        shadow_state = SHADOW_SENDING;
+    }
+
+    if (shadow_now() - shadow_started > shadow_timeout) {
+        shadowFail("request timeout", 0);
+        return;
+    }
+
+    if (shadow_state == SHADOW_SENDING) {
+        // The whole request in one send unless the socket takes less
+        ret = sl_Send(shadow_sock, tx_data + tx_sent, tx_len - tx_sent, 0);
+        if (ret == SL_EAGAIN) {
+            return;
+        }
+        if (ret < 0) {
+            shadowFail("send", ret);
+            return;
+        }
+        tx_sent += ret;
+        if (tx_sent < tx_len) {
+            return;
+        }
+        shadow_state = SHADOW_RECEIVING;
+    }
+
+    // SHADOW_RECEIVING: parse whatever has arrived, one call per poll
+    ret = sl_Recv(shadow_sock, rx_buf, sizeof(rx_buf), 0);
+    if (ret == SL_EAGAIN) {
+        return;
+    }
+    if (ret == 0) {
+        // Closing is how a response without a length ends its body
+        if (httpParserFinish(&parser) < 0) {
+            shadowFail("receive (closed by server)", parser.error);
+            return;
+        }
+        tlsConnClose();
+        handleResponse();
+        return;
+    }
+    if (ret < 0) {
+        shadowFail("receive", ret);
+        return;
+    }
+    if (httpParserFeed(&parser, rx_buf, (int)ret) < 0) {
+        shadowFail("response parse", parser.error);
+        return;
+    }
+    if (parser.done) {
+        tlsConnRelease();
+        if (!parser.keep_alive) {
+            tlsConnClose();
+        }
+        handleResponse();
+    }
+}
+
+#else
+//*****************************************************************************
+// MQTT: requests are QoS 1 publishes to the shadow topics; answers, and
+// changes made by other devices, arrive on the subscribed ones
+//*****************************************************************************
+
+#define THING_TOPIC         "$aws/things/CC3200/shadow"
+#define CLIENT_TOKEN        "\"clientToken\":\""
+#define TOKEN_SIZE          24      // AWS_SHADOW_CLIENT_ID "-" sequence number
+#define PAYLOAD_SIZE        (POST_BODY_MAX + sizeof(CLIENT_TOKEN) + TOKEN_SIZE + 3)
+
+enum {
+    TOPIC_GET_ACCEPTED,
+    TOPIC_GET_REJECTED,
+    TOPIC_UPDATE_ACCEPTED,
+    TOPIC_UPDATE_REJECTED,
+    TOPIC_UPDATE_DELTA,
+    TOPIC_COUNT
+};
+static const char *const topics[TOPIC_COUNT] = {
+    THING_TOPIC "/get/accepted",
+    THING_TOPIC "/get/rejected",
+    THING_TOPIC "/update/accepted",
+    THING_TOPIC "/update/rejected",
+    THING_TOPIC "/update/delta"
+};
+
+static char payload[PAYLOAD_SIZE];       // Update; POST_BODY_PREFIX stays in place
+static char get_payload[sizeof(CLIENT_TOKEN) + TOKEN_SIZE + 3];
+static char inflight_token[TOKEN_SIZE];
+static unsigned long token_seq = 0;
+static char token[TOKEN_SIZE];          // clientToken of the message being parsed
+static int message_topic;
+
+// Fields read from every message; accepted documents and deltas carry the
+// score and leaderboard, rejections an error code, answers the requester's
+// client token. Both leaderboard paths share one buffer; a message has one.
+enum {
+    FIELD_DESIRED, FIELD_REPORTED, FIELD_DELTA, FIELD_BOARD, FIELD_DELTA_BOARD,
+    FIELD_VERSION, FIELD_CODE, FIELD_TOKEN, FIELD_COUNT
+};
+static JsonField fields[FIELD_COUNT] = {
+    { "state.desired.highscore", JSON_INT },
+    { "state.reported.highscore", JSON_INT },
+    { "state.highscore", JSON_INT },
+    { "state.desired.leaderboard", JSON_STRING, board_text, sizeof(board_text) },
+    { "state.leaderboard", JSON_STRING, board_text, sizeof(board_text) },
+    { "version", JSON_INT },
+    { "code", JSON_INT },
+    { "clientToken", JSON_STRING, token, sizeof(token) }
+};
+
+static void onConnected(void) {
+    // Changes published while the session was down were missed
+    get_pending = 1;
+}
+
+static void onMessageStart(int sub, long len) {
+    (void)len;
+    message_topic = sub;
+    jsonStreamInit(&json, fields, FIELD_COUNT);
+}
+
+static void onMessageData(const char *data, int len) {
+    jsonStreamFeed(&json, data, len);
+}
+
+// Answers go to every subscriber of the thing; the client token tells ours
+static void onMessageEnd(void) {
+    int ours;
+
+    if (jsonStreamFinish(&json) < 0) {
+        LOG_WARN("Shadow: bad JSON message (error %d)\r\n", json.error);
+        return;
+    }
+    ours = shadow_state != SHADOW_IDLE && fields[FIELD_TOKEN].found &&
+           strcmp(token, inflight_token) == 0;
+
+    switch (message_topic) {
+    case TOPIC_GET_ACCEPTED:
+    case TOPIC_UPDATE_ACCEPTED:
+        // Another device's update is news too
+        if (!ours || requestDone(HTTP_OK) == 0) {
+            applyDocument(&fields[FIELD_VERSION], &fields[FIELD_DESIRED], NULL, &fields[FIELD_REPORTED],
+                          &fields[FIELD_BOARD]);
+        }
+        break;
+    case TOPIC_GET_REJECTED:
+    case TOPIC_UPDATE_REJECTED:
+        if (ours) {
+            requestDone(fields[FIELD_CODE].found ? (int)fields[FIELD_CODE].num : 0);
+        }
+        break;
+    case TOPIC_UPDATE_DELTA:
+        applyDocument(&fields[FIELD_VERSION], &fields[FIELD_DESIRED], &fields[FIELD_DELTA],
+                      &fields[FIELD_REPORTED], &fields[FIELD_DELTA_BOARD]);
+        break;
+    default:
+        break;
+    }
+}
+
+static const MqttHandlers handlers = {
+    onConnected, onMessageStart, onMessageData, onMessageEnd, NULL
+};
+
+static void transportInit(const char *host) {
+    (void)host;     // Only HTTP names the host; tls_conn connects by address
+    post_body = payload;
+    shadow_ready = sizeof(AWS_SHADOW_CLIENT_ID) + 11 <= TOKEN_SIZE;
+    mqttInit(&mqtt_tls_ops, AWS_SHADOW_CLIENT_ID, topics, TOPIC_COUNT, &handlers, shadow_now,
+             shadow_timeout);
+}
+
+static int transportOnline(void) {
+    return mqttReady();
+}
+
+// A fresh token per request, so a late answer to an abandoned one isn't
+// taken for the current one
+static void nextToken(void) {
+    int n = (int)strlen(AWS_SHADOW_CLIENT_ID);
+
+    memcpy(inflight_token, AWS_SHADOW_CLIENT_ID, n);
+    inflight_token[n++] = '-';
+    n += httpFormatUint(inflight_token + n, ++token_seq);
+    inflight_token[n] = '\0';
+}
+
+static int putToken(char *out) {
+    int len = (int)strlen(inflight_token);
+    int n = sizeof(CLIENT_TOKEN) - 1;
+
+    memcpy(out, CLIENT_TOKEN, n);
+    memcpy(out + n, inflight_token, len);
+    n += len;
+    out[n++] = '"';
+    return n;
+}
+
+static void transportPoll(void) {
+    const char *topic;
+    char *data;
+    int n;
+
+    mqttPoll();
+
+    if (shadow_state != SHADOW_IDLE) {
+        // mqtt_client resends a lost publish after reconnecting; an answer
+        // that still doesn't come means the request is asked again
+        if (shadow_now() - shadow_started > shadow_timeout) {
+            LOG_WARN("Shadow: no answer to %s\r\n", inflight_token);
+            stats.failures++;
+            requeue();
+        }
+        return;
+    }
+    // One publish at a time, and none until the session is up
+    if (!requestQueued() || !mqttReady() || mqttBusy()) {
+        return;
+    }
+    nextRequest();
+    nextToken();
+    if (!inflight_read) {
+        topic = THING_TOPIC "/update";
+        data = payload;
+        n = buildPostBody();
+        payload[n++] = ',';
+        n += putToken(payload + n);
+    } else {
+        // The token alone
+        topic = THING_TOPIC "/get";
+        data = get_payload;
+        get_payload[0] = '{';
+        n = 1 + putToken(get_payload + 1);
+    }
+    data[n++] = '}';
+    if (mqttPublish(topic, data, n, 1) < 0) {
+        LOG_ERROR("Shadow: publish of %d bytes refused\r\n", n);
+        stats.failures++;
+        requeue();
+        return;
+    }
+    shadow_state = SHADOW_RECEIVING;
+}
+
+#endif
@@ -0,0 +1,91 @@
+//*****************************************************************************
+// aws_shadow.h - Non-blocking AWS IoT device shadow client for the high score
+//
+// Requests are queued and driven by awsShadowPoll() from the main loop over
+// the non-blocking TLS connection owned by tls_conn, so callers never wait on
+// the network. The shadow is reached over MQTT (mqtt_client: one session
+// subscribed to the thing's get/update answer topics and its delta topic, so
+// other devices' updates arrive without polling), or with -DAWS_SHADOW_HTTP
+// over the REST API, one keep-alive request at a time. Requests that fail in
+// transport are retried once the connection is back. The last high score and
+// shadow version seen in a response are cached; awsShadowHighScore() returns
+// the score immediately and the change callback fires when a response carries
+// a different value.
+// Score updates carry the cached version, so a write based on a stale read is
+// rejected by AWS (409) instead of overwriting another device's score; the
+// client then re-reads and posts again only if its score is still higher.
+// The shadow also holds a top-N leaderboard (leaderboard.h). Submitted
+// entries are merged into the last table read and the whole table is written
+// with the version in one update, so a conflicting write is merged again
+// after a re-read rather than lost; the table is cached for display.
+//*****************************************************************************
+
+#ifndef UTILS_AWS_SHADOW_H_
+#define UTILS_AWS_SHADOW_H_
+
+#include <stdint.h>
+
+#include "leaderboard.h"
+
+#ifdef AWS_SHADOW_HTTP
+#define AWS_SHADOW_PORT      8443    // HTTPS REST endpoint
+#else
+#define AWS_SHADOW_PORT      8883    // MQTT over TLS
+#endif
+#ifndef AWS_SHADOW_CLIENT_ID
+#define AWS_SHADOW_CLIENT_ID "CC3200"   // MQTT client ID; unique per device
+#endif
+
+#define AWS_SHADOW_GET_SIZE  192     // Composed GET request (host name included)
+#define AWS_SHADOW_POST_SIZE 512     // Composed POST headers and body (leaderboard included)
+#define AWS_SHADOW_MAX_CONFLICTS 3   // Re-read and retry a post this often
+#define AWS_SHADOW_RX_SIZE   1460    // One TLS record's worth per sl_Recv
+
+// Called from awsShadowPoll() when a response changes the cached high score
+typedef void (*AwsShadowChanged)(int high_score);
+
+typedef struct {
+    unsigned long requests;     // Requests sent
+    unsigned long responses;    // Complete 2xx responses (accepted, over MQTT)
+    unsigned long failures;     // Send/receive errors, timeouts, non-2xx status or rejections
+    unsigned long conflicts;    // Posts rejected for a stale version (409)
+    uint32_t max_ticks;         // Longest request-to-response time
+} AwsShadowStats;
+
+// host is the Host header value (HTTP only). now() returns free-running
+// ticks; a request with no complete response after timeout_ticks fails (over
+// HTTP the connection is dropped too). tlsConnInit() must have been called.
+void awsShadowInit(const char *host, uint32_t (*now)(void), uint32_t timeout_ticks,
+                   AwsShadowChanged on_change);
+
+// Non-zero while the TLS connection (and over MQTT the session) is up
+int awsShadowOnline(void);
+
+// Queue a shadow read. Repeated calls before it is sent collapse into one.
+void awsShadowRequestGet(void);
+
+// Queue desired.highscore = score, written only if higher than the shadow's.
+// A single versioned update when the version is known; the highest queued
+// score wins.
+void awsShadowPostScore(int score);
+
+// Queue a leaderboard entry, sent with the next update. Returns its position
+// in the cached table, or -1 if it doesn't make the table.
+int awsShadowSubmit(const LeaderboardEntry *entry);
+
+// Cached leaderboard with the entries not yet written included; no request
+void awsShadowLeaderboard(Leaderboard *out);
+
+// Cached high score, or fallback until a response has been seen
+int awsShadowHighScore(int fallback);
+
+// Advance the connection and the request/response state machine; never
+// blocks except for a DNS lookup before the first connect and after failures
+void awsShadowPoll(void);
+
+// Non-zero when nothing is queued or in flight (entries included)
+int awsShadowIdle(void);
+
+void awsShadowGetStats(AwsShadowStats *out);
+
+#endif /* UTILS_AWS_SHADOW_H_ */
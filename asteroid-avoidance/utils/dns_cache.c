@@ -0,0 +1,108 @@
+//*****************************************************************************
+// dns_cache.c - Resolved cloud endpoint address kept on the serial flash
+//*****************************************************************************
+
+#include "dns_cache.h"
+
+#include <string.h>
+
+#include "flash_store.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_INFO
+#include "log.h"
+
+#define DNS_CACHE_MAGIC     0x31534E44UL    // "DNS1"
+
+// On-flash layout
+typedef struct {
+    uint32_t magic;
+    uint32_t host_hash;     // Host the address belongs to
+    uint32_t ip;            // Host byte order, 0 if none
+    uint32_t boots_left;    // Boots that may still use it
+} DnsCacheFile;
+
+static const char *cache_file;
+static uint32_t cache_host;
+static unsigned int cache_boots;
+static DnsCacheFile record;
+static int counted;                     // This boot has used up its share
+static DnsCacheStats stats;
+
+// FNV-1a; only has to tell the configured host from an earlier build's
+static uint32_t hostHash(const char *host) {
+    uint32_t h = 2166136261UL;
+
+    while (*host) {
+        h = (h ^ (unsigned char)*host++) * 16777619UL;
+    }
+    return h;
+}
+
+static void save(void) {
+    long ret = flashStoreWrite(cache_file, &record, sizeof(record), sizeof(record));
+    if (ret < 0) {
+        LOG_WARN("DNS cache: write failed (%ld)\r\n", ret);
+        stats.write_errors++;
+    }
+}
+
+long dnsCacheInit(const char *file, const char *host, unsigned int max_boots) {
+    long len;
+
+    cache_file = file;
+    cache_host = hostHash(host);
+    cache_boots = max_boots;
+    counted = 0;
+
+    len = flashStoreRead(file, &record, sizeof(record));
+    if (len != (long)sizeof(record) || record.magic != DNS_CACHE_MAGIC ||
+            record.host_hash != cache_host || record.ip == 0 || record.boots_left == 0) {
+        memset(&record, 0, sizeof(record));
+        return -1;
+    }
+    LOG_INFO("DNS cache: %lu.%lu.%lu.%lu, %lu boots left\r\n",
+             (unsigned long)(record.ip >> 24), (unsigned long)(record.ip >> 16 & 0xFF),
+             (unsigned long)(record.ip >> 8 & 0xFF), (unsigned long)(record.ip & 0xFF),
+             (unsigned long)record.boots_left);
+    return 0;
+}
+
+unsigned long dnsCacheLookup(void) {
+    if (record.ip == 0) {
+        return 0;
+    }
+    if (!counted) {
+        counted = 1;
+        record.boots_left--;
+        save();
+    }
+    stats.hits++;
+    return record.ip;
+}
+
+void dnsCacheStore(unsigned long ip) {
+    if (cache_file == NULL || ip == 0) {
+        return;
+    }
+    record.magic = DNS_CACHE_MAGIC;
+    record.host_hash = cache_host;
+    record.ip = ip;
+    record.boots_left = cache_boots;
+    counted = 1;
+    save();
+    stats.stores++;
+}
+
+void dnsCacheInvalidate(void) {
+    if (record.ip == 0) {
+        return;
+    }
+    LOG_INFO("DNS cache: address dropped\r\n");
+    record.ip = 0;
+    save();
+    stats.invalidations++;
+}
+
+void dnsCacheGetStats(DnsCacheStats *out) {
+    *out = stats;
+}
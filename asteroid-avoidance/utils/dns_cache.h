@@ -0,0 +1,41 @@
+//*****************************************************************************
+// dns_cache.h - Resolved cloud endpoint address kept on the serial flash
+//
+// The blocking DNS lookup before the first connect is skipped while the
+// address from an earlier session is fresh. The network processor's clock
+// restarts at every boot, so the lifetime is counted in boots that use the
+// address rather than in seconds. tls_conn stores an address only after a
+// connection to it succeeded and drops it when a connect to it fails, so a
+// moved endpoint costs one failed attempt before a fresh lookup.
+//*****************************************************************************
+
+#ifndef UTILS_DNS_CACHE_H_
+#define UTILS_DNS_CACHE_H_
+
+#include <stdint.h>
+
+typedef struct {
+    unsigned long hits;             // Connects started from the cached address
+    unsigned long stores;           // Fresh addresses saved
+    unsigned long invalidations;    // Cached addresses that failed to connect
+    unsigned long write_errors;
+} DnsCacheStats;
+
+// Read the address saved for host from file; it serves max_boots boots
+// after it was resolved. The network processor must be running (file
+// system). Returns 0, or -1 if nothing usable was saved.
+long dnsCacheInit(const char *file, const char *host, unsigned int max_boots);
+
+// Cached address of the host, or 0 if none. The first hit in a boot uses up
+// one boot of its lifetime.
+unsigned long dnsCacheLookup(void);
+
+// A connection to ip, freshly resolved, succeeded
+void dnsCacheStore(unsigned long ip);
+
+// A connection to the cached address failed: resolve again from now on
+void dnsCacheInvalidate(void);
+
+void dnsCacheGetStats(DnsCacheStats *out);
+
+#endif /* UTILS_DNS_CACHE_H_ */
@@ -0,0 +1,32 @@
+//*****************************************************************************
+// fixed_point.h - Q8.8 fixed-point helpers for sub-pixel game kinematics
+//*****************************************************************************
+
+#ifndef UTILS_FIXED_POINT_H_
+#define UTILS_FIXED_POINT_H_
+
+#include <stdint.h>
+
+// Q8.8 value: 8 fractional bits. Stored in 32 bits so positions well off the
+// 128x128 screen (spawn above, exit below) never overflow.
+typedef int32_t fix8_t;
+
+#define FIX_SHIFT               8
+#define FIX_ONE                 (1 << FIX_SHIFT)
+#define FIX_HALF                (FIX_ONE / 2)
+
+// Conversions. FIX_TO_INT floors (arithmetic shift), FIX_ROUND rounds to nearest.
+#define INT_TO_FIX(i)           ((fix8_t)(i) * FIX_ONE)
+#define FIX_TO_INT(f)           ((int)((f) >> FIX_SHIFT))
+#define FIX_ROUND(f)            ((int)(((f) + FIX_HALF) >> FIX_SHIFT))
+
+// Build a constant from a ratio, e.g. FIX_FROM_RATIO(5, 2) == 2.5
+#define FIX_FROM_RATIO(n, d)    ((fix8_t)(((n) * FIX_ONE) / (d)))
+
+// Arithmetic. Products use a 64-bit intermediate (single UMULL/SMULL on M4).
+#define FIX_MUL(a, b)           ((fix8_t)(((int64_t)(a) * (b)) >> FIX_SHIFT))
+#define FIX_DIV(a, b)           ((fix8_t)(((int64_t)(a) * FIX_ONE) / (b)))
+#define FIX_LERP(a, b, t)       ((a) + FIX_MUL((b) - (a), (t)))
+#define FIX_CLAMP(v, lo, hi)    ((v) < (lo) ? (lo) : ((v) > (hi) ? (hi) : (v)))
+
+#endif /* UTILS_FIXED_POINT_H_ */
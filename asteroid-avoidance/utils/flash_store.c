@@ -0,0 +1,47 @@
+//*****************************************************************************
+// flash_store.c - Small whole-file records on the serial flash (SimpleLink FS)
+//*****************************************************************************
+
+#include "flash_store.h"
+
+#include "simplelink.h"
+
+long flashStoreRead(const char *name, void *buf, unsigned long len) {
+    long handle;
+    long ret;
+
+    ret = sl_FsOpen((unsigned char *)name, FS_MODE_OPEN_READ, NULL, &handle);
+    if (ret < 0) {
+        return ret;
+    }
+    ret = sl_FsRead(handle, 0, (unsigned char *)buf, len);
+    sl_FsClose(handle, NULL, NULL, 0);
+    return ret;
+}
+
+long flashStoreWrite(const char *name, const void *buf, unsigned long len, unsigned long max_size) {
+    long handle;
+    long ret;
+
+    if (len > max_size) {
+        return -1;
+    }
+    ret = sl_FsOpen((unsigned char *)name, FS_MODE_OPEN_WRITE, NULL, &handle);
+    if (ret < 0) {
+        // First save: the maximum size is fixed when the file is created
+        ret = sl_FsOpen((unsigned char *)name,
+                        FS_MODE_OPEN_CREATE(max_size, _FS_FILE_OPEN_FLAG_COMMIT | _FS_FILE_PUBLIC_WRITE),
+                        NULL, &handle);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+    ret = sl_FsWrite(handle, 0, (unsigned char *)buf, len);
+    if (ret < 0 || (unsigned long)ret != len) {
+        // Closing with a signature aborts the write and keeps the old copy
+        sl_FsClose(handle, NULL, (unsigned char *)"A", 1);
+        return ret < 0 ? ret : -1;
+    }
+    ret = sl_FsClose(handle, NULL, NULL, 0);
+    return ret < 0 ? ret : 0;
+}
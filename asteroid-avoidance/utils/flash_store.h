@@ -0,0 +1,19 @@
+//*****************************************************************************
+// flash_store.h - Small whole-file records on the serial flash (SimpleLink FS)
+//
+// The network processor must be running (sl_Start) before any call.
+//*****************************************************************************
+
+#ifndef UTILS_FLASH_STORE_H_
+#define UTILS_FLASH_STORE_H_
+
+// Read up to len bytes from the start of the file. Returns the number of
+// bytes read, or a negative SimpleLink error (e.g. the file doesn't exist).
+long flashStoreRead(const char *name, void *buf, unsigned long len);
+
+// Replace the file's contents with len bytes. The file is created on first
+// use with room for max_size bytes (fail-safe, so a reset mid-write keeps
+// the previous copy). Returns 0 on success or a negative SimpleLink error.
+long flashStoreWrite(const char *name, const void *buf, unsigned long len, unsigned long max_size);
+
+#endif /* UTILS_FLASH_STORE_H_ */
@@ -0,0 +1,413 @@
+//*****************************************************************************
+// http_parser.c - Incremental HTTP/1.1 response parser
+//*****************************************************************************
+
+#include "http_parser.h"
+
+#include <string.h>
+
+enum {
+    ST_VERSION,             // "HTTP/1." then the minor digit
+    ST_STATUS_SP,
+    ST_STATUS_CODE,
+    ST_REASON,
+    ST_STATUS_LF,
+    ST_HDR_START,           // Start of a header line, or the blank line
+    ST_HDR_NAME,
+    ST_HDR_VALUE_LWS,
+    ST_HDR_VALUE,
+    ST_HDR_LF,
+    ST_HDRS_END_LF,
+    ST_BODY_LENGTH,
+    ST_BODY_CLOSE,
+    ST_CHUNK_SIZE,
+    ST_CHUNK_EXT,
+    ST_CHUNK_SIZE_LF,
+    ST_CHUNK_DATA,
+    ST_CHUNK_DATA_CR,
+    ST_CHUNK_DATA_LF,
+    ST_TRAILER_START,
+    ST_TRAILER,
+    ST_TRAILER_END_LF,
+    ST_DONE,
+    ST_ERROR
+};
+
+// Framing headers
+enum {
+    HDR_OTHER,
+    HDR_CONTENT_LENGTH,
+    HDR_TRANSFER_ENCODING,
+    HDR_CONNECTION
+};
+
+#define TOKEN_OVERFLOW      (HTTP_TOKEN_SIZE + 1)   // token_len once a name/value didn't fit
+#define MAX_CONTENT_LENGTH  0x0FFFFFFFUL            // 256 MB; more is certainly wrong here
+#define MAX_CHUNK_SIZE      0x0FFFFFFFUL
+
+static const char http_version[] = "HTTP/1.";
+
+void httpParserInit(HttpParser *p, HttpBodyFn on_body, void *user) {
+    memset(p, 0, sizeof(*p));
+    p->on_body = on_body;
+    p->user = user;
+    p->content_length = -1;
+    p->state = ST_VERSION;
+}
+
+static int fail(HttpParser *p, HttpError err) {
+    p->error = err;
+    p->state = ST_ERROR;
+    return HTTP_PARSE_ERROR;
+}
+
+static char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+}
+
+// Keep up to HTTP_TOKEN_SIZE - 1 lowercase characters for comparison
+static void tokenPut(HttpParser *p, char c) {
+    if (p->token_len < HTTP_TOKEN_SIZE - 1) {
+        p->token[p->token_len++] = lower(c);
+    } else {
+        p->token_len = TOKEN_OVERFLOW;
+    }
+}
+
+static int tokenIs(HttpParser *p, const char *s) {
+    return p->token_len < HTTP_TOKEN_SIZE && strlen(s) == p->token_len &&
+           memcmp(p->token, s, p->token_len) == 0;
+}
+
+static void nameDone(HttpParser *p) {
+    if (tokenIs(p, "content-length")) {
+        p->header = HDR_CONTENT_LENGTH;
+        p->content_length = 0;
+    } else if (tokenIs(p, "transfer-encoding")) {
+        p->header = HDR_TRANSFER_ENCODING;
+    } else if (tokenIs(p, "connection")) {
+        p->header = HDR_CONNECTION;
+    } else {
+        p->header = HDR_OTHER;
+    }
+    p->token_len = 0;
+}
+
+static int valueDone(HttpParser *p) {
+    if (p->token_len < HTTP_TOKEN_SIZE) {
+        p->token[p->token_len] = '\0';
+    }
+    switch (p->header) {
+    case HDR_CONTENT_LENGTH:
+        // token_len counted digits
+        if (p->token_len == 0) {
+            return fail(p, HTTP_ERR_LENGTH);
+        }
+        break;
+    case HDR_TRANSFER_ENCODING:
+        // "chunked" must be the last coding; a long list overflows the token
+        // and is treated as not chunked, which then fails on framing
+        if (p->token_len >= 7 && p->token_len < HTTP_TOKEN_SIZE &&
+            memcmp(p->token + p->token_len - 7, "chunked", 7) == 0) {
+            p->chunked = 1;
+        }
+        break;
+    case HDR_CONNECTION:
+        if (tokenIs(p, "close")) {
+            p->keep_alive = 0;
+        } else if (tokenIs(p, "keep-alive")) {
+            p->keep_alive = 1;
+        }
+        break;
+    default:
+        break;
+    }
+    p->header = HDR_OTHER;
+    p->token_len = 0;
+    return 0;
+}
+
+// Blank line seen: pick the body framing
+static void headersDone(HttpParser *p) {
+    p->headers_done = 1;
+    p->token_len = 0;
+    if (p->status >= 100 && p->status < 200) {
+        // Interim response (100 Continue): the real one follows
+        HttpBodyFn on_body = p->on_body;
+        void *user = p->user;
+        httpParserInit(p, on_body, user);
+        return;
+    }
+    if (p->status == 204 || p->status == 304) {
+        p->state = ST_DONE;
+    } else if (p->chunked) {
+        p->remaining = 0;
+        p->state = ST_CHUNK_SIZE;
+    } else if (p->content_length >= 0) {
+        p->remaining = (unsigned long)p->content_length;
+        p->state = p->remaining ? ST_BODY_LENGTH : ST_DONE;
+    } else {
+        p->keep_alive = 0;
+        p->state = ST_BODY_CLOSE;
+    }
+}
+
+static void body(HttpParser *p, const char *data, int len) {
+    p->body_bytes += len;
+    if (p->on_body) {
+        p->on_body(p->user, data, len);
+    }
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c = lower(c);
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+int httpParserFeed(HttpParser *p, const char *data, int len) {
+    int i = 0;
+
+    while (i < len) {
+        char c = data[i];
+
+        // Body states move whole runs at once
+        if (p->state == ST_BODY_LENGTH || p->state == ST_CHUNK_DATA) {
+            int n = len - i;
+            if ((unsigned long)n > p->remaining) {
+                n = (int)p->remaining;
+            }
+            body(p, data + i, n);
+            i += n;
+            p->remaining -= n;
+            if (p->remaining == 0) {
+                p->state = (p->state == ST_BODY_LENGTH) ? ST_DONE : ST_CHUNK_DATA_CR;
+            }
+            continue;
+        }
+        if (p->state == ST_BODY_CLOSE) {
+            body(p, data + i, len - i);
+            return len;
+        }
+        if (p->state == ST_DONE) {
+            break;
+        }
+        if (p->state == ST_ERROR) {
+            return HTTP_PARSE_ERROR;
+        }
+
+        if (!p->headers_done || p->state >= ST_TRAILER_START) {
+            if (++p->header_bytes > HTTP_MAX_HEADER_BYTES) {
+                return fail(p, HTTP_ERR_TOO_LONG);
+            }
+        }
+        i++;
+
+        switch (p->state) {
+        case ST_VERSION:
+            if (p->token_len < sizeof(http_version) - 1) {
+                if (c != http_version[p->token_len]) {
+                    return fail(p, HTTP_ERR_STATUS_LINE);
+                }
+                p->token_len++;
+            } else if (c >= '0' && c <= '9') {
+                p->version_minor = (uint8_t)(c - '0');
+                p->keep_alive = p->version_minor >= 1;
+                p->token_len = 0;
+                p->state = ST_STATUS_SP;
+            } else {
+                return fail(p, HTTP_ERR_STATUS_LINE);
+            }
+            break;
+        case ST_STATUS_SP:
+            if (c != ' ') {
+                return fail(p, HTTP_ERR_STATUS_LINE);
+            }
+            p->state = ST_STATUS_CODE;
+            break;
+        case ST_STATUS_CODE:
+            if (c >= '0' && c <= '9' && p->token_len < 3) {
+                p->status = p->status * 10 + (c - '0');
+                p->token_len++;
+            } else if (p->token_len == 3 && (c == ' ' || c == '\r' || c == '\n')) {
+                p->token_len = 0;
+                p->state = (c == ' ') ? ST_REASON : (c == '\r') ? ST_STATUS_LF : ST_HDR_START;
+            } else {
+                return fail(p, HTTP_ERR_STATUS_LINE);
+            }
+            break;
+        case ST_REASON:
+            if (c == '\r') {
+                p->state = ST_STATUS_LF;
+            } else if (c == '\n') {
+                p->state = ST_HDR_START;
+            }
+            break;
+        case ST_STATUS_LF:
+            if (c != '\n') {
+                return fail(p, HTTP_ERR_STATUS_LINE);
+            }
+            p->state = ST_HDR_START;
+            break;
+
+        case ST_HDR_START:
+            if (c == '\r') {
+                p->state = ST_HDRS_END_LF;
+            } else if (c == '\n') {
+                headersDone(p);
+            } else if (c == ' ' || c == '\t' || c == ':') {
+                // Folded continuation lines are obsolete; AWS never sends them
+                return fail(p, HTTP_ERR_HEADER);
+            } else {
+                p->token_len = 0;
+                tokenPut(p, c);
+                p->state = ST_HDR_NAME;
+            }
+            break;
+        case ST_HDR_NAME:
+            if (c == ':') {
+                nameDone(p);
+                p->state = ST_HDR_VALUE_LWS;
+            } else if (c == '\r' || c == '\n' || c == ' ' || c == '\t') {
+                return fail(p, HTTP_ERR_HEADER);
+            } else {
+                tokenPut(p, c);
+            }
+            break;
+        case ST_HDR_VALUE_LWS:
+            if (c == ' ' || c == '\t') {
+                break;
+            }
+            p->state = ST_HDR_VALUE;
+            // fall through
+        case ST_HDR_VALUE:
+            if (c == '\r' || c == '\n') {
+                if (valueDone(p) < 0) {
+                    return HTTP_PARSE_ERROR;
+                }
+                p->state = (c == '\r') ? ST_HDR_LF : ST_HDR_START;
+            } else if (p->header == HDR_CONTENT_LENGTH) {
+                if (c >= '0' && c <= '9' && p->token_len != TOKEN_OVERFLOW) {
+                    if ((unsigned long)p->content_length > (MAX_CONTENT_LENGTH - 9) / 10) {
+                        return fail(p, HTTP_ERR_LENGTH);
+                    }
+                    p->content_length = p->content_length * 10 + (c - '0');
+                    p->token_len = 1;
+                } else if ((c == ' ' || c == '\t') && p->token_len) {
+                    p->token_len = TOKEN_OVERFLOW;  // Trailing space: no more digits
+                } else {
+                    return fail(p, HTTP_ERR_LENGTH);
+                }
+            } else if (p->header != HDR_OTHER) {
+                tokenPut(p, c);
+            }
+            break;
+        case ST_HDR_LF:
+            if (c != '\n') {
+                return fail(p, HTTP_ERR_HEADER);
+            }
+            p->state = ST_HDR_START;
+            break;
+        case ST_HDRS_END_LF:
+            if (c != '\n') {
+                return fail(p, HTTP_ERR_HEADER);
+            }
+            headersDone(p);
+            break;
+
+        case ST_CHUNK_SIZE: {
+            int v = hexValue(c);
+            if (v >= 0) {
+                if (p->remaining > MAX_CHUNK_SIZE / 16) {
+                    return fail(p, HTTP_ERR_CHUNK);
+                }
+                p->remaining = p->remaining * 16 + v;
+                p->token_len = 1;
+            } else if (p->token_len == 0) {
+                return fail(p, HTTP_ERR_CHUNK);
+            } else if (c == '\r') {
+                p->state = ST_CHUNK_SIZE_LF;
+            } else if (c == '\n') {
+                i--;                // Handle as the LF of a CRLF
+                p->state = ST_CHUNK_SIZE_LF;
+            } else if (c == ';' || c == ' ' || c == '\t') {
+                p->state = ST_CHUNK_EXT;
+            } else {
+                return fail(p, HTTP_ERR_CHUNK);
+            }
+            break;
+        }
+        case ST_CHUNK_EXT:
+            if (c == '\r') {
+                p->state = ST_CHUNK_SIZE_LF;
+            } else if (c == '\n') {
+                i--;
+                p->state = ST_CHUNK_SIZE_LF;
+            }
+            break;
+        case ST_CHUNK_SIZE_LF:
+            if (c != '\n') {
+                return fail(p, HTTP_ERR_CHUNK);
+            }
+            p->token_len = 0;
+            p->state = p->remaining ? ST_CHUNK_DATA : ST_TRAILER_START;
+            break;
+        case ST_CHUNK_DATA_CR:
+            if (c == '\r') {
+                p->state = ST_CHUNK_DATA_LF;
+            } else if (c == '\n') {
+                p->state = ST_CHUNK_SIZE;
+            } else {
+                return fail(p, HTTP_ERR_CHUNK);
+            }
+            break;
+        case ST_CHUNK_DATA_LF:
+            if (c != '\n') {
+                return fail(p, HTTP_ERR_CHUNK);
+            }
+            p->state = ST_CHUNK_SIZE;
+            break;
+        case ST_TRAILER_START:
+            if (c == '\r') {
+                p->state = ST_TRAILER_END_LF;
+            } else if (c == '\n') {
+                p->state = ST_DONE;
+            } else {
+                p->state = ST_TRAILER;
+            }
+            break;
+        case ST_TRAILER:
+            if (c == '\n') {
+                p->state = ST_TRAILER_START;
+            }
+            break;
+        case ST_TRAILER_END_LF:
+            if (c != '\n') {
+                return fail(p, HTTP_ERR_CHUNK);
+            }
+            p->state = ST_DONE;
+            break;
+        default:
+            return fail(p, HTTP_ERR_HEADER);
+        }
+    }
+    if (p->state == ST_DONE) {
+        p->done = 1;
+    }
+    return i;
+}
+
+int httpParserFinish(HttpParser *p) {
+    if (p->state == ST_BODY_CLOSE) {
+        p->state = ST_DONE;
+    }
+    if (p->state != ST_DONE) {
+        if (p->state != ST_ERROR) {
+            fail(p, HTTP_ERR_TRUNCATED);
+        }
+        return HTTP_PARSE_ERROR;
+    }
+    p->done = 1;
+    return 0;
+}
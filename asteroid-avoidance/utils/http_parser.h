@@ -0,0 +1,75 @@
+//*****************************************************************************
+// http_parser.h - Incremental HTTP/1.1 response parser
+//
+// Consumes a response in chunks of any size, byte-split anywhere, and keeps
+// only a few bytes of state. The status line and the headers that matter for
+// framing (Content-Length, Transfer-Encoding, Connection) are interpreted as
+// they stream past; other headers are skipped without being stored. Body
+// bytes are handed to a callback as pointers into the caller's chunk, so
+// nothing is copied, whether the body is sized by Content-Length, chunked,
+// or runs until the server closes the connection.
+//
+// The parser has no hardware or SimpleLink dependencies and can be built and
+// fuzzed on a host as is.
+//*****************************************************************************
+
+#ifndef UTILS_HTTP_PARSER_H_
+#define UTILS_HTTP_PARSER_H_
+
+#include <stdint.h>
+
+#define HTTP_MAX_HEADER_BYTES   4096    // Status line + headers (+ trailers)
+#define HTTP_TOKEN_SIZE         20      // Longest header name/value we compare
+
+// httpParserFeed() results besides a byte count
+#define HTTP_PARSE_ERROR        -1
+
+typedef enum {
+    HTTP_ERR_NONE,
+    HTTP_ERR_STATUS_LINE,       // Not "HTTP/1.x nnn ..."
+    HTTP_ERR_HEADER,            // Malformed header line
+    HTTP_ERR_TOO_LONG,          // Headers exceeded HTTP_MAX_HEADER_BYTES
+    HTTP_ERR_LENGTH,            // Bad or overflowing Content-Length
+    HTTP_ERR_CHUNK,             // Bad chunk size or framing
+    HTTP_ERR_TRUNCATED          // Connection closed before the body ended
+} HttpError;
+
+// Body bytes as they arrive; data points into the buffer given to
+// httpParserFeed() and is only valid during the call
+typedef void (*HttpBodyFn)(void *user, const char *data, int len);
+
+typedef struct {
+    // Results, valid once the headers are complete
+    int status;                 // e.g. 200
+    long content_length;        // -1 if not sent
+    uint8_t chunked;
+    uint8_t keep_alive;         // Connection can be reused after this response
+    uint8_t headers_done;
+    uint8_t done;               // Complete response parsed
+    HttpError error;
+    unsigned long body_bytes;
+
+    // Private
+    HttpBodyFn on_body;
+    void *user;
+    uint8_t state;
+    uint8_t header;             // Which framing header is being read
+    uint8_t token_len;
+    uint8_t version_minor;
+    char token[HTTP_TOKEN_SIZE];
+    uint16_t header_bytes;
+    unsigned long remaining;    // Body or chunk bytes left
+} HttpParser;
+
+void httpParserInit(HttpParser *p, HttpBodyFn on_body, void *user);
+
+// Parse len bytes. Returns the bytes consumed, which is less than len only
+// when the response ended inside the chunk (anything after it belongs to the
+// next response), or HTTP_PARSE_ERROR with p->error set.
+int httpParserFeed(HttpParser *p, const char *data, int len);
+
+// The connection was closed. Completes a body that runs until close;
+// returns 0 if the response is complete, else HTTP_PARSE_ERROR.
+int httpParserFinish(HttpParser *p);
+
+#endif /* UTILS_HTTP_PARSER_H_ */
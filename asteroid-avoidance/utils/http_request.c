@@ -0,0 +1,93 @@
+//*****************************************************************************
+// http_request.c - Precomposed HTTP/1.1 request buffers
+//*****************************************************************************
+
+#include "http_request.h"
+
+#include <string.h>
+
+#define HOST_HEADER     "Host: "
+#define LENGTH_HEADER   "Content-Length: "
+
+// Append n bytes if they fit
+static int put(HttpRequest *r, int *at, const char *s, int n) {
+    if (*at + n > r->size) {
+        return -1;
+    }
+    memcpy(r->buf + *at, s, n);
+    *at += n;
+    return 0;
+}
+
+int httpRequestInit(HttpRequest *r, char *buf, int size, const char *head, int head_len,
+                    const char *host, int has_body) {
+    static const char spaces[HTTP_LENGTH_DIGITS] = { ' ', ' ', ' ', ' ' };
+    int at = 0;
+    int ok;
+
+    r->buf = buf;
+    r->size = (uint16_t)size;
+    r->length_at = 0;
+    r->len = 0;
+
+    ok = put(r, &at, head, head_len) == 0 &&
+         put(r, &at, HOST_HEADER, sizeof(HOST_HEADER) - 1) == 0 &&
+         put(r, &at, host, (int)strlen(host)) == 0 &&
+         put(r, &at, "\r\n", 2) == 0;
+    if (ok && has_body) {
+        // Leading spaces before the digits are allowed whitespace, so the
+        // field never has to move
+        ok = put(r, &at, LENGTH_HEADER, sizeof(LENGTH_HEADER) - 1) == 0;
+        r->length_at = (uint16_t)at;
+        ok = ok && put(r, &at, spaces, HTTP_LENGTH_DIGITS) == 0 &&
+             put(r, &at, "\r\n", 2) == 0;
+    }
+    ok = ok && put(r, &at, "\r\n", 2) == 0;
+    if (!ok) {
+        r->head_len = 0;
+        return -1;
+    }
+    r->head_len = (uint16_t)at;
+    r->len = (uint16_t)at;
+    return 0;
+}
+
+char *httpRequestBody(const HttpRequest *r, int *room) {
+    *room = r->size - r->head_len;
+    return r->buf + r->head_len;
+}
+
+int httpFormatUint(char *out, unsigned long v) {
+    char tmp[20];
+    int n = 0;
+    int i;
+
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    for (i = 0; i < n; i++) {
+        out[i] = tmp[n - 1 - i];
+    }
+    return n;
+}
+
+int httpRequestFinish(HttpRequest *r, int body_len) {
+    char digits[20];
+    int n;
+
+    if (r->head_len == 0 || body_len < 0 || body_len > r->size - r->head_len) {
+        return -1;
+    }
+    if (r->length_at) {
+        n = httpFormatUint(digits, (unsigned long)body_len);
+        if (n > HTTP_LENGTH_DIGITS) {
+            return -1;
+        }
+        // Right-aligned in the reserved field
+        memset(r->buf + r->length_at, ' ', HTTP_LENGTH_DIGITS - n);
+        memcpy(r->buf + r->length_at + HTTP_LENGTH_DIGITS - n, digits, n);
+    }
+    r->len = (uint16_t)(r->head_len + body_len);
+    return r->len;
+}
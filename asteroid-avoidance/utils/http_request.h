@@ -0,0 +1,45 @@
+//*****************************************************************************
+// http_request.h - Precomposed HTTP/1.1 request buffers
+//
+// A request is composed once into a caller-owned buffer: the request line and
+// constant headers (a string literal whose length is known at compile time),
+// the Host header, and for requests with a body a Content-Length field
+// reserved at a fixed width. Sending again only means writing the body after
+// the headers and back-patching the reserved length, so the finished request
+// is one contiguous buffer for a single send.
+//*****************************************************************************
+
+#ifndef UTILS_HTTP_REQUEST_H_
+#define UTILS_HTTP_REQUEST_H_
+
+#include <stdint.h>
+
+#define HTTP_LENGTH_DIGITS  4       // Reserved Content-Length width (bodies < 10000)
+
+// Expands a string literal into the (head, head_len) arguments
+#define HTTP_HEAD(s)        s, (int)(sizeof(s) - 1)
+
+typedef struct {
+    char *buf;
+    uint16_t size;
+    uint16_t head_len;      // Everything up to and including the blank line
+    uint16_t length_at;     // Reserved Content-Length digits, 0 without a body
+    uint16_t len;           // Complete request
+} HttpRequest;
+
+// head holds the request line and constant headers, each ending in CRLF.
+// Returns 0, or -1 if buf is too small.
+int httpRequestInit(HttpRequest *r, char *buf, int size, const char *head, int head_len,
+                    const char *host, int has_body);
+
+// Where the body goes and how much fits
+char *httpRequestBody(const HttpRequest *r, int *room);
+
+// Body of body_len bytes written: patch Content-Length. Returns the request
+// length, or -1 if the body doesn't fit.
+int httpRequestFinish(HttpRequest *r, int body_len);
+
+// Decimal digits of v at out (no terminator); returns the count
+int httpFormatUint(char *out, unsigned long v);
+
+#endif /* UTILS_HTTP_REQUEST_H_ */
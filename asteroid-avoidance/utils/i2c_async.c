@@ -0,0 +1,182 @@
+//*****************************************************************************
+// i2c_async.c - Interrupt-driven I2C transaction queue
+//*****************************************************************************
+
+#include "i2c_async.h"
+
+#include <stddef.h>
+
+enum {
+    PHASE_REG,      // Register address byte in flight
+    PHASE_TX,       // Data bytes being written
+    PHASE_RX        // Data bytes being read
+};
+
+static const I2cBusOps *bus;
+static uint32_t (*clock_now)(void);
+static uint32_t timeout;
+
+static I2cAsyncXfer *queue_head;    // Active transfer, then the ones waiting
+static I2cAsyncXfer *queue_tail;
+static uint32_t step_started;       // Time the current byte step was issued
+static int completing;              // Inside a done callback: submit must not start
+
+volatile unsigned long i2c_async_errors = 0;
+volatile unsigned long i2c_async_timeouts = 0;
+
+void i2cAsyncInit(const I2cBusOps *ops, uint32_t (*now)(void), uint32_t timeout_ticks) {
+    bus = ops;
+    clock_now = now;
+    timeout = timeout_ticks;
+    queue_head = NULL;
+    queue_tail = NULL;
+    completing = 0;
+    bus->enableIrq(0);
+}
+
+static void issue(I2cBusCmd cmd) {
+    step_started = clock_now();
+    bus->command(cmd);
+}
+
+// Begin the transfer at the queue head (lock held)
+static void startHead(void) {
+    I2cAsyncXfer *x = queue_head;
+    if (x == NULL) {
+        bus->enableIrq(0);
+        return;
+    }
+    x->index = 0;
+    x->phase = PHASE_REG;
+    bus->enableIrq(1);
+    bus->setAddress(x->addr, 0);
+    bus->putByte(x->reg);
+    issue(x->write && x->len == 0 ? I2C_BUS_SINGLE_SEND : I2C_BUS_SEND_START);
+}
+
+// Retire the head transfer, then start the next one (lock held)
+static void finishHead(int status) {
+    I2cAsyncXfer *x = queue_head;
+    queue_head = x->next;
+    if (queue_head == NULL) {
+        queue_tail = NULL;
+    }
+    x->next = NULL;
+    x->status = status;
+    if (x->done != NULL) {
+        completing = 1;
+        x->done(x);     // May resubmit x
+        completing = 0;
+    }
+    startHead();
+}
+
+int i2cAsyncSubmit(I2cAsyncXfer *xfer) {
+    unsigned long state;
+
+    if (!xfer->write && xfer->len == 0) {
+        return -1;
+    }
+    state = bus->lock();
+    if (xfer->status == I2C_ASYNC_PENDING) {
+        bus->unlock(state);
+        return -1;
+    }
+    xfer->status = I2C_ASYNC_PENDING;
+    xfer->next = NULL;
+    if (queue_tail != NULL) {
+        queue_tail->next = xfer;
+        queue_tail = xfer;
+    } else {
+        queue_head = xfer;
+        queue_tail = xfer;
+        if (!completing) {
+            startHead();
+        }
+    }
+    bus->unlock(state);
+    return 0;
+}
+
+void i2cAsyncIsr(uint32_t events) {
+    I2cAsyncXfer *x = queue_head;
+
+    if (x == NULL) {
+        bus->enableIrq(0);
+        return;
+    }
+    if (events & I2C_BUS_EV_TIMEOUT) {
+        i2c_async_timeouts++;
+        bus->command(x->phase == PHASE_RX ? I2C_BUS_RECEIVE_ERROR_STOP : I2C_BUS_SEND_ERROR_STOP);
+        bus->recover();
+        finishHead(I2C_ASYNC_ERR_TIMEOUT);
+        return;
+    }
+    if (events & I2C_BUS_EV_ERROR) {
+        i2c_async_errors++;
+        bus->command(x->phase == PHASE_RX ? I2C_BUS_RECEIVE_ERROR_STOP : I2C_BUS_SEND_ERROR_STOP);
+        finishHead(I2C_ASYNC_ERR_NACK);
+        return;
+    }
+    if (!(events & I2C_BUS_EV_DONE)) {
+        return;
+    }
+
+    switch (x->phase) {
+    case PHASE_REG:
+        if (x->write) {
+            if (x->len == 0) {
+                finishHead(I2C_ASYNC_OK);   // SINGLE_SEND already sent the stop
+                return;
+            }
+            x->phase = PHASE_TX;
+            bus->putByte(x->buf[x->index++]);
+            issue(x->index == x->len ? I2C_BUS_SEND_FINISH : I2C_BUS_SEND_CONT);
+            return;
+        }
+        // Repeated start into the read
+        x->phase = PHASE_RX;
+        bus->setAddress(x->addr, 1);
+        issue(x->len == 1 ? I2C_BUS_SINGLE_RECEIVE : I2C_BUS_RECEIVE_START);
+        return;
+
+    case PHASE_TX:
+        if (x->index == x->len) {
+            finishHead(I2C_ASYNC_OK);
+            return;
+        }
+        bus->putByte(x->buf[x->index++]);
+        issue(x->index == x->len ? I2C_BUS_SEND_FINISH : I2C_BUS_SEND_CONT);
+        return;
+
+    case PHASE_RX:
+        x->buf[x->index++] = bus->getByte();
+        if (x->index == x->len) {
+            finishHead(I2C_ASYNC_OK);
+            return;
+        }
+        issue(x->index == x->len - 1 ? I2C_BUS_RECEIVE_FINISH : I2C_BUS_RECEIVE_CONT);
+        return;
+
+    default:
+        return;
+    }
+}
+
+void i2cAsyncPoll(void) {
+    unsigned long state = bus->lock();
+    I2cAsyncXfer *x = queue_head;
+
+    // Backstop for a lost interrupt or a controller that never signals
+    if (x != NULL && clock_now() - step_started > timeout) {
+        i2c_async_timeouts++;
+        bus->command(x->phase == PHASE_RX ? I2C_BUS_RECEIVE_ERROR_STOP : I2C_BUS_SEND_ERROR_STOP);
+        bus->recover();
+        finishHead(I2C_ASYNC_ERR_TIMEOUT);
+    }
+    bus->unlock(state);
+}
+
+int i2cAsyncIdle(void) {
+    return queue_head == NULL;
+}
@@ -0,0 +1,92 @@
+//*****************************************************************************
+// i2c_async.h - Interrupt-driven I2C transaction queue
+//
+// Callers submit caller-owned descriptors (address, register, length, buffer,
+// completion callback) and get the result later; the bus advances one byte
+// per interrupt instead of busy-polling. All hardware access goes through an
+// I2cBusOps table, so the engine runs unchanged on a stand-in bus.
+//
+// The bus interrupt is only unmasked while a transfer is in flight, so the
+// polled i2c_if API keeps working whenever i2cAsyncIdle() is true.
+//*****************************************************************************
+
+#ifndef UTILS_I2C_ASYNC_H_
+#define UTILS_I2C_ASYNC_H_
+
+#include <stdint.h>
+
+// Transfer status
+#define I2C_ASYNC_OK            0
+#define I2C_ASYNC_PENDING       1
+#define I2C_ASYNC_ERR_NACK      -1      // NACK or arbitration lost
+#define I2C_ASYNC_ERR_TIMEOUT   -2      // Clock stretched too long, or no progress
+
+// Events reported by the bus to i2cAsyncIsr()
+#define I2C_BUS_EV_DONE         0x1     // The last command finished cleanly
+#define I2C_BUS_EV_ERROR        0x2     // The last command was NACKed / lost arbitration
+#define I2C_BUS_EV_TIMEOUT      0x4     // Hardware clock-low timeout
+
+typedef enum {
+    I2C_BUS_SINGLE_SEND,
+    I2C_BUS_SEND_START,
+    I2C_BUS_SEND_CONT,
+    I2C_BUS_SEND_FINISH,
+    I2C_BUS_SEND_ERROR_STOP,
+    I2C_BUS_SINGLE_RECEIVE,
+    I2C_BUS_RECEIVE_START,
+    I2C_BUS_RECEIVE_CONT,
+    I2C_BUS_RECEIVE_FINISH,
+    I2C_BUS_RECEIVE_ERROR_STOP
+} I2cBusCmd;
+
+typedef struct {
+    void (*setAddress)(uint8_t addr, int receive);
+    void (*putByte)(uint8_t data);
+    uint8_t (*getByte)(void);
+    void (*command)(I2cBusCmd cmd);     // Start one byte step; completion is an interrupt
+    void (*enableIrq)(int on);
+    void (*recover)(void);              // Reset the controller after a hung transfer
+    unsigned long (*lock)(void);        // Mask interrupts, returning the previous state
+    void (*unlock)(unsigned long state);
+} I2cBusOps;
+
+typedef struct I2cAsyncXfer I2cAsyncXfer;
+typedef void (*I2cAsyncDone)(I2cAsyncXfer *xfer);
+
+struct I2cAsyncXfer {
+    uint8_t addr;           // 7-bit device address
+    uint8_t reg;            // Register written first
+    uint8_t len;            // Bytes to read (or write) after the register
+    uint8_t write;          // 0: read from reg with a repeated start, 1: write to reg
+    uint8_t *buf;
+    I2cAsyncDone done;      // Called from interrupt context (or i2cAsyncPoll on timeout)
+    void *user;
+    volatile int status;    // I2C_ASYNC_*
+    // Engine private
+    I2cAsyncXfer *next;
+    uint8_t index;
+    uint8_t phase;
+};
+
+// now() returns free-running ticks; a transfer with no progress for
+// timeout_ticks is aborted and the controller recovered
+void i2cAsyncInit(const I2cBusOps *ops, uint32_t (*now)(void), uint32_t timeout_ticks);
+
+// Queue a transfer. Returns 0, or -1 if this descriptor is still pending or
+// is a zero-length read. Descriptors must start out non-pending (zeroed).
+int i2cAsyncSubmit(I2cAsyncXfer *xfer);
+
+// Main loop: enforce the software timeout
+void i2cAsyncPoll(void);
+
+// Non-zero when no transfer is queued or in flight
+int i2cAsyncIdle(void);
+
+// Bus interrupt handler body, called with I2C_BUS_EV_* flags
+void i2cAsyncIsr(uint32_t events);
+
+// Statistics
+extern volatile unsigned long i2c_async_errors;
+extern volatile unsigned long i2c_async_timeouts;
+
+#endif /* UTILS_I2C_ASYNC_H_ */
@@ -0,0 +1,108 @@
+//*****************************************************************************
+// i2c_async_hw.c - CC3200 I2CA0 bus for the interrupt-driven I2C engine
+//*****************************************************************************
+
+#include "i2c_async_hw.h"
+
+#include "hw_types.h"
+#include "hw_memmap.h"
+#include "hw_ints.h"
+#include "i2c.h"
+#include "interrupt.h"
+#include "prcm.h"
+#include "rom.h"
+#include "rom_map.h"
+
+#define I2C_BASE            I2CA0_BASE
+#define I2C_SYS_CLK         80000000
+#define I2C_ASYNC_TIMEOUT   0x7D        // Clock-low timeout, same as the polled driver
+#define I2C_ASYNC_INTS      (I2C_MASTER_INT_DATA | I2C_MASTER_INT_TIMEOUT)
+
+static int i2c_fast_mode = 1;
+
+static void hwSetAddress(uint8_t addr, int receive) {
+    MAP_I2CMasterSlaveAddrSet(I2C_BASE, addr, receive ? true : false);
+}
+
+static void hwPutByte(uint8_t data) {
+    MAP_I2CMasterDataPut(I2C_BASE, data);
+}
+
+static uint8_t hwGetByte(void) {
+    return (uint8_t)MAP_I2CMasterDataGet(I2C_BASE);
+}
+
+static void hwCommand(I2cBusCmd cmd) {
+    static const unsigned long commands[] = {
+        [I2C_BUS_SINGLE_SEND]        = I2C_MASTER_CMD_SINGLE_SEND,
+        [I2C_BUS_SEND_START]         = I2C_MASTER_CMD_BURST_SEND_START,
+        [I2C_BUS_SEND_CONT]          = I2C_MASTER_CMD_BURST_SEND_CONT,
+        [I2C_BUS_SEND_FINISH]        = I2C_MASTER_CMD_BURST_SEND_FINISH,
+        [I2C_BUS_SEND_ERROR_STOP]    = I2C_MASTER_CMD_BURST_SEND_ERROR_STOP,
+        [I2C_BUS_SINGLE_RECEIVE]     = I2C_MASTER_CMD_SINGLE_RECEIVE,
+        [I2C_BUS_RECEIVE_START]      = I2C_MASTER_CMD_BURST_RECEIVE_START,
+        [I2C_BUS_RECEIVE_CONT]       = I2C_MASTER_CMD_BURST_RECEIVE_CONT,
+        [I2C_BUS_RECEIVE_FINISH]     = I2C_MASTER_CMD_BURST_RECEIVE_FINISH,
+        [I2C_BUS_RECEIVE_ERROR_STOP] = I2C_MASTER_CMD_BURST_RECEIVE_ERROR_STOP
+    };
+    MAP_I2CMasterTimeoutSet(I2C_BASE, I2C_ASYNC_TIMEOUT);
+    MAP_I2CMasterControl(I2C_BASE, commands[cmd]);
+}
+
+// Unmask at both the controller and the NVIC only while a transfer is in
+// flight; the polled i2c_if driver watches the raw status meanwhile
+static void hwEnableIrq(int on) {
+    if (on) {
+        MAP_I2CMasterIntClearEx(I2C_BASE, I2C_ASYNC_INTS);
+        MAP_I2CMasterIntEnableEx(I2C_BASE, I2C_ASYNC_INTS);
+        MAP_IntEnable(INT_I2CA0);
+    } else {
+        MAP_IntDisable(INT_I2CA0);
+        MAP_I2CMasterIntDisableEx(I2C_BASE, I2C_ASYNC_INTS);
+    }
+}
+
+static void hwRecover(void) {
+    MAP_PRCMPeripheralReset(PRCM_I2CA0);
+    MAP_I2CMasterInitExpClk(I2C_BASE, I2C_SYS_CLK, i2c_fast_mode ? true : false);
+}
+
+static unsigned long hwLock(void) {
+    return MAP_IntMasterDisable();
+}
+
+static void hwUnlock(unsigned long was_disabled) {
+    if (!was_disabled) {
+        MAP_IntMasterEnable();
+    }
+}
+
+static void I2CAsyncIntHandler(void) {
+    unsigned long status = MAP_I2CMasterIntStatusEx(I2C_BASE, true);
+    uint32_t events = 0;
+
+    MAP_I2CMasterIntClearEx(I2C_BASE, status);
+    if (status & I2C_MASTER_INT_TIMEOUT) {
+        events |= I2C_BUS_EV_TIMEOUT;
+    } else if (status & I2C_MASTER_INT_DATA) {
+        events |= (MAP_I2CMasterErr(I2C_BASE) != I2C_MASTER_ERR_NONE) ? I2C_BUS_EV_ERROR : I2C_BUS_EV_DONE;
+    }
+    i2cAsyncIsr(events);
+}
+
+const I2cBusOps i2c_async_hw_ops = {
+    hwSetAddress,
+    hwPutByte,
+    hwGetByte,
+    hwCommand,
+    hwEnableIrq,
+    hwRecover,
+    hwLock,
+    hwUnlock
+};
+
+void i2cAsyncHwInit(int fast_mode) {
+    i2c_fast_mode = fast_mode;
+    MAP_I2CIntRegister(I2C_BASE, I2CAsyncIntHandler);
+    MAP_IntDisable(INT_I2CA0);  // Enabled per transfer
+}
@@ -0,0 +1,16 @@
+//*****************************************************************************
+// i2c_async_hw.h - CC3200 I2CA0 bus for the interrupt-driven I2C engine
+//*****************************************************************************
+
+#ifndef UTILS_I2C_ASYNC_HW_H_
+#define UTILS_I2C_ASYNC_HW_H_
+
+#include "i2c_async.h"
+
+extern const I2cBusOps i2c_async_hw_ops;
+
+// Register the I2CA0 interrupt handler. Call after I2C_IF_Open(); fast_mode
+// must match its mode so recovery re-initializes the same clock.
+void i2cAsyncHwInit(int fast_mode);
+
+#endif /* UTILS_I2C_ASYNC_HW_H_ */
@@ -0,0 +1,357 @@
+//*****************************************************************************
+// ir_decoder.c - Table-driven multi-protocol IR decoder (NEC, Sony SIRC, RC5)
+//*****************************************************************************
+
+#include "ir_decoder.h"
+
+// A gap this long ends any button hold, whatever the protocol
+#define IR_IDLE_RESET_US    1000000
+
+const IrProtocol ir_protocols[IR_NUM_PROTOCOLS] = {
+    // NEC: 9 ms + 4.5 ms leader, 562 us marks, 562/1687 us spaces, stop mark.
+    // 32 bits LSB first on the wire, kept in arrival order (address, ~address,
+    // command, ~command). Held buttons send 9 ms + 2.25 ms repeat codes.
+    [IR_PROTO_NEC] = {
+        .name = "NEC", .coding = IR_CODING_PULSE_DISTANCE, .tolerance_pct = 35,
+        .bits = 32, .lsb_first = 0, .stop_mark = 1,
+        .leader_mark_us = 9000, .leader_space_us = 4500, .repeat_space_us = 2250,
+        .unit_us = 562, .zero_us = 562, .one_us = 1687,
+        .repeat_window_us = 150000, .check = IR_CHECK_INVERSE_BYTES,
+        .address_shift = 24, .address_bits = 8, .command_shift = 8, .command_bits = 8,
+        .toggle_shift = -1
+    },
+    // Sony SIRC-12: 2.4 ms leader mark, 600 us spaces, 600/1200 us marks.
+    // 7 command bits then 5 address bits, LSB first. Frames are resent every
+    // 45 ms while held.
+    [IR_PROTO_SIRC] = {
+        .name = "SIRC", .coding = IR_CODING_PULSE_WIDTH, .tolerance_pct = 25,
+        .bits = 12, .lsb_first = 1, .stop_mark = 0,
+        .leader_mark_us = 2400, .leader_space_us = 0, .repeat_space_us = 0,
+        .unit_us = 600, .zero_us = 600, .one_us = 1200,
+        .repeat_window_us = 100000, .check = IR_CHECK_NONE,
+        .address_shift = 7, .address_bits = 5, .command_shift = 0, .command_bits = 7,
+        .toggle_shift = -1
+    },
+    // Philips RC5: 889 us half-bits, 14 bits MSB first (2 start bits, toggle,
+    // 5 address, 6 command). 1 = space then mark. Frames are resent every
+    // 114 ms with the same toggle while held.
+    [IR_PROTO_RC5] = {
+        .name = "RC5", .coding = IR_CODING_MANCHESTER, .tolerance_pct = 30,
+        .bits = 14, .lsb_first = 0, .stop_mark = 0,
+        .leader_mark_us = 0, .leader_space_us = 0, .repeat_space_us = 0,
+        .unit_us = 889, .zero_us = 0, .one_us = 0,
+        .repeat_window_us = 150000, .check = IR_CHECK_START_BITS,
+        .address_shift = 6, .address_bits = 5, .command_shift = 0, .command_bits = 6,
+        .toggle_shift = 11
+    }
+};
+
+enum {
+    ST_IDLE,            // Waiting for a leader (or the first Manchester mark)
+    ST_LEADER,          // Leader mark seen, expecting the leader or repeat space
+    ST_BIT_FIXED,       // Expecting the fixed part of a bit, or the stop mark
+    ST_BIT_VAR,         // Expecting the part of a bit that carries its value
+    ST_REPEAT_MARK,     // Expecting the stop mark of a repeat code
+    ST_MANCHESTER       // Consuming half-bits
+};
+
+static int inWindow(uint32_t width_us, uint32_t nominal_us, uint32_t tolerance_pct) {
+    uint32_t dev = nominal_us * tolerance_pct / 100;
+    return nominal_us != 0 && width_us + dev >= nominal_us && width_us <= nominal_us + dev;
+}
+
+static void protoReset(IrProtocolState *st) {
+    st->state = ST_IDLE;
+    st->bits = 0;
+    st->bit_count = 0;
+    st->halves = 0;
+    st->last_half_mark = 0;
+}
+
+void irDecoderInit(IrDecoder *dec) {
+    int i;
+    dec->now_us = 0;
+    dec->frames = 0;
+    dec->repeats = 0;
+    dec->errors = 0;
+    for (i = 0; i < IR_NUM_PROTOCOLS; i++) {
+        dec->proto[i].have_last = 0;
+        dec->proto[i].last_raw = 0;
+        dec->proto[i].last_time_us = 0;
+    }
+    irDecoderReset(dec);
+}
+
+void irDecoderReset(IrDecoder *dec) {
+    int i;
+    for (i = 0; i < IR_NUM_PROTOCOLS; i++) {
+        protoReset(&dec->proto[i]);
+    }
+}
+
+uint32_t irEventKey(const IrEvent *ev) {
+    return 0x80000000UL | ((uint32_t)ev->protocol << 24)
+           | ((uint32_t)(ev->address & 0xFF) << 16) | (ev->command & 0xFFFF);
+}
+
+static void appendBit(IrProtocolState *st, const IrProtocol *p, int bit) {
+    if (p->lsb_first) {
+        st->bits |= (uint32_t)bit << st->bit_count;
+    } else {
+        st->bits = (st->bits << 1) | (uint32_t)bit;
+    }
+    st->bit_count++;
+}
+
+// Whether this pulse can start a frame of protocol p
+static int isStart(const IrProtocol *p, int is_mark, uint32_t width_us) {
+    if (!is_mark) {
+        return 0;
+    }
+    if (p->coding == IR_CODING_MANCHESTER) {
+        return inWindow(width_us, p->unit_us, p->tolerance_pct)
+            || inWindow(width_us, 2 * p->unit_us, p->tolerance_pct);
+    }
+    return inWindow(width_us, p->leader_mark_us, p->tolerance_pct);
+}
+
+// Abandon the current frame. Only frames with at least one data bit count as
+// errors; anything shorter is most likely another protocol's pulse train.
+static IrEventType protoError(IrDecoder *dec, int id, IrEvent *out) {
+    IrProtocolState *st = &dec->proto[id];
+    int had_bits = st->bit_count > 0;
+    uint32_t partial = st->bits;
+    protoReset(st);
+    if (!had_bits) {
+        return IR_EVENT_NONE;
+    }
+    dec->errors++;
+    out->type = IR_EVENT_ERROR;
+    out->protocol = (IrProtocolId)id;
+    out->address = 0;
+    out->command = 0;
+    out->raw = partial;
+    return IR_EVENT_ERROR;
+}
+
+// Validate and report a complete frame (or a resend of the last one)
+static IrEventType protoComplete(IrDecoder *dec, int id, IrEvent *out) {
+    const IrProtocol *p = &ir_protocols[id];
+    IrProtocolState *st = &dec->proto[id];
+    uint32_t raw = st->bits;
+    int valid = 1;
+    protoReset(st);
+
+    if (p->check == IR_CHECK_INVERSE_BYTES) {
+        valid = ((uint8_t)((raw >> 24) ^ (raw >> 16)) == 0xFF)
+             && ((uint8_t)((raw >> 8) ^ raw) == 0xFF);
+    } else if (p->check == IR_CHECK_START_BITS) {
+        valid = ((raw >> (p->bits - 2)) & 0x3) == 0x3;
+    }
+    out->protocol = (IrProtocolId)id;
+    out->raw = raw;
+    if (!valid) {
+        dec->errors++;
+        st->have_last = 0;
+        out->type = IR_EVENT_ERROR;
+        out->address = 0;
+        out->command = 0;
+        return IR_EVENT_ERROR;
+    }
+    out->address = (uint16_t)((raw >> p->address_shift) & ((1UL << p->address_bits) - 1));
+    out->command = (uint16_t)((raw >> p->command_shift) & ((1UL << p->command_bits) - 1));
+
+    // Protocols without a repeat code resend the whole frame while held
+    if (p->repeat_space_us == 0 && st->have_last && st->last_raw == raw
+            && dec->now_us - st->last_time_us <= p->repeat_window_us) {
+        dec->repeats++;
+        out->type = IR_EVENT_REPEAT;
+    } else {
+        dec->frames++;
+        out->type = IR_EVENT_FRAME;
+    }
+    st->have_last = 1;
+    st->last_raw = raw;
+    st->last_time_us = dec->now_us;
+    return out->type;
+}
+
+// Consume one Manchester half-bit; a bit is complete on every second half
+static int pushHalf(IrProtocolState *st, const IrProtocol *p, int is_mark) {
+    st->halves++;
+    if ((st->halves & 1) == 0) {
+        if (is_mark == st->last_half_mark) {
+            return -1;  // No mid-bit transition
+        }
+        appendBit(st, p, is_mark);
+    }
+    st->last_half_mark = is_mark;
+    return 0;
+}
+
+static IrEventType feedManchester(IrDecoder *dec, int id, int is_mark, uint32_t width_us, IrEvent *out) {
+    const IrProtocol *p = &ir_protocols[id];
+    IrProtocolState *st = &dec->proto[id];
+    int n = inWindow(width_us, p->unit_us, p->tolerance_pct) ? 1
+          : inWindow(width_us, 2 * p->unit_us, p->tolerance_pct) ? 2 : 0;
+
+    if (n == 0) {
+        // A final 0 bit ends in a space that merges into the idle gap
+        if (!is_mark && width_us > 2 * p->unit_us && (st->halves & 1) && st->bit_count == p->bits - 1) {
+            pushHalf(st, p, 0);
+            return protoComplete(dec, id, out);
+        }
+        return protoError(dec, id, out);
+    }
+    while (n-- > 0) {
+        if (pushHalf(st, p, is_mark) < 0) {
+            return protoError(dec, id, out);
+        }
+        if (st->bit_count == p->bits) {
+            return protoComplete(dec, id, out);
+        }
+    }
+    return IR_EVENT_NONE;
+}
+
+static IrEventType feedProtocol(IrDecoder *dec, int id, int is_mark, uint32_t width_us, IrEvent *out) {
+    const IrProtocol *p = &ir_protocols[id];
+    IrProtocolState *st = &dec->proto[id];
+    // The fixed part is a mark for pulse-distance coding, a space for pulse-width
+    int fixed_is_mark = (p->coding == IR_CODING_PULSE_DISTANCE);
+
+    switch (st->state) {
+    case ST_IDLE:
+        if (!isStart(p, is_mark, width_us)) {
+            return IR_EVENT_NONE;
+        }
+        if (p->coding == IR_CODING_MANCHESTER) {
+            // The first start bit's leading space is indistinguishable from idle
+            st->state = ST_MANCHESTER;
+            st->halves = 1;
+            st->last_half_mark = 0;
+            return feedManchester(dec, id, is_mark, width_us, out);
+        }
+        st->state = p->leader_space_us ? ST_LEADER : ST_BIT_FIXED;
+        return IR_EVENT_NONE;
+
+    case ST_LEADER:
+        if (!is_mark && inWindow(width_us, p->leader_space_us, p->tolerance_pct)) {
+            st->state = ST_BIT_FIXED;
+            return IR_EVENT_NONE;
+        }
+        if (!is_mark && inWindow(width_us, p->repeat_space_us, p->tolerance_pct)) {
+            st->state = ST_REPEAT_MARK;
+            return IR_EVENT_NONE;
+        }
+        break;
+
+    case ST_BIT_FIXED:
+        if (is_mark != fixed_is_mark || !inWindow(width_us, p->unit_us, p->tolerance_pct)) {
+            break;
+        }
+        if (st->bit_count == p->bits) {
+            return protoComplete(dec, id, out);   // Stop mark
+        }
+        st->state = ST_BIT_VAR;
+        return IR_EVENT_NONE;
+
+    case ST_BIT_VAR:
+        if (is_mark == fixed_is_mark) {
+            break;
+        }
+        if (inWindow(width_us, p->zero_us, p->tolerance_pct)) {
+            appendBit(st, p, 0);
+        } else if (inWindow(width_us, p->one_us, p->tolerance_pct)) {
+            appendBit(st, p, 1);
+        } else {
+            break;
+        }
+        if (st->bit_count == p->bits && !p->stop_mark) {
+            return protoComplete(dec, id, out);
+        }
+        st->state = ST_BIT_FIXED;
+        return IR_EVENT_NONE;
+
+    case ST_REPEAT_MARK:
+        if (!is_mark || !inWindow(width_us, p->unit_us, p->tolerance_pct)) {
+            break;
+        }
+        protoReset(st);
+        if (!st->have_last || dec->now_us - st->last_time_us > p->repeat_window_us) {
+            // Orphan repeat (the frame it belongs to was missed)
+            st->have_last = 0;
+            return IR_EVENT_NONE;
+        }
+        dec->repeats++;
+        st->last_time_us = dec->now_us;
+        out->type = IR_EVENT_REPEAT;
+        out->protocol = (IrProtocolId)id;
+        out->raw = st->last_raw;
+        out->address = (uint16_t)((st->last_raw >> p->address_shift) & ((1UL << p->address_bits) - 1));
+        out->command = (uint16_t)((st->last_raw >> p->command_shift) & ((1UL << p->command_bits) - 1));
+        return IR_EVENT_REPEAT;
+
+    case ST_MANCHESTER:
+        return feedManchester(dec, id, is_mark, width_us, out);
+
+    default:
+        protoReset(st);
+        return IR_EVENT_NONE;
+    }
+
+    // Bad pulse: drop the frame, but the pulse may itself start a new one
+    {
+        IrEventType ev = protoError(dec, id, out);
+        if (isStart(p, is_mark, width_us) && p->coding != IR_CODING_MANCHESTER) {
+            st->state = p->leader_space_us ? ST_LEADER : ST_BIT_FIXED;
+        }
+        return ev;
+    }
+}
+
+IrEventType irDecoderFeed(IrDecoder *dec, int is_mark, uint32_t width_us, IrEvent *out) {
+    IrEventType result = IR_EVENT_NONE;
+    int i;
+
+    dec->now_us += width_us;
+    if (width_us >= IR_IDLE_RESET_US) {
+        for (i = 0; i < IR_NUM_PROTOCOLS; i++) {
+            dec->proto[i].have_last = 0;
+        }
+    }
+
+    // Every protocol sees every pulse; a completed frame wins over an error
+    for (i = 0; i < IR_NUM_PROTOCOLS; i++) {
+        IrEvent ev;
+        IrEventType type = feedProtocol(dec, i, is_mark, width_us, &ev);
+        if (type == IR_EVENT_NONE || (type == IR_EVENT_ERROR && result != IR_EVENT_NONE)) {
+            continue;
+        }
+        if (result == IR_EVENT_NONE || result == IR_EVENT_ERROR) {
+            result = type;
+            *out = ev;
+        }
+    }
+    return result;
+}
+
+IrEventType irDecoderIdle(IrDecoder *dec, uint32_t idle_us, IrEvent *out) {
+    int i;
+
+    for (i = 0; i < IR_NUM_PROTOCOLS; i++) {
+        const IrProtocol *p = &ir_protocols[i];
+        IrProtocolState *st = &dec->proto[i];
+        uint32_t longest = 2 * p->unit_us * (100 + p->tolerance_pct) / 100;
+
+        // Only once the space can no longer be a valid double half-bit, and
+        // only if it is the line's level (the last half fed was a mark)
+        if (p->coding != IR_CODING_MANCHESTER || st->state != ST_MANCHESTER
+                || !st->last_half_mark || idle_us <= longest) {
+            continue;
+        }
+        // The pulse itself is counted when its closing edge is fed
+        return feedManchester(dec, i, 0, idle_us, out);
+    }
+    return IR_EVENT_NONE;
+}
@@ -0,0 +1,109 @@
+//*****************************************************************************
+// ir_decoder.h - Table-driven multi-protocol IR decoder (NEC, Sony SIRC, RC5)
+//
+// Each protocol is a row of timing and field-layout data in ir_protocols[];
+// the engine feeds every pulse (mark or space plus its width in microseconds)
+// to a small per-protocol state machine, so it is independent of how pulses
+// are captured and can be driven on a host from recorded traces.
+//*****************************************************************************
+
+#ifndef UTILS_IR_DECODER_H_
+#define UTILS_IR_DECODER_H_
+
+#include <stdint.h>
+
+typedef enum {
+    IR_PROTO_NEC,
+    IR_PROTO_SIRC,
+    IR_PROTO_RC5,
+    IR_NUM_PROTOCOLS
+} IrProtocolId;
+
+typedef enum {
+    IR_CODING_PULSE_DISTANCE,   // Fixed mark, bit value in the following space (NEC)
+    IR_CODING_PULSE_WIDTH,      // Fixed space, bit value in the following mark (SIRC)
+    IR_CODING_MANCHESTER        // Bi-phase, one transition per bit (RC5)
+} IrCoding;
+
+typedef enum {
+    IR_CHECK_NONE,
+    IR_CHECK_INVERSE_BYTES,     // Address and command each followed by their complement
+    IR_CHECK_START_BITS         // Top bit(s) of the frame must be set
+} IrCheck;
+
+typedef struct {
+    const char *name;
+    IrCoding coding;
+    uint8_t tolerance_pct;      // Accepted deviation from every nominal width
+    uint8_t bits;
+    uint8_t lsb_first;
+    uint8_t stop_mark;          // Frame ends with a trailing bit mark
+    uint16_t leader_mark_us;    // 0 = no leader
+    uint16_t leader_space_us;   // 0 = leader mark is followed directly by bit timing
+    uint16_t repeat_space_us;   // Space after the leader that marks a repeat code, 0 = none
+    uint16_t unit_us;           // Fixed part of a bit, or the half-bit for Manchester
+    uint16_t zero_us;           // Variable part of a bit for 0
+    uint16_t one_us;            // Variable part of a bit for 1
+    uint32_t repeat_window_us;  // Max gap between a frame and its repeat
+    IrCheck check;
+    uint8_t address_shift, address_bits;
+    uint8_t command_shift, command_bits;
+    int8_t toggle_shift;        // Toggle bit position, -1 = none
+} IrProtocol;
+
+extern const IrProtocol ir_protocols[IR_NUM_PROTOCOLS];
+
+typedef enum {
+    IR_EVENT_NONE,
+    IR_EVENT_FRAME,     // New button press
+    IR_EVENT_REPEAT,    // Button still held (repeat code, or identical frame resent)
+    IR_EVENT_ERROR      // Frame abandoned part way (bad timing or failed check)
+} IrEventType;
+
+typedef struct {
+    IrEventType type;
+    IrProtocolId protocol;
+    uint16_t address;
+    uint16_t command;
+    uint32_t raw;       // Frame bits in protocol bit order
+} IrEvent;
+
+typedef struct {
+    int state;
+    uint32_t bits;
+    int bit_count;
+    int halves;             // Manchester: half-bits consumed
+    int last_half_mark;     // Manchester: level of the previous half-bit
+    int have_last;          // A frame is eligible for repeat detection
+    uint32_t last_raw;
+    uint32_t last_time_us;  // Decoder time when the last frame/repeat ended
+} IrProtocolState;
+
+typedef struct {
+    IrProtocolState proto[IR_NUM_PROTOCOLS];
+    uint32_t now_us;        // Sum of all fed widths (wraps; only differences are used)
+    unsigned long frames;   // Statistics
+    unsigned long repeats;
+    unsigned long errors;
+} IrDecoder;
+
+void irDecoderInit(IrDecoder *dec);
+
+// Drop all partial frames (e.g. after captured edges were lost)
+void irDecoderReset(IrDecoder *dec);
+
+// Feed one pulse. is_mark is non-zero for carrier-on time. Returns the event
+// type and fills *out for FRAME, REPEAT and ERROR. Errors are only reported
+// once a frame was well under way, since other protocols' pulses are noise.
+IrEventType irDecoderFeed(IrDecoder *dec, int is_mark, uint32_t width_us, IrEvent *out);
+
+// The line has been idle (a space) for idle_us since the last pulse fed.
+// Completes a Manchester frame whose final 0 bit ends in that space, which
+// otherwise needs the next edge to be measured. Call it periodically while no
+// edges arrive; returns and fills *out as irDecoderFeed() does.
+IrEventType irDecoderIdle(IrDecoder *dec, uint32_t idle_us, IrEvent *out);
+
+// Key identifying (protocol, address, command), never 0
+uint32_t irEventKey(const IrEvent *ev);
+
+#endif /* UTILS_IR_DECODER_H_ */
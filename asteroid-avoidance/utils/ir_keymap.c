@@ -0,0 +1,101 @@
+//*****************************************************************************
+// ir_keymap.c - Hashed IR code to button map with flash persistence
+//*****************************************************************************
+
+#include "ir_keymap.h"
+
+#include <string.h>
+
+#include "flash_store.h"
+
+#define IR_KEYMAP_MAGIC     0x4B524931UL    // "1IRK"
+
+// On-flash layout: header followed by count entries
+typedef struct {
+    uint32_t magic;
+    uint32_t count;
+    struct {
+        uint32_t key;
+        int32_t button;
+    } entries[IR_KEYMAP_MAX_KEYS];
+} IrKeyMapFile;
+
+// Scratch for load/save; too big for the stack and only used outside ISRs
+static IrKeyMapFile keymap_file;
+
+// Fibonacci hashing: the top bits of key * 2^32/phi
+static unsigned int keyHash(uint32_t key) {
+    return (unsigned int)((uint32_t)(key * 2654435761UL) >> 26) & (IR_KEYMAP_SIZE - 1);
+}
+
+void irKeyMapClear(IrKeyMap *map) {
+    memset(map->slots, 0, sizeof(map->slots));
+    map->count = 0;
+}
+
+int irKeyMapPut(IrKeyMap *map, uint32_t key, int button, int learned) {
+    unsigned int i = keyHash(key);
+    while (map->slots[i].key != 0 && map->slots[i].key != key) {
+        i = (i + 1) & (IR_KEYMAP_SIZE - 1);
+    }
+    if (map->slots[i].key == 0) {
+        if (map->count >= IR_KEYMAP_MAX_KEYS) {
+            return -1;
+        }
+        map->count++;
+    }
+    map->slots[i].key = key;
+    map->slots[i].button = (int8_t)button;
+    map->slots[i].learned = (uint8_t)(learned != 0);
+    return 0;
+}
+
+int irKeyMapGet(const IrKeyMap *map, uint32_t key) {
+    unsigned int i = keyHash(key);
+    while (map->slots[i].key != 0) {
+        if (map->slots[i].key == key) {
+            return map->slots[i].button;
+        }
+        i = (i + 1) & (IR_KEYMAP_SIZE - 1);
+    }
+    return -1;
+}
+
+long irKeyMapSave(const IrKeyMap *map, const char *file) {
+    int i;
+    keymap_file.magic = IR_KEYMAP_MAGIC;
+    keymap_file.count = 0;
+    for (i = 0; i < IR_KEYMAP_SIZE; i++) {
+        if (map->slots[i].key != 0 && map->slots[i].learned) {
+            keymap_file.entries[keymap_file.count].key = map->slots[i].key;
+            keymap_file.entries[keymap_file.count].button = map->slots[i].button;
+            keymap_file.count++;
+        }
+    }
+    return flashStoreWrite(file, &keymap_file,
+                           sizeof(keymap_file) - sizeof(keymap_file.entries)
+                           + keymap_file.count * sizeof(keymap_file.entries[0]),
+                           sizeof(keymap_file));
+}
+
+long irKeyMapLoad(IrKeyMap *map, const char *file) {
+    unsigned long header = sizeof(keymap_file) - sizeof(keymap_file.entries);
+    long len = flashStoreRead(file, &keymap_file, sizeof(keymap_file));
+    uint32_t i;
+
+    if (len < 0) {
+        return len;
+    }
+    if ((unsigned long)len < header || keymap_file.magic != IR_KEYMAP_MAGIC
+            || keymap_file.count > IR_KEYMAP_MAX_KEYS
+            || (unsigned long)len < header + keymap_file.count * sizeof(keymap_file.entries[0])) {
+        return -1;
+    }
+    for (i = 0; i < keymap_file.count; i++) {
+        if (keymap_file.entries[i].key == 0
+                || irKeyMapPut(map, keymap_file.entries[i].key, keymap_file.entries[i].button, 1) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
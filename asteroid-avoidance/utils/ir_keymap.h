@@ -0,0 +1,40 @@
+//*****************************************************************************
+// ir_keymap.h - Hashed IR code to button map with flash persistence
+//
+// Keys come from irEventKey(), so codes from any protocol and any number of
+// remotes share one open-addressing table and lookups stay O(1).
+//*****************************************************************************
+
+#ifndef UTILS_IR_KEYMAP_H_
+#define UTILS_IR_KEYMAP_H_
+
+#include <stdint.h>
+
+#define IR_KEYMAP_SIZE      64      // Slots, power of two
+#define IR_KEYMAP_MAX_KEYS  48      // Keep load <= 3/4 so probe chains stay short
+
+typedef struct {
+    uint32_t key;       // 0 = empty slot
+    int8_t button;
+    uint8_t learned;    // Only learned entries are saved to flash
+} IrKeyEntry;
+
+typedef struct {
+    IrKeyEntry slots[IR_KEYMAP_SIZE];
+    int count;
+} IrKeyMap;
+
+void irKeyMapClear(IrKeyMap *map);
+
+// Add or replace a mapping. Returns 0, or -1 when the map is full.
+int irKeyMapPut(IrKeyMap *map, uint32_t key, int button, int learned);
+
+// Button mapped to key, or -1
+int irKeyMapGet(const IrKeyMap *map, uint32_t key);
+
+// Persist / restore the learned entries. Load adds to whatever is already
+// mapped. Both return 0 or a negative error.
+long irKeyMapSave(const IrKeyMap *map, const char *file);
+long irKeyMapLoad(IrKeyMap *map, const char *file);
+
+#endif /* UTILS_IR_KEYMAP_H_ */
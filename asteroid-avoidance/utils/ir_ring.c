@@ -0,0 +1,53 @@
+//*****************************************************************************
+// ir_ring.c - Lock-free single-producer/single-consumer ring of IR edge events
+//*****************************************************************************
+
+#include "ir_ring.h"
+
+#define IR_RING_MASK (IR_RING_SIZE - 1)
+
+#if (IR_RING_SIZE & IR_RING_MASK) != 0
+#error "IR_RING_SIZE must be a power of two"
+#endif
+
+void irRingInit(IrEdgeRing *ring) {
+    ring->head = 0;
+    ring->tail = 0;
+    ring->overflows = 0;
+    ring->high_water = 0;
+}
+
+// head and tail are free-running; their difference is the fill level even
+// across 32-bit wraparound
+int irRingPush(IrEdgeRing *ring, uint32_t timestamp, uint32_t level) {
+    uint32_t head = ring->head;
+    uint32_t used = head - ring->tail;
+    if (used >= IR_RING_SIZE) {
+        ring->overflows++;
+        return 0;
+    }
+    ring->events[head & IR_RING_MASK].timestamp = timestamp;
+    ring->events[head & IR_RING_MASK].level = level;
+    // Publish only after the event is written (both are volatile, so the
+    // compiler keeps this order; the M4 doesn't reorder stores to normal RAM)
+    ring->head = head + 1;
+    if (used + 1 > ring->high_water) {
+        ring->high_water = used + 1;
+    }
+    return 1;
+}
+
+int irRingPop(IrEdgeRing *ring, IrEdge *out) {
+    uint32_t tail = ring->tail;
+    if (tail == ring->head) {
+        return 0;
+    }
+    out->timestamp = ring->events[tail & IR_RING_MASK].timestamp;
+    out->level = ring->events[tail & IR_RING_MASK].level;
+    ring->tail = tail + 1;
+    return 1;
+}
+
+uint32_t irRingCount(const IrEdgeRing *ring) {
+    return ring->head - ring->tail;
+}
@@ -0,0 +1,43 @@
+//*****************************************************************************
+// ir_ring.h - Lock-free single-producer/single-consumer ring of IR edge events
+//
+// The IR capture ISR is the only producer and the main loop the only consumer, so
+// head and tail each have a single writer and no locking is needed on a
+// single-core Cortex-M.
+//*****************************************************************************
+
+#ifndef UTILS_IR_RING_H_
+#define UTILS_IR_RING_H_
+
+#include <stdint.h>
+
+// Must be a power of two. An NEC frame is 68 edges, so this holds almost two
+// full frames if the main loop stalls for a whole render.
+#define IR_RING_SIZE 128
+
+typedef struct {
+    uint32_t timestamp;  // Free-running tick count at the edge
+    uint32_t level;      // Line level after the edge (1 = rising, 0 = falling)
+} IrEdge;
+
+typedef struct {
+    volatile uint32_t head;       // Next slot to write (producer only)
+    volatile uint32_t tail;       // Next slot to read (consumer only)
+    volatile uint32_t overflows;  // Edges dropped because the ring was full
+    volatile uint32_t high_water; // Most edges ever queued at once
+    volatile IrEdge events[IR_RING_SIZE];
+} IrEdgeRing;
+
+void irRingInit(IrEdgeRing *ring);
+
+// Producer (ISR): queue an edge. Returns 0 and counts an overflow when full;
+// the newest edge is the one dropped so queued edges stay contiguous.
+int irRingPush(IrEdgeRing *ring, uint32_t timestamp, uint32_t level);
+
+// Consumer (main loop): dequeue the oldest edge. Returns 0 when empty.
+int irRingPop(IrEdgeRing *ring, IrEdge *out);
+
+// Number of edges currently queued
+uint32_t irRingCount(const IrEdgeRing *ring);
+
+#endif /* UTILS_IR_RING_H_ */
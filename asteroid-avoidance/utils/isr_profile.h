@@ -0,0 +1,27 @@
+//*****************************************************************************
+// isr_profile.h - Execution-time statistics for interrupt handlers
+//*****************************************************************************
+
+#ifndef UTILS_ISR_PROFILE_H_
+#define UTILS_ISR_PROFILE_H_
+
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t count;
+    volatile uint32_t max_ticks;
+    volatile uint32_t total_ticks;  // Wraps after ~53 s of handler time at 80 MHz
+} IsrProfile;
+
+// Record one handler run, measured in caller-chosen ticks. Only the profiled
+// ISR writes its own IsrProfile, so no locking is needed.
+#define ISR_PROFILE_RECORD(prof, ticks) do {            \
+        uint32_t isr_ticks_ = (ticks);                  \
+        (prof).count++;                                 \
+        (prof).total_ticks += isr_ticks_;               \
+        if (isr_ticks_ > (prof).max_ticks) {            \
+            (prof).max_ticks = isr_ticks_;              \
+        }                                               \
+    } while (0)
+
+#endif /* UTILS_ISR_PROFILE_H_ */
@@ -0,0 +1,445 @@
+//*****************************************************************************
+// json_stream.c - Streaming JSON field extractor
+//*****************************************************************************
+
+#include "json_stream.h"
+
+#include <limits.h>
+#include <string.h>
+
+enum {
+    J_VALUE,
+    J_ARRAY_FIRST,          // After '[': a value or ']'
+    J_OBJECT_FIRST,         // After '{': a key or '}'
+    J_KEY_START,            // After ',' in an object
+    J_KEY,
+    J_KEY_ESC,
+    J_COLON,
+    J_AFTER_VALUE,          // ',' or the closing bracket
+    J_STRING,
+    J_STRING_ESC,
+    J_STRING_U,             // \uXXXX digits
+    J_NUMBER,
+    J_LITERAL,
+    J_END,
+    J_ERROR
+};
+
+#define BIT(i)  (1u << (i))
+
+void jsonStreamInit(JsonStream *js, JsonField *fields, int nfields) {
+    int i;
+    memset(js, 0, sizeof(*js));
+    if (nfields > JSON_MAX_FIELDS) {
+        nfields = JSON_MAX_FIELDS;
+    }
+    js->fields = fields;
+    js->nfields = (uint8_t)nfields;
+    for (i = 0; i < nfields; i++) {
+        fields[i].found = 0;
+        if (fields[i].type == JSON_STRING && fields[i].str_size) {
+            fields[i].str[0] = '\0';
+        }
+    }
+    // Every path starts at the top-level object
+    js->child_mask = (uint8_t)(BIT(nfields) - 1);
+    js->state = J_VALUE;
+}
+
+static int fail(JsonStream *js, JsonError err) {
+    js->error = err;
+    js->state = J_ERROR;
+    return JSON_STREAM_ERROR;
+}
+
+static int isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static int isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static int isHex(char c) {
+    return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static void valueEnd(JsonStream *js) {
+    js->value_mask = 0;
+    js->child_mask = 0;
+    js->state = js->depth ? J_AFTER_VALUE : J_END;
+}
+
+static void storeInt(JsonStream *js, long v) {
+    int i;
+    for (i = 0; i < js->nfields; i++) {
+        if ((js->value_mask & BIT(i)) && js->fields[i].type == JSON_INT) {
+            js->fields[i].num = v;
+            js->fields[i].found = 1;
+        }
+    }
+}
+
+static void numDigit(JsonStream *js, char c) {
+    if (js->num > (LONG_MAX - 9) / 10) {
+        js->num_ok = 0;
+    } else {
+        js->num = js->num * 10 + (c - '0');
+    }
+}
+
+static void numStart(JsonStream *js) {
+    js->num = 0;
+    js->num_sign = 1;
+    js->num_ok = 1;
+    js->num_frac = 0;
+    js->lit_pos = 0;        // Digits seen
+}
+
+// One character of a captured string value
+static void stringPut(JsonStream *js, char c) {
+    int i;
+    for (i = 0; i < js->nfields; i++) {
+        JsonField *f = &js->fields[i];
+        if (!(js->value_mask & BIT(i))) {
+            continue;
+        }
+        if (f->type == JSON_STRING) {
+            if (js->str_len + 1 < f->str_size) {
+                f->str[js->str_len] = c;
+            }
+        }
+    }
+    // A numeric string: optional '-', then digits only
+    if (c == '-' && js->str_len == 0) {
+        js->num_sign = -1;
+    } else if (isDigit(c)) {
+        numDigit(js, c);
+        js->lit_pos = 1;
+    } else {
+        js->num_ok = 0;
+    }
+    if (js->str_len < UINT8_MAX) {
+        js->str_len++;
+    }
+}
+
+static void stringEnd(JsonStream *js) {
+    int i;
+    for (i = 0; i < js->nfields; i++) {
+        JsonField *f = &js->fields[i];
+        if (!(js->value_mask & BIT(i))) {
+            continue;
+        }
+        if (f->type == JSON_STRING && f->str_size) {
+            f->str[js->str_len < f->str_size ? js->str_len : f->str_size - 1] = '\0';
+            f->found = 1;
+        }
+    }
+    if (js->num_ok && js->lit_pos) {
+        storeInt(js, js->num * js->num_sign);
+    }
+}
+
+// Point seg[] at this depth's segment of every path still in play
+static void keyStart(JsonStream *js) {
+    int i, d;
+    js->key_len = 0;
+    js->key_mask = js->masks[js->depth - 1];
+    for (i = 0; i < js->nfields; i++) {
+        if (js->key_mask & BIT(i)) {
+            const char *p = js->fields[i].path;
+            for (d = 1; d < js->depth; d++) {
+                p = strchr(p, '.') + 1;
+            }
+            js->seg[i] = (uint8_t)(p - js->fields[i].path);
+        }
+    }
+    js->state = J_KEY;
+}
+
+static void keyChar(JsonStream *js, char c) {
+    int i;
+    for (i = 0; i < js->nfields; i++) {
+        if ((js->key_mask & BIT(i)) &&
+            js->fields[i].path[js->seg[i] + js->key_len] != c) {
+            js->key_mask &= ~BIT(i);
+        }
+    }
+    if (++js->key_len == UINT8_MAX) {
+        js->key_mask = 0;
+    }
+}
+
+static void keyEnd(JsonStream *js) {
+    int i;
+    js->value_mask = 0;
+    js->child_mask = 0;
+    for (i = 0; i < js->nfields; i++) {
+        if (js->key_mask & BIT(i)) {
+            char next = js->fields[i].path[js->seg[i] + js->key_len];
+            if (next == '\0') {
+                js->value_mask |= BIT(i);
+            } else if (next == '.') {
+                js->child_mask |= BIT(i);
+            }
+        }
+    }
+    js->state = J_COLON;
+}
+
+static int push(JsonStream *js, int array) {
+    if (js->depth == JSON_MAX_DEPTH) {
+        return fail(js, JSON_ERR_DEPTH);
+    }
+    js->masks[js->depth] = array ? 0 : js->child_mask;
+    if (array) {
+        js->arrays |= BIT(js->depth);
+    } else {
+        js->arrays &= ~BIT(js->depth);
+    }
+    js->depth++;
+    js->value_mask = 0;
+    js->child_mask = 0;
+    js->state = array ? J_ARRAY_FIRST : J_OBJECT_FIRST;
+    return 0;
+}
+
+static void pop(JsonStream *js) {
+    js->depth--;
+    valueEnd(js);
+}
+
+static int inArray(const JsonStream *js) {
+    return (js->arrays & BIT(js->depth - 1)) != 0;
+}
+
+static int startValue(JsonStream *js, char c) {
+    switch (c) {
+    case '{':
+        return push(js, 0);
+    case '[':
+        return push(js, 1);
+    case '"':
+        numStart(js);
+        js->str_len = 0;
+        js->state = J_STRING;
+        return 0;
+    case 't':
+        js->literal = "true";
+        break;
+    case 'f':
+        js->literal = "false";
+        break;
+    case 'n':
+        js->literal = "null";
+        break;
+    default:
+        if (c == '-' || isDigit(c)) {
+            numStart(js);
+            if (c == '-') {
+                js->num_sign = -1;
+            } else {
+                numDigit(js, c);
+                js->lit_pos = 1;
+            }
+            js->state = J_NUMBER;
+            return 0;
+        }
+        return fail(js, JSON_ERR_SYNTAX);
+    }
+    js->lit_pos = 1;
+    js->state = J_LITERAL;
+    return 0;
+}
+
+static int numberEnd(JsonStream *js) {
+    if (!js->lit_pos) {
+        return fail(js, JSON_ERR_SYNTAX);
+    }
+    if (js->num_ok) {
+        storeInt(js, js->num * js->num_sign);
+    }
+    valueEnd(js);
+    return 0;
+}
+
+int jsonStreamFeed(JsonStream *js, const char *data, int len) {
+    int i = 0;
+
+    while (i < len) {
+        char c = data[i];
+
+        switch (js->state) {
+        case J_VALUE:
+        case J_ARRAY_FIRST:
+            if (isSpace(c)) {
+                break;
+            }
+            if (js->state == J_ARRAY_FIRST && c == ']') {
+                pop(js);
+            } else if (startValue(js, c) < 0) {
+                return JSON_STREAM_ERROR;
+            }
+            break;
+        case J_OBJECT_FIRST:
+        case J_KEY_START:
+            if (isSpace(c)) {
+                break;
+            }
+            if (c == '"') {
+                keyStart(js);
+            } else if (c == '}' && js->state == J_OBJECT_FIRST) {
+                pop(js);
+            } else {
+                return fail(js, JSON_ERR_SYNTAX);
+            }
+            break;
+        case J_KEY:
+            if (!js->key_mask) {
+                // Keys that can't match any more are skipped in one go
+                while (i < len && data[i] != '"' && data[i] != '\\' &&
+                       (unsigned char)data[i] >= 0x20) {
+                    i++;
+                }
+                if (i == len) {
+                    return 0;
+                }
+                c = data[i];
+            }
+            if (c == '"') {
+                keyEnd(js);
+            } else if (c == '\\') {
+                js->key_mask = 0;   // Escaped keys never match a path
+                js->state = J_KEY_ESC;
+            } else if ((unsigned char)c < 0x20) {
+                return fail(js, JSON_ERR_SYNTAX);
+            } else if (js->key_mask) {
+                keyChar(js, c);
+            }
+            break;
+        case J_KEY_ESC:
+            js->state = J_KEY;
+            break;
+        case J_COLON:
+            if (c == ':') {
+                js->state = J_VALUE;
+            } else if (!isSpace(c)) {
+                return fail(js, JSON_ERR_SYNTAX);
+            }
+            break;
+        case J_AFTER_VALUE:
+            if (isSpace(c)) {
+                break;
+            }
+            if (c == ',') {
+                js->state = inArray(js) ? J_VALUE : J_KEY_START;
+            } else if (c == (inArray(js) ? ']' : '}')) {
+                pop(js);
+            } else {
+                return fail(js, JSON_ERR_SYNTAX);
+            }
+            break;
+
+        case J_STRING:
+            if (!js->value_mask) {
+                // Skip strings nobody wants in one go
+                while (i < len && data[i] != '"' && data[i] != '\\' &&
+                       (unsigned char)data[i] >= 0x20) {
+                    i++;
+                }
+                if (i == len) {
+                    return 0;
+                }
+                c = data[i];
+            }
+            if (c == '"') {
+                stringEnd(js);
+                valueEnd(js);
+            } else if (c == '\\') {
+                js->state = J_STRING_ESC;
+            } else if ((unsigned char)c < 0x20) {
+                return fail(js, JSON_ERR_SYNTAX);
+            } else if (js->value_mask) {
+                stringPut(js, c);
+            }
+            break;
+        case J_STRING_ESC: {
+            static const char esc_in[] = "\"\\/bfnrt";
+            static const char esc_out[] = "\"\\/\b\f\n\r\t";
+            const char *e = strchr(esc_in, c);
+            if (c == 'u') {
+                stringPut(js, '?');     // Not needed for any field we read
+                js->lit_pos = 0;
+                js->state = J_STRING_U;
+                js->num_ok = 0;
+            } else if (c != '\0' && e) {
+                stringPut(js, esc_out[e - esc_in]);
+                js->state = J_STRING;
+            } else {
+                return fail(js, JSON_ERR_SYNTAX);
+            }
+            break;
+        }
+        case J_STRING_U:
+            if (!isHex(c)) {
+                return fail(js, JSON_ERR_SYNTAX);
+            }
+            if (++js->lit_pos == 4) {
+                js->state = J_STRING;
+            }
+            break;
+
+        case J_NUMBER:
+            if (isDigit(c)) {
+                if (!js->num_frac) {
+                    numDigit(js, c);
+                    js->lit_pos = 1;
+                }
+            } else if (js->lit_pos && (c == '.' || c == 'e' || c == 'E' ||
+                                       (js->num_frac && (c == '+' || c == '-')))) {
+                js->num_frac = 1;   // Integer part only
+            } else {
+                // The character after the number belongs to what follows
+                if (numberEnd(js) < 0) {
+                    return JSON_STREAM_ERROR;
+                }
+                continue;
+            }
+            break;
+        case J_LITERAL:
+            if (c != js->literal[js->lit_pos]) {
+                return fail(js, JSON_ERR_SYNTAX);
+            }
+            if (js->literal[++js->lit_pos] == '\0') {
+                if (js->literal[0] != 'n') {
+                    storeInt(js, js->literal[0] == 't');
+                }
+                valueEnd(js);
+            }
+            break;
+        case J_END:
+            if (!isSpace(c)) {
+                return fail(js, JSON_ERR_SYNTAX);
+            }
+            break;
+        default:
+            return JSON_STREAM_ERROR;
+        }
+        i++;
+    }
+    return 0;
+}
+
+int jsonStreamFinish(JsonStream *js) {
+    if (js->state == J_NUMBER && js->depth == 0) {
+        numberEnd(js);
+    }
+    if (js->state == J_END) {
+        return 0;
+    }
+    if (js->state != J_ERROR) {
+        fail(js, JSON_ERR_TRUNCATED);
+    }
+    return JSON_STREAM_ERROR;
+}
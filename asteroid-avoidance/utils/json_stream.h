@@ -0,0 +1,79 @@
+//*****************************************************************************
+// json_stream.h - Streaming JSON field extractor
+//
+// Tokenizes a JSON document as it arrives, in chunks split anywhere, and
+// fills in a caller-supplied table of fields named by their object path
+// ("state.reported.highscore", "version"). Keys are matched against the
+// paths character by character as they stream past, so nothing is buffered
+// but the value being captured, and a field only matches at its exact
+// position in the document, never a same-named key in another object.
+// There is no heap use; the state is a fixed-size struct.
+//
+// Like http_parser, this has no hardware dependencies and builds on a host.
+//*****************************************************************************
+
+#ifndef UTILS_JSON_STREAM_H_
+#define UTILS_JSON_STREAM_H_
+
+#include <stdint.h>
+
+#define JSON_MAX_FIELDS     8       // Fields per document
+#define JSON_MAX_DEPTH      10      // Nested objects/arrays
+
+#define JSON_STREAM_ERROR   -1
+
+typedef enum {
+    JSON_INT,               // Number or numeric string ("1234"); integer part only, so 7.5e3 is 7; true/false as 1/0
+    JSON_STRING             // String, truncated to fit str_size with a terminator
+} JsonType;
+
+typedef enum {
+    JSON_ERR_NONE,
+    JSON_ERR_SYNTAX,
+    JSON_ERR_DEPTH,         // Nested deeper than JSON_MAX_DEPTH
+    JSON_ERR_TRUNCATED      // Document ended early
+} JsonError;
+
+typedef struct {
+    const char *path;       // Dot-separated object keys
+    JsonType type;
+    char *str;              // JSON_STRING destination
+    uint8_t str_size;
+    uint8_t found;          // Set when the field was seen with a value of its type
+    long num;               // JSON_INT result
+} JsonField;
+
+typedef struct {
+    JsonField *fields;
+    uint8_t nfields;
+    JsonError error;
+
+    // Private
+    uint8_t state;
+    uint8_t depth;
+    uint16_t arrays;                    // Bit d: container at depth d+1 is an array
+    uint8_t masks[JSON_MAX_DEPTH];      // Fields whose path leads into each open object
+    uint8_t child_mask;                 // Fields continuing into the value after a key
+    uint8_t value_mask;                 // Fields ending at the value after a key
+    uint8_t key_mask;                   // Fields still matching the key being read
+    uint8_t key_len;
+    uint8_t seg[JSON_MAX_FIELDS];       // Offset of the current key's segment in each path
+    uint8_t str_len;
+    uint8_t lit_pos;
+    uint8_t num_ok;
+    uint8_t num_frac;
+    int8_t num_sign;
+    long num;
+    const char *literal;
+} JsonStream;
+
+// fields[] must stay valid while the stream is in use; found is cleared
+void jsonStreamInit(JsonStream *js, JsonField *fields, int nfields);
+
+// Parse len bytes; 0 or JSON_STREAM_ERROR with js->error set
+int jsonStreamFeed(JsonStream *js, const char *data, int len);
+
+// End of input: 0 if a complete document was parsed
+int jsonStreamFinish(JsonStream *js);
+
+#endif /* UTILS_JSON_STREAM_H_ */
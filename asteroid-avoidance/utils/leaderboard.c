@@ -0,0 +1,190 @@
+//*****************************************************************************
+// leaderboard.c - Sorted top-N score table with a compact text encoding
+//*****************************************************************************
+
+#include "leaderboard.h"
+
+#include <string.h>
+
+// Negative if a ranks above b, 0 if identical
+static int compare(const LeaderboardEntry *a, const LeaderboardEntry *b) {
+    if (a->score != b->score) {
+        return a->score > b->score ? -1 : 1;
+    }
+    if (a->time != b->time) {
+        return a->time < b->time ? -1 : 1;
+    }
+    return strcmp(a->initials, b->initials);
+}
+
+// First position whose entry ranks below e (or equals it if *found)
+static int search(const Leaderboard *lb, const LeaderboardEntry *e, int *found) {
+    int lo = 0;
+    int hi = lb->count;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        int c = compare(&lb->entries[mid], e);
+        if (c == 0) {
+            *found = 1;
+            return mid;
+        }
+        if (c < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    *found = 0;
+    return lo;
+}
+
+void leaderboardClear(Leaderboard *lb) {
+    lb->count = 0;
+}
+
+int leaderboardRank(const Leaderboard *lb, const LeaderboardEntry *e) {
+    int found;
+    int pos = search(lb, e, &found);
+    return pos < LEADERBOARD_SIZE ? pos : -1;
+}
+
+int leaderboardFind(const Leaderboard *lb, const LeaderboardEntry *e) {
+    int found;
+    int pos = search(lb, e, &found);
+    return found ? pos : -1;
+}
+
+int leaderboardInsert(Leaderboard *lb, const LeaderboardEntry *e) {
+    int found;
+    int pos = search(lb, e, &found);
+    int move;
+
+    if (found) {
+        return pos;
+    }
+    if (pos >= LEADERBOARD_SIZE) {
+        return -1;
+    }
+    // At most LEADERBOARD_SIZE - 1 entries shift down; a full table loses
+    // its last one
+    move = (lb->count < LEADERBOARD_SIZE ? lb->count : LEADERBOARD_SIZE - 1) - pos;
+    memmove(&lb->entries[pos + 1], &lb->entries[pos], move * sizeof(lb->entries[0]));
+    lb->entries[pos] = *e;
+    if (lb->count < LEADERBOARD_SIZE) {
+        lb->count++;
+    }
+    return pos;
+}
+
+void leaderboardRemove(Leaderboard *lb, int index) {
+    if (index < 0 || index >= lb->count) {
+        return;
+    }
+    lb->count--;
+    memmove(&lb->entries[index], &lb->entries[index + 1], (lb->count - index) * sizeof(lb->entries[0]));
+}
+
+void leaderboardMerge(Leaderboard *dst, const Leaderboard *src) {
+    int i;
+    for (i = 0; i < src->count; i++) {
+        leaderboardInsert(dst, &src->entries[i]);
+    }
+}
+
+static int formatUint(char *out, uint32_t v) {
+    char tmp[10];
+    int n = 0;
+    int i;
+
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    for (i = 0; i < n; i++) {
+        out[i] = tmp[n - 1 - i];
+    }
+    return n;
+}
+
+int leaderboardEncode(const Leaderboard *lb, char *out, int size) {
+    char entry[LEADERBOARD_INITIALS + 23];
+    int len = 0;
+    int i;
+
+    for (i = 0; i < lb->count; i++) {
+        const LeaderboardEntry *e = &lb->entries[i];
+        int n = 0;
+        if (i > 0) {
+            entry[n++] = ';';
+        }
+        memcpy(entry + n, e->initials, strlen(e->initials));
+        n += (int)strlen(e->initials);
+        entry[n++] = ':';
+        n += formatUint(entry + n, e->score);
+        entry[n++] = ':';
+        n += formatUint(entry + n, e->time);
+        if (len + n >= size) {
+            return -1;
+        }
+        memcpy(out + len, entry, n);
+        len += n;
+    }
+    if (size < 1) {
+        return -1;
+    }
+    out[len] = '\0';
+    return len;
+}
+
+// Unsigned decimal up to 2^32 - 1; advances *p
+static int parseUint(const char **p, uint32_t *v) {
+    const char *s = *p;
+    uint32_t n = 0;
+
+    if (*s < '0' || *s > '9') {
+        return -1;
+    }
+    while (*s >= '0' && *s <= '9') {
+        uint32_t d = (uint32_t)(*s - '0');
+        if (n > (0xFFFFFFFFUL - d) / 10) {
+            return -1;
+        }
+        n = n * 10 + d;
+        s++;
+    }
+    *p = s;
+    *v = n;
+    return 0;
+}
+
+int leaderboardDecode(Leaderboard *lb, const char *text) {
+    Leaderboard out;
+    LeaderboardEntry e;
+    const char *p = text;
+
+    out.count = 0;
+    while (*p) {
+        int n = 0;
+        memset(e.initials, 0, sizeof(e.initials));
+        while ((*p >= 'A' && *p <= 'Z') || (*p >= '0' && *p <= '9')) {
+            if (n == LEADERBOARD_INITIALS) {
+                return -1;
+            }
+            e.initials[n++] = *p++;
+        }
+        if (n == 0 || *p++ != ':' || parseUint(&p, &e.score) < 0 ||
+                *p++ != ':' || parseUint(&p, &e.time) < 0) {
+            return -1;
+        }
+        // Written by another device: order and size aren't trusted
+        leaderboardInsert(&out, &e);
+        if (*p == ';') {
+            p++;
+        } else if (*p) {
+            return -1;
+        }
+    }
+    *lb = out;
+    return 0;
+}
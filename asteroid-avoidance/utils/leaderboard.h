@@ -0,0 +1,59 @@
+//*****************************************************************************
+// leaderboard.h - Sorted top-N score table with a compact text encoding
+//
+// Entries are kept best first (higher score, then the earlier time, then
+// initials), so the insert position is found by binary search and ties rank
+// the same on every device. The text form stored in the shadow is
+// "AAA:score:time" per entry, ';'-separated, best first; it needs no JSON
+// escaping and is bounded by LEADERBOARD_TEXT_SIZE. Like json_stream, this
+// has no hardware dependencies and builds on a host.
+//*****************************************************************************
+
+#ifndef UTILS_LEADERBOARD_H_
+#define UTILS_LEADERBOARD_H_
+
+#include <stdint.h>
+
+#define LEADERBOARD_SIZE        8       // Entries kept
+#define LEADERBOARD_INITIALS    3       // A-Z, 0-9
+// Longest encoding: initials, two 10-digit numbers, separators, terminator
+#define LEADERBOARD_TEXT_SIZE   (LEADERBOARD_SIZE * (LEADERBOARD_INITIALS + 23) + 1)
+
+typedef struct {
+    char initials[LEADERBOARD_INITIALS + 1];
+    uint32_t score;
+    uint32_t time;          // Seconds since 1970
+} LeaderboardEntry;
+
+typedef struct {
+    LeaderboardEntry entries[LEADERBOARD_SIZE];
+    int count;
+} Leaderboard;
+
+void leaderboardClear(Leaderboard *lb);
+
+// Position e would take, or -1 if it doesn't make a full table
+int leaderboardRank(const Leaderboard *lb, const LeaderboardEntry *e);
+
+// Insert e, dropping the last entry of a full table. Returns its position,
+// or -1 if it didn't make the table. An identical entry is not added twice.
+int leaderboardInsert(Leaderboard *lb, const LeaderboardEntry *e);
+
+// Index of an entry identical to e, or -1
+int leaderboardFind(const Leaderboard *lb, const LeaderboardEntry *e);
+
+// Remove the entry at index
+void leaderboardRemove(Leaderboard *lb, int index);
+
+// Insert every entry of src into dst
+void leaderboardMerge(Leaderboard *dst, const Leaderboard *src);
+
+// Encode into out (size bytes, terminated). Returns the length, or -1 if
+// it doesn't fit.
+int leaderboardEncode(const Leaderboard *lb, char *out, int size);
+
+// Replace lb with the table in text; entries are re-sorted and capped.
+// Returns 0, or -1 (lb unchanged) if text is malformed.
+int leaderboardDecode(Leaderboard *lb, const char *text);
+
+#endif /* UTILS_LEADERBOARD_H_ */
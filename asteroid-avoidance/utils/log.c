@@ -0,0 +1,72 @@
+//*****************************************************************************
+// log.c - Runtime level mask and binary frame output for the logging macros
+//*****************************************************************************
+
+#include "log.h"
+
+#ifdef LOG_BINARY
+#include <stdarg.h>
+
+#include "uart_log.h"
+
+// Start of the .logstr section, from the linker command file
+extern const char log_str_start[];
+#endif
+
+// Everything up to INFO until the application chooses otherwise
+volatile uint8_t log_level_mask = LOG_MASK(LOG_LEVEL_ERROR) | LOG_MASK(LOG_LEVEL_WARN) |
+                                  LOG_MASK(LOG_LEVEL_INFO);
+
+void logSetLevel(int level) {
+    uint8_t mask = 0;
+    int i;
+    for (i = LOG_LEVEL_ERROR; i <= level && i <= LOG_LEVEL_TRACE; i++) {
+        mask |= LOG_MASK(i);
+    }
+    log_level_mask = mask;
+}
+
+void logSetMask(uint8_t mask) {
+    log_level_mask = mask & ~LOG_MASK(LOG_LEVEL_NONE);
+}
+
+int logGetLevel(void) {
+    uint8_t mask = log_level_mask;
+    int level;
+    for (level = LOG_LEVEL_TRACE; level > LOG_LEVEL_NONE; level--) {
+        if (mask & LOG_MASK(level)) {
+            return level;
+        }
+    }
+    return LOG_LEVEL_NONE;
+}
+
+#ifdef LOG_BINARY
+void logBinWrite(int level, const char *fmt, int nargs, ...) {
+    unsigned char frame[4 + 4 * LOG_BIN_MAX_ARGS];
+    uint32_t id = (uint32_t)(fmt - log_str_start);
+    int len = 4;
+    va_list ap;
+
+    if (nargs > LOG_BIN_MAX_ARGS) {
+        nargs = LOG_BIN_MAX_ARGS;
+    }
+    frame[0] = LOG_BIN_SYNC;
+    frame[1] = (unsigned char)((level << 4) | nargs);
+    frame[2] = (unsigned char)id;
+    frame[3] = (unsigned char)(id >> 8);
+
+    // int, unsigned, long and pointers are all one 32-bit word on the M4
+    va_start(ap, nargs);
+    while (nargs-- > 0) {
+        uint32_t arg = va_arg(ap, uint32_t);
+        frame[len++] = (unsigned char)arg;
+        frame[len++] = (unsigned char)(arg >> 8);
+        frame[len++] = (unsigned char)(arg >> 16);
+        frame[len++] = (unsigned char)(arg >> 24);
+    }
+    va_end(ap);
+
+    uartLogWrite((const char *)frame, len);
+}
+#endif /* LOG_BINARY */
@@ -0,0 +1,135 @@
+//*****************************************************************************
+// log.h - Leveled logging with compile-time and runtime filtering
+//
+// Each translation unit may define LOG_MODULE_LEVEL before including this
+// header; statements above that level expand to nothing, so neither the call
+// nor its arguments reach the binary. LOG_LEVEL_MAX (set from the build,
+// e.g. -DLOG_LEVEL_MAX=LOG_LEVEL_WARN) caps every module at once. Statements
+// that are compiled in are further gated by a runtime level mask, checked
+// before the arguments are evaluated.
+//
+// With LOG_BINARY defined, statements don't format on the device: each
+// format string is placed in the .logstr section (linked as COPY, so it takes
+// no target memory) and its offset there is the message ID. The device queues
+// the ID and raw argument words; tools/logdecode.py rebuilds the text from the
+// .out file. Arguments must be 32-bit integers or pointers, and %s arguments
+// must point to constant data (string literals) so the host can read them
+// from the image.
+//*****************************************************************************
+
+#ifndef UTILS_LOG_H_
+#define UTILS_LOG_H_
+
+#include <stdint.h>
+#include "uart_if.h"
+
+#define LOG_LEVEL_NONE   0
+#define LOG_LEVEL_ERROR  1
+#define LOG_LEVEL_WARN   2
+#define LOG_LEVEL_INFO   3
+#define LOG_LEVEL_DEBUG  4
+#define LOG_LEVEL_TRACE  5
+
+// Default for modules that don't pick a level
+#ifndef LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_DEFAULT LOG_LEVEL_INFO
+#endif
+
+// Build-wide ceiling
+#ifndef LOG_LEVEL_MAX
+#define LOG_LEVEL_MAX LOG_LEVEL_TRACE
+#endif
+
+#ifndef LOG_MODULE_LEVEL
+#define LOG_MODULE_LEVEL LOG_LEVEL_DEFAULT
+#endif
+
+#if LOG_MODULE_LEVEL < LOG_LEVEL_MAX
+#define LOG_COMPILED_LEVEL LOG_MODULE_LEVEL
+#else
+#define LOG_COMPILED_LEVEL LOG_LEVEL_MAX
+#endif
+
+// Bit n set: level n is printed. Written by logSetLevel()/logSetMask().
+extern volatile uint8_t log_level_mask;
+
+#define LOG_MASK(level)  ((uint8_t)(1u << (level)))
+#define LOG_ENABLED(level) ((log_level_mask & LOG_MASK(level)) != 0)
+
+#ifdef LOG_BINARY
+
+// Binary frame: LOG_BIN_SYNC, (level << 4) | nargs, 16-bit ID (LE), then
+// nargs 32-bit words (LE). The sync byte never appears in ASCII text, so
+// frames and plain Report() output can share the console.
+#define LOG_BIN_SYNC      0xA5
+#define LOG_BIN_MAX_ARGS  8
+
+#define LOG_STR_SECTION __attribute__((section(".logstr")))
+
+// Number of arguments after the format (0..LOG_BIN_MAX_ARGS)
+#define LOG_NARG(...) LOG_NARG_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARG_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+
+#define LOG_EMIT(level, ...) LOG_BIN_EMIT(level, __VA_ARGS__)
+#define LOG_BIN_EMIT(level, fmt, ...) do {                              \
+        if (LOG_ENABLED(level)) {                                       \
+            static const char log_fmt_[] LOG_STR_SECTION = fmt;         \
+            logBinWrite((level), log_fmt_, LOG_NARG(__VA_ARGS__), ##__VA_ARGS__); \
+        }                                                               \
+    } while (0)
+
+// Queue one binary frame. fmt must be a .logstr string.
+void logBinWrite(int level, const char *fmt, int nargs, ...);
+
+#else
+
+#define LOG_EMIT(level, ...) do {                       \
+        if (LOG_ENABLED(level)) {                       \
+            Report(__VA_ARGS__);                        \
+        }                                               \
+    } while (0)
+
+#endif /* LOG_BINARY */
+
+#define LOG_DISCARD(...) do { } while (0)
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) LOG_EMIT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) LOG_EMIT(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) LOG_EMIT(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LOG_EMIT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_TRACE
+#define LOG_TRACE(...) LOG_EMIT(LOG_LEVEL_TRACE, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+
+// Print every compiled-in level up to and including level
+void logSetLevel(int level);
+
+// Print exactly the levels whose LOG_MASK() bits are set
+void logSetMask(uint8_t mask);
+
+// Highest level the runtime mask lets through (LOG_LEVEL_NONE if none)
+int logGetLevel(void);
+
+#endif /* UTILS_LOG_H_ */
@@ -0,0 +1,630 @@
+//*****************************************************************************
+// mqtt_client.c - Minimal MQTT 3.1.1 client
+//*****************************************************************************
+
+#include "mqtt_client.h"
+
+#include <string.h>
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_INFO
+#include "log.h"
+
+#define SESSION_BUF_SIZE    256     // CONNECT, then SUBSCRIBE for all topics
+
+// Packet types (upper nibble of the first byte)
+#define MQTT_CONNECT        1
+#define MQTT_CONNACK        2
+#define MQTT_PUBLISH        3
+#define MQTT_PUBACK         4
+#define MQTT_SUBSCRIBE      8
+#define MQTT_SUBACK         9
+#define MQTT_PINGREQ        12
+#define MQTT_PINGRESP       13
+
+#define PUBLISH_DUP         0x08
+
+typedef enum {
+    MQTT_DOWN,              // Waiting for the TLS connection
+    MQTT_CONNECTING,        // CONNECT queued or sent, waiting for CONNACK
+    MQTT_SUBSCRIBING,       // SUBSCRIBE queued or sent, waiting for SUBACK
+    MQTT_READY
+} MqttState;
+
+typedef enum {
+    PUB_NONE,
+    PUB_QUEUED,             // Built, not sent yet (or to be resent)
+    PUB_AWAIT_ACK           // QoS 1 sent, kept for a resend until PUBACK
+} PubState;
+
+typedef enum {
+    TX_NONE,
+    TX_SESSION,
+    TX_PUBACK,
+    TX_PINGREQ,
+    TX_PUBLISH
+} TxKind;
+
+enum {
+    RX_TYPE,
+    RX_LENGTH,
+    RX_BODY,                // Control packet, kept in rx_small
+    RX_SKIP,
+    RX_TOPIC_LEN,
+    RX_TOPIC,
+    RX_PACKET_ID,
+    RX_PAYLOAD
+};
+
+static const MqttTransportOps *transport;
+static const char *mqtt_client_id;
+static const char *const *mqtt_subs;
+static int mqtt_nsubs;
+static const MqttHandlers *mqtt_handlers;
+static uint32_t (*mqtt_now)(void);
+static uint32_t mqtt_timeout;
+
+static MqttState mqtt_state = MQTT_DOWN;
+static uint32_t wait_since;             // CONNACK/SUBACK wait start
+static uint16_t next_id = 1;
+static uint16_t subscribe_id;
+
+// Outgoing: one packet is sent at a time from one of these
+static char session_buf[SESSION_BUF_SIZE];
+static int session_len = 0;             // Non-zero while a session packet is queued
+static char pub_buf[MQTT_PUBLISH_SIZE];
+static int pub_len;
+static uint8_t pub_qos;
+static uint16_t pub_id;
+static PubState pub_state = PUB_NONE;
+static uint32_t pub_sent_at;
+static char ctrl_buf[4];
+static int puback_pending = 0;
+static uint16_t puback_id;
+static int ping_pending = 0;
+static int ping_outstanding = 0;
+static uint32_t ping_sent_at;
+static const char *tx_ptr;
+static int tx_len = 0;
+static int tx_sent = 0;
+static TxKind tx_kind = TX_NONE;
+
+// Incoming
+static char rx_buf[MQTT_RX_SIZE];
+static uint8_t rx_state = RX_TYPE;
+static uint8_t rx_type;
+static uint8_t rx_len_bytes;
+static unsigned long rx_mult;
+static long rx_remaining;
+static uint8_t rx_small[8];
+static uint8_t rx_small_len;
+static char rx_topic[MQTT_TOPIC_SIZE];
+static uint16_t rx_topic_len;
+static uint16_t rx_topic_got;
+static uint16_t rx_id;
+static int rx_sub;
+
+static MqttStats stats;
+
+static void down(void);
+
+void mqttInit(const MqttTransportOps *transport_ops, const char *client_id,
+              const char *const *subs, int nsubs, const MqttHandlers *handlers,
+              uint32_t (*now)(void), uint32_t timeout_ticks) {
+    transport = transport_ops;
+    mqtt_client_id = client_id;
+    mqtt_subs = subs;
+    mqtt_nsubs = nsubs > MQTT_MAX_SUBS ? MQTT_MAX_SUBS : nsubs;
+    mqtt_handlers = handlers;
+    mqtt_now = now;
+    mqtt_timeout = timeout_ticks;
+    down();
+    pub_state = PUB_NONE;
+    memset(&stats, 0, sizeof(stats));
+}
+
+int mqttReady(void) {
+    return mqtt_state == MQTT_READY;
+}
+
+int mqttBusy(void) {
+    return pub_state != PUB_NONE;
+}
+
+void mqttGetStats(MqttStats *out) {
+    *out = stats;
+}
+
+// Remaining Length: 7 bits per byte, low bits first
+static int putLength(char *out, long len) {
+    int n = 0;
+    do {
+        char b = (char)(len % 128);
+        len /= 128;
+        if (len) {
+            b |= 0x80;
+        }
+        out[n++] = b;
+    } while (len);
+    return n;
+}
+
+static int putString(char *out, const char *s, int len) {
+    out[0] = (char)(len >> 8);
+    out[1] = (char)len;
+    memcpy(out + 2, s, len);
+    return len + 2;
+}
+
+static uint16_t newId(void) {
+    if (++next_id == 0) {
+        next_id = 1;
+    }
+    return next_id;
+}
+
+// Connection lost or abandoned: an unacknowledged publish is kept and resent
+static void down(void) {
+    mqtt_state = MQTT_DOWN;
+    session_len = 0;
+    puback_pending = 0;
+    ping_pending = 0;
+    ping_outstanding = 0;
+    tx_len = 0;             // A partly sent publish is still PUB_QUEUED
+    tx_sent = 0;
+    tx_kind = TX_NONE;
+    rx_state = RX_TYPE;
+}
+
+static void fail(const char *what, long err) {
+    LOG_WARN("MQTT: %s (%ld), reconnecting\r\n", what, err);
+    stats.errors++;
+    transport->fail(err);
+    down();
+}
+
+static void buildConnect(void) {
+    int id_len = (int)strlen(mqtt_client_id);
+    int n = 0;
+    session_buf[n++] = MQTT_CONNECT << 4;
+    n += putLength(session_buf + n, 10 + 2 + id_len);
+    n += putString(session_buf + n, "MQTT", 4);
+    session_buf[n++] = 4;                       // Protocol level 3.1.1
+    session_buf[n++] = 0x02;                    // Clean session, no will, no login
+    session_buf[n++] = (char)(MQTT_KEEPALIVE_S >> 8);
+    session_buf[n++] = (char)MQTT_KEEPALIVE_S;
+    n += putString(session_buf + n, mqtt_client_id, id_len);
+    session_len = n;
+}
+
+static int buildSubscribe(void) {
+    long len = 2;
+    int i, n = 0;
+    for (i = 0; i < mqtt_nsubs; i++) {
+        len += 2 + (long)strlen(mqtt_subs[i]) + 1;
+    }
+    if (len + 5 > SESSION_BUF_SIZE) {
+        return -1;
+    }
+    subscribe_id = newId();
+    session_buf[n++] = (char)((MQTT_SUBSCRIBE << 4) | 0x02);
+    n += putLength(session_buf + n, len);
+    session_buf[n++] = (char)(subscribe_id >> 8);
+    session_buf[n++] = (char)subscribe_id;
+    for (i = 0; i < mqtt_nsubs; i++) {
+        n += putString(session_buf + n, mqtt_subs[i], (int)strlen(mqtt_subs[i]));
+        session_buf[n++] = 1;                   // QoS 1
+    }
+    session_len = n;
+    return 0;
+}
+
+int mqttPublish(const char *topic, const char *payload, int len, int qos) {
+    int topic_len = (int)strlen(topic);
+    long remaining = 2 + topic_len + (qos ? 2 : 0) + len;
+    int n = 0;
+
+    if (mqtt_state != MQTT_READY || pub_state != PUB_NONE ||
+        remaining + 5 > MQTT_PUBLISH_SIZE) {
+        return -1;
+    }
+    pub_qos = qos ? 1 : 0;
+    pub_buf[n++] = (char)((MQTT_PUBLISH << 4) | (pub_qos << 1));
+    n += putLength(pub_buf + n, remaining);
+    n += putString(pub_buf + n, topic, topic_len);
+    if (pub_qos) {
+        pub_id = newId();
+        pub_buf[n++] = (char)(pub_id >> 8);
+        pub_buf[n++] = (char)pub_id;
+    }
+    memcpy(pub_buf + n, payload, len);
+    pub_len = n + len;
+    pub_state = PUB_QUEUED;
+    return 0;
+}
+
+// Pick the next packet: session setup, then acks and pings, then the publish
+static int nextPacket(void) {
+    tx_sent = 0;
+    if (session_len) {
+        tx_ptr = session_buf;
+        tx_len = session_len;
+        tx_kind = TX_SESSION;
+    } else if (mqtt_state != MQTT_READY) {
+        return 0;
+    } else if (puback_pending) {
+        ctrl_buf[0] = MQTT_PUBACK << 4;
+        ctrl_buf[1] = 2;
+        ctrl_buf[2] = (char)(puback_id >> 8);
+        ctrl_buf[3] = (char)puback_id;
+        tx_ptr = ctrl_buf;
+        tx_len = 4;
+        tx_kind = TX_PUBACK;
+    } else if (ping_pending) {
+        ctrl_buf[0] = (char)(MQTT_PINGREQ << 4);
+        ctrl_buf[1] = 0;
+        tx_ptr = ctrl_buf;
+        tx_len = 2;
+        tx_kind = TX_PINGREQ;
+    } else if (pub_state == PUB_QUEUED) {
+        tx_ptr = pub_buf;
+        tx_len = pub_len;
+        tx_kind = TX_PUBLISH;
+    } else {
+        tx_len = 0;
+        tx_kind = TX_NONE;
+        return 0;
+    }
+    return 1;
+}
+
+static void packetSent(void) {
+    uint32_t now = mqtt_now();
+    switch (tx_kind) {
+    case TX_SESSION:
+        session_len = 0;
+        wait_since = now;
+        break;
+    case TX_PUBACK:
+        puback_pending = 0;
+        break;
+    case TX_PINGREQ:
+        ping_pending = 0;
+        ping_outstanding = 1;
+        ping_sent_at = now;
+        stats.pings++;
+        break;
+    case TX_PUBLISH:
+        stats.publishes++;
+        pub_sent_at = now;
+        pub_state = pub_qos ? PUB_AWAIT_ACK : PUB_NONE;
+        break;
+    default:
+        break;
+    }
+    if (mqtt_state == MQTT_READY) {
+        transport->release();   // Restarts the keep-alive interval
+    }
+    tx_kind = TX_NONE;
+    tx_len = 0;
+    tx_sent = 0;
+}
+
+// Send whatever is queued until the socket would block
+static int flush(void) {
+    long ret;
+    for (;;) {
+        if (tx_len == 0 && !nextPacket()) {
+            return 0;
+        }
+        ret = transport->send(tx_ptr + tx_sent, tx_len - tx_sent);
+        if (ret == MQTT_TRANSPORT_AGAIN) {
+            return 0;
+        }
+        if (ret < 0) {
+            fail("send failed", ret);
+            return -1;
+        }
+        tx_sent += ret;
+        if (tx_sent < tx_len) {
+            return 0;
+        }
+        packetSent();
+    }
+}
+
+static void controlPacket(void) {
+    uint8_t type = rx_type >> 4;
+    int i;
+
+    switch (type) {
+    case MQTT_CONNACK:
+        if (mqtt_state != MQTT_CONNECTING || rx_small_len < 2 || rx_small[1] != 0) {
+            fail("connection refused", rx_small_len >= 2 ? rx_small[1] : -1);
+            return;
+        }
+        stats.sessions++;
+        transport->release();
+        if (buildSubscribe() < 0) {
+            fail("subscription list too long", mqtt_nsubs);
+            return;
+        }
+        mqtt_state = MQTT_SUBSCRIBING;
+        wait_since = mqtt_now();
+        break;
+    case MQTT_SUBACK:
+        if (mqtt_state != MQTT_SUBSCRIBING || rx_small_len < 2 ||
+            ((rx_small[0] << 8) | rx_small[1]) != subscribe_id) {
+            break;
+        }
+        for (i = 2; i < rx_small_len; i++) {
+            if (rx_small[i] & 0x80) {
+                LOG_WARN("MQTT: subscription %d refused\r\n", i - 2);
+            }
+        }
+        mqtt_state = MQTT_READY;
+        LOG_INFO("MQTT: session up\r\n");
+        if (pub_state == PUB_AWAIT_ACK) {
+            // Lost with the last connection; the same packet ID marks it a duplicate
+            pub_buf[0] |= PUBLISH_DUP;
+            pub_state = PUB_QUEUED;
+            stats.retransmits++;
+        }
+        if (mqtt_handlers->connected) {
+            mqtt_handlers->connected();
+        }
+        break;
+    case MQTT_PUBACK:
+        if (pub_state == PUB_AWAIT_ACK && rx_small_len >= 2 &&
+            ((rx_small[0] << 8) | rx_small[1]) == pub_id) {
+            uint32_t ticks = mqtt_now() - pub_sent_at;
+            pub_state = PUB_NONE;
+            stats.acks++;
+            if (ticks > stats.max_ack_ticks) {
+                stats.max_ack_ticks = ticks;
+            }
+            if (mqtt_handlers->published) {
+                mqtt_handlers->published();
+            }
+        }
+        break;
+    case MQTT_PINGRESP:
+        ping_outstanding = 0;
+        break;
+    default:
+        break;
+    }
+}
+
+static void topicDone(void) {
+    int i;
+    rx_sub = -1;
+    if (rx_topic_len < MQTT_TOPIC_SIZE) {
+        rx_topic[rx_topic_len] = '\0';
+        for (i = 0; i < mqtt_nsubs; i++) {
+            if (strcmp(rx_topic, mqtt_subs[i]) == 0) {
+                rx_sub = i;
+                break;
+            }
+        }
+    }
+    rx_small_len = 0;
+    rx_state = (rx_type & 0x06) ? RX_PACKET_ID : RX_PAYLOAD;
+}
+
+static void payloadStart(void) {
+    if (rx_sub >= 0) {
+        stats.messages++;
+        mqtt_handlers->message_start(rx_sub, rx_remaining);
+    }
+    rx_state = RX_PAYLOAD;
+}
+
+static void payloadEnd(void) {
+    if (rx_sub >= 0) {
+        mqtt_handlers->message_end();
+    }
+    if (rx_type & 0x06) {
+        // QoS 1 (we subscribe with QoS 1, so never 2)
+        puback_pending = 1;
+        puback_id = rx_id;
+    }
+    rx_state = RX_TYPE;
+}
+
+static void lengthDone(void) {
+    uint8_t type = rx_type >> 4;
+    if (type == MQTT_PUBLISH) {
+        rx_small_len = 0;
+        rx_state = RX_TOPIC_LEN;
+    } else if (type == MQTT_CONNACK || type == MQTT_SUBACK ||
+               type == MQTT_PUBACK || type == MQTT_PINGRESP) {
+        rx_small_len = 0;
+        rx_state = RX_BODY;
+        if (rx_remaining == 0) {
+            rx_state = RX_TYPE;
+            controlPacket();
+        }
+    } else {
+        rx_state = rx_remaining ? RX_SKIP : RX_TYPE;
+    }
+}
+
+// Parse received bytes; -1 on a malformed packet. Stops if a packet made
+// the session fail.
+static int rxFeed(const char *data, int len) {
+    int i = 0;
+    while (i < len && mqtt_state != MQTT_DOWN) {
+        uint8_t c = (uint8_t)data[i];
+        int n;
+
+        switch (rx_state) {
+        case RX_TYPE:
+            rx_type = c;
+            rx_remaining = 0;
+            rx_mult = 1;
+            rx_len_bytes = 0;
+            rx_state = RX_LENGTH;
+            i++;
+            break;
+        case RX_LENGTH:
+            rx_remaining += (long)(c & 0x7F) * rx_mult;
+            rx_mult *= 128;
+            i++;
+            if (++rx_len_bytes > 4) {
+                return -1;
+            }
+            if (!(c & 0x80)) {
+                lengthDone();
+                if (rx_state == RX_TOPIC_LEN && rx_remaining < 2) {
+                    return -1;
+                }
+            }
+            break;
+        case RX_BODY:
+            if (rx_small_len < sizeof(rx_small)) {
+                rx_small[rx_small_len++] = c;
+            }
+            i++;
+            if (--rx_remaining == 0) {
+                rx_state = RX_TYPE;
+                controlPacket();
+            }
+            break;
+        case RX_SKIP:
+            n = len - i;
+            if (n > rx_remaining) {
+                n = (int)rx_remaining;
+            }
+            i += n;
+            rx_remaining -= n;
+            if (rx_remaining == 0) {
+                rx_state = RX_TYPE;
+            }
+            break;
+        case RX_TOPIC_LEN:
+            rx_small[rx_small_len++] = c;
+            rx_remaining--;
+            i++;
+            if (rx_small_len == 2) {
+                rx_topic_len = (uint16_t)((rx_small[0] << 8) | rx_small[1]);
+                rx_topic_got = 0;
+                if (rx_topic_len > rx_remaining) {
+                    return -1;
+                }
+                rx_state = RX_TOPIC;
+                if (rx_topic_len == 0) {
+                    topicDone();
+                }
+            }
+            break;
+        case RX_TOPIC:
+            if (rx_topic_got < MQTT_TOPIC_SIZE - 1) {
+                rx_topic[rx_topic_got] = (char)c;
+            }
+            rx_topic_got++;
+            rx_remaining--;
+            i++;
+            if (rx_topic_got == rx_topic_len) {
+                topicDone();
+                if (rx_state == RX_PACKET_ID && rx_remaining < 2) {
+                    return -1;
+                }
+                if (rx_state == RX_PAYLOAD) {
+                    payloadStart();
+                    if (rx_remaining == 0) {
+                        payloadEnd();
+                    }
+                }
+            }
+            break;
+        case RX_PACKET_ID:
+            rx_small[rx_small_len++] = c;
+            rx_remaining--;
+            i++;
+            if (rx_small_len == 2) {
+                rx_id = (uint16_t)((rx_small[0] << 8) | rx_small[1]);
+                payloadStart();
+                if (rx_remaining == 0) {
+                    payloadEnd();
+                }
+            }
+            break;
+        case RX_PAYLOAD:
+            n = len - i;
+            if (n > rx_remaining) {
+                n = (int)rx_remaining;
+            }
+            if (rx_sub >= 0) {
+                mqtt_handlers->message_data(data + i, n);
+            }
+            i += n;
+            rx_remaining -= n;
+            if (rx_remaining == 0) {
+                payloadEnd();
+            }
+            break;
+        default:
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int timedOut(uint32_t since) {
+    return mqtt_now() - since > mqtt_timeout;
+}
+
+void mqttPoll(void) {
+    long ret;
+
+    transport->poll();
+
+    if (mqtt_state == MQTT_DOWN) {
+        if (transport->acquire() < 0) {
+            return;
+        }
+        buildConnect();
+        mqtt_state = MQTT_CONNECTING;
+        wait_since = mqtt_now();
+        rx_state = RX_TYPE;
+    } else if (!transport->up()) {
+        down();
+        return;
+    }
+
+    if ((mqtt_state == MQTT_CONNECTING || mqtt_state == MQTT_SUBSCRIBING) && timedOut(wait_since)) {
+        fail(mqtt_state == MQTT_CONNECTING ? "CONNACK timeout" : "SUBACK timeout", 0);
+        return;
+    }
+    if (pub_state == PUB_AWAIT_ACK && mqtt_state == MQTT_READY && timedOut(pub_sent_at)) {
+        fail("PUBACK timeout", pub_id);
+        return;
+    }
+    if (ping_outstanding && timedOut(ping_sent_at)) {
+        fail("PINGRESP timeout", 0);
+        return;
+    }
+    if (mqtt_state == MQTT_READY && !ping_outstanding && transport->keepAliveDue()) {
+        ping_pending = 1;
+    }
+
+    if (flush() < 0) {
+        return;
+    }
+
+    ret = transport->recv(rx_buf, sizeof(rx_buf));
+    if (ret == MQTT_TRANSPORT_AGAIN) {
+        return;
+    }
+    if (ret == 0) {
+        fail("closed by server", 0);
+        return;
+    }
+    if (ret < 0) {
+        fail("receive failed", ret);
+        return;
+    }
+    if (rxFeed(rx_buf, (int)ret) < 0) {
+        fail("malformed packet", rx_type);
+    }
+}
@@ -0,0 +1,78 @@
+//*****************************************************************************
+// mqtt_client.h - Minimal MQTT 3.1.1 client
+//
+// One clean session on a byte-stream transport: CONNECT, one SUBSCRIBE for a
+// fixed topic list, PINGREQ when the connection has been quiet for the
+// keep-alive interval, and one QoS 1 publish in flight at a time (kept until
+// its PUBACK and resent with DUP after a reconnect). Incoming messages are
+// parsed as they arrive and their payload handed over in pieces, so no
+// message has to fit in memory. All buffers are static and sized below.
+// The connection is reached through an MqttTransportOps table (mqtt_tls on
+// the device), so the client runs unchanged against a stand-in broker.
+//*****************************************************************************
+
+#ifndef UTILS_MQTT_CLIENT_H_
+#define UTILS_MQTT_CLIENT_H_
+
+#include <stdint.h>
+
+#define MQTT_PUBLISH_SIZE   448     // Largest outgoing PUBLISH (topic + payload + 8)
+#define MQTT_RX_SIZE        256     // Bytes read per recv()
+#define MQTT_TOPIC_SIZE     64      // Longest incoming topic matched; longer ones are skipped
+#define MQTT_MAX_SUBS       6
+#define MQTT_KEEPALIVE_S    60      // Declared in CONNECT; pings go out sooner (transport keep-alive)
+
+#define MQTT_TRANSPORT_AGAIN    -11     // send()/recv() would block (SL_EAGAIN's value)
+
+typedef struct {
+    void (*poll)(void);                 // Drive connect/backoff; called every mqttPoll()
+    int (*acquire)(void);               // 0 once connected, else -1 (starting a connect)
+    int (*up)(void);                    // Non-zero while the acquired connection holds
+    void (*release)(void);              // Good traffic: restart the keep-alive interval
+    void (*fail)(long err);             // Drop the connection and back off
+    int (*keepAliveDue)(void);          // Quiet long enough that a PINGREQ is due
+    long (*send)(const char *data, int len);    // Bytes taken, MQTT_TRANSPORT_AGAIN or < 0
+    long (*recv)(char *buf, int len);           // Bytes, 0 if closed, MQTT_TRANSPORT_AGAIN or < 0
+} MqttTransportOps;
+
+typedef struct {
+    void (*connected)(void);                    // Subscribed; publishing possible
+    void (*message_start)(int sub, long len);   // PUBLISH on subs[sub] with len payload bytes
+    void (*message_data)(const char *data, int len);
+    void (*message_end)(void);
+    void (*published)(void);                    // PUBACK for the QoS 1 publish
+} MqttHandlers;
+
+typedef struct {
+    unsigned long sessions;         // CONNACKs accepted
+    unsigned long publishes;        // PUBLISHes sent (retries included)
+    unsigned long retransmits;      // Resent with DUP after a reconnect
+    unsigned long acks;             // PUBACKs received
+    unsigned long messages;         // PUBLISHes received on a subscription
+    unsigned long pings;
+    unsigned long errors;           // Protocol errors and timeouts
+    uint32_t max_ack_ticks;         // Longest publish-to-PUBACK time
+} MqttStats;
+
+// subs[] must stay valid; they are subscribed (QoS 1) on every connect. now()
+// returns free-running ticks; CONNACK, SUBACK, PUBACK and PINGRESP must arrive
+// within timeout_ticks or the connection is dropped. The transport must be
+// initialized already.
+void mqttInit(const MqttTransportOps *transport, const char *client_id,
+              const char *const *subs, int nsubs, const MqttHandlers *handlers, uint32_t (*now)(void), uint32_t timeout_ticks);
+
+// Keep the connection and session up and process incoming packets
+void mqttPoll(void);
+
+// Non-zero when subscribed and able to publish
+int mqttReady(void);
+
+// Non-zero while a QoS 1 publish waits for its PUBACK
+int mqttBusy(void);
+
+// Queue a publish; returns 0, or -1 if not ready, busy or too large
+int mqttPublish(const char *topic, const char *payload, int len, int qos);
+
+void mqttGetStats(MqttStats *out);
+
+#endif /* UTILS_MQTT_CLIENT_H_ */
@@ -0,0 +1,43 @@
+//*****************************************************************************
+// mqtt_tls.c - tls_conn socket as the MQTT client's transport
+//*****************************************************************************
+
+#include "mqtt_tls.h"
+
+#include "simplelink.h"
+#include "tls_conn.h"
+
+static int mqtt_sock = -1;
+
+static void tlsPoll(void) {
+    // Always in use: tls_conn's idle probe would swallow pushed messages
+    tlsConnPoll(1);
+}
+
+static int tlsAcquire(void) {
+    mqtt_sock = tlsConnAcquire();
+    return mqtt_sock < 0 ? -1 : 0;
+}
+
+static int tlsUp(void) {
+    return tlsConnState() == TLS_CONN_UP;
+}
+
+static long tlsSend(const char *data, int len) {
+    return sl_Send(mqtt_sock, data, len, 0);
+}
+
+static long tlsRecv(char *buf, int len) {
+    return sl_Recv(mqtt_sock, buf, len, 0);
+}
+
+const MqttTransportOps mqtt_tls_ops = {
+    tlsPoll,
+    tlsAcquire,
+    tlsUp,
+    tlsConnRelease,
+    tlsConnFail,
+    tlsConnKeepAliveDue,
+    tlsSend,
+    tlsRecv
+};
@@ -0,0 +1,13 @@
+//*****************************************************************************
+// mqtt_tls.h - tls_conn socket as the MQTT client's transport
+//*****************************************************************************
+
+#ifndef UTILS_MQTT_TLS_H_
+#define UTILS_MQTT_TLS_H_
+
+#include "mqtt_client.h"
+
+// tlsConnInit() must have been called before mqttPoll() uses it
+extern const MqttTransportOps mqtt_tls_ops;
+
+#endif /* UTILS_MQTT_TLS_H_ */
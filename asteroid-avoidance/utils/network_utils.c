@@ -467,6 +467,37 @@ static long WlanConnect() {
 
 }
 
+//*****************************************************************************
+//
+//! Stores the access point just joined as a profile and sets the auto +
+//! fast connect policy, so the next boot can rejoin it without a scan or
+//! the default-state reset (see startFastConnect). Only called once
+//! WlanConnect has an IP address, so the stored profile is known to work.
+//!
+//! \param  None
+//!
+//! \return  0 on success else error code
+//
+//*****************************************************************************
+static long SaveFastConnectProfile() {
+    SlSecParams_t secParams = {0};
+    long lRetVal = -1;
+
+    secParams.Key = SECURITY_KEY;
+    secParams.KeyLen = strlen(SECURITY_KEY);
+    secParams.Type = SECURITY_TYPE;
+
+    lRetVal = sl_WlanProfileAdd(SSID_NAME, strlen(SSID_NAME), 0, &secParams, 0, 0, 0);
+    ASSERT_ON_ERROR(lRetVal);
+
+    // Auto connect to stored profiles, fast connect to the last AP
+    lRetVal = sl_WlanPolicySet(SL_POLICY_CONNECTION,
+                                SL_CONNECTION_POLICY(1, 1, 0, 0, 0), NULL, 0);
+    ASSERT_ON_ERROR(lRetVal);
+
+    return SUCCESS;
+}
+
 
 
 
@@ -478,25 +509,17 @@ long printErrConvenience(char * msg, long retVal) {
 
 //*****************************************************************************
 //
-//! This function demonstrates how certificate can be used with SSL.
-//! The procedure includes the following steps:
-//! 1) connect to an open AP
-//! 2) get the server name via a DNS request
-//! 3) define all socket options and point to the CA certificate
-//! 4) connect to the server via TCP
+//! Opens a secure socket configured for TLS 1.2 with the CA certificate and
+//! the client certificate/key, ready for sl_Connect. The socket is closed
+//! again if any option can't be set.
 //!
 //! \param None
 //!
-//! \return  0 on success else error code
-//! \return  LED1 is turned solid in case of success
-//!    LED2 is turned solid in case of failure
+//! \return  socket ID on success else error code
 //!
 //*****************************************************************************
-int tls_connect() {
-    SlSockAddrIn_t    Addr;
-    int    iAddrSize;
+int tls_socket() {
     unsigned char    ucMethod = SL_SO_SEC_METHOD_TLSV1_2;
-    unsigned int uiIP;
 //    unsigned int uiCipher = SL_SEC_MASK_TLS_ECDHE_RSA_WITH_AES_256_CBC_SHA;
     unsigned int uiCipher = SL_SEC_MASK_TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA256;
 // SL_SEC_MASK_SSL_RSA_WITH_RC4_128_SHA
@@ -512,23 +535,12 @@ int tls_connect() {
     long lRetVal = -1;
     int iSockID;
 
-    lRetVal = sl_NetAppDnsGetHostByName(g_Host, strlen((const char *)g_Host),
-                                    (unsigned long*)&uiIP, SL_AF_INET);
-
-    if(lRetVal < 0) {
-        return printErrConvenience("Device couldn't retrieve the host name \n\r", lRetVal);
-    }
-
-    Addr.sin_family = SL_AF_INET;
-    Addr.sin_port = sl_Htons(g_port);
-    Addr.sin_addr.s_addr = sl_Htonl(uiIP);
-    iAddrSize = sizeof(SlSockAddrIn_t);
     //
     // opens a secure socket
     //
     iSockID = sl_Socket(SL_AF_INET,SL_SOCK_STREAM, SL_SEC_SOCKET);
     if( iSockID < 0 ) {
-        return printErrConvenience("Device unable to create secure socket \n\r", lRetVal);
+        return printErrConvenience("Device unable to create secure socket \n\r", iSockID);
     }
 
     //
@@ -537,6 +549,7 @@ int tls_connect() {
     lRetVal = sl_SetSockOpt(iSockID, SL_SOL_SOCKET, SL_SO_SECMETHOD, &ucMethod,\
                                sizeof(ucMethod));
     if(lRetVal < 0) {
+        sl_Close(iSockID);
         return printErrConvenience("Device couldn't set socket options \n\r", lRetVal);
     }
     //
@@ -545,6 +558,7 @@ int tls_connect() {
     lRetVal = sl_SetSockOpt(iSockID, SL_SOL_SOCKET, SL_SO_SECURE_MASK, &uiCipher,\
                            sizeof(uiCipher));
     if(lRetVal < 0) {
+        sl_Close(iSockID);
         return printErrConvenience("Device couldn't set socket options \n\r", lRetVal);
     }
 
@@ -561,6 +575,7 @@ int tls_connect() {
                            strlen(SL_SSL_CA_CERT));
 
     if(lRetVal < 0) {
+        sl_Close(iSockID);
         return printErrConvenience("Device couldn't set socket options \n\r", lRetVal);
     }
 // END: COMMENT THIS OUT IF DISABLING SERVER VERIFICATION
@@ -575,6 +590,7 @@ int tls_connect() {
                            strlen(SL_SSL_CLIENT));
 
     if(lRetVal < 0) {
+        sl_Close(iSockID);
         return printErrConvenience("Device couldn't set socket options \n\r", lRetVal);
     }
 
@@ -586,9 +602,52 @@ int tls_connect() {
                            strlen(SL_SSL_PRIVATE));
 
     if(lRetVal < 0) {
+        sl_Close(iSockID);
         return printErrConvenience("Device couldn't set socket options \n\r", lRetVal);
     }
 
+    return iSockID;
+}
+
+//*****************************************************************************
+//
+//! This function demonstrates how certificate can be used with SSL.
+//! The procedure includes the following steps:
+//! 1) connect to an open AP
+//! 2) get the server name via a DNS request
+//! 3) define all socket options and point to the CA certificate
+//! 4) connect to the server via TCP
+//!
+//! \param None
+//!
+//! \return  0 on success else error code
+//! \return  LED1 is turned solid in case of success
+//!    LED2 is turned solid in case of failure
+//!
+//*****************************************************************************
+int tls_connect() {
+    SlSockAddrIn_t    Addr;
+    int    iAddrSize;
+    unsigned int uiIP;
+    long lRetVal = -1;
+    int iSockID;
+
+    lRetVal = sl_NetAppDnsGetHostByName(g_Host, strlen((const char *)g_Host),
+                                    (unsigned long*)&uiIP, SL_AF_INET);
+
+    if(lRetVal < 0) {
+        return printErrConvenience("Device couldn't retrieve the host name \n\r", lRetVal);
+    }
+
+    Addr.sin_family = SL_AF_INET;
+    Addr.sin_port = sl_Htons(g_port);
+    Addr.sin_addr.s_addr = sl_Htonl(uiIP);
+    iAddrSize = sizeof(SlSockAddrIn_t);
+
+    iSockID = tls_socket();
+    if( iSockID < 0 ) {
+        return iSockID;
+    }
 
     /* connect to the peer device - Google server */
     lRetVal = sl_Connect(iSockID, ( SlSockAddr_t *)&Addr, iAddrSize);
@@ -617,6 +676,81 @@ int tls_connect() {
 
 
 
+//*****************************************************************************
+//
+//! Fast boot: starts the network processor without resetting it to its
+//! default state. If it comes up as a station holding the profile that
+//! connectToAccessPoint stored for SSID_NAME, the auto + fast connect policy
+//! stored with it is in effect and the device rejoins that access point on
+//! its own, without a scan; this waits up to timeoutMs for the IP address.
+//! On any failure the network processor is stopped again for the full
+//! sequence (a changed key, for one, shows up as the timeout).
+//!
+//! \param  timeoutMs - longest wait for the IP address
+//!
+//! \return  0 once the IP address is acquired else error code
+//
+//*****************************************************************************
+int startFastConnect(unsigned long timeoutMs) {
+    _i8 profileName[SSID_LEN_MAX];
+    _i16 nameLen = 0;
+    _u8 macAddr[SL_BSSID_LENGTH];
+    SlSecParams_t secParams;
+    SlGetSecParamsExt_t secExtParams;
+    _u32 priority;
+    unsigned long waitedMs;
+    long lRetVal = -1;
+    GPIO_IF_LedConfigure(LED1|LED3);
+
+    GPIO_IF_LedOff(MCU_RED_LED_GPIO);
+    GPIO_IF_LedOff(MCU_GREEN_LED_GPIO);
+
+    InitializeAppVariables();
+
+    lRetVal = sl_Start(0, 0, 0);
+    if (lRetVal < 0) {
+        return lRetVal;
+    }
+    if (ROLE_STA != lRetVal) {
+        sl_Stop(SL_STOP_TIMEOUT);
+        return DEVICE_NOT_IN_STATION_MODE;
+    }
+
+    // connectToAccessPoint deletes every profile before storing this one
+    lRetVal = sl_WlanProfileGet(0, profileName, &nameLen, macAddr, &secParams,
+                                &secExtParams, &priority);
+    if (lRetVal < 0 || nameLen != (_i16)strlen(SSID_NAME) ||
+            memcmp(profileName, SSID_NAME, nameLen) != 0) {
+        sl_Stop(SL_STOP_TIMEOUT);
+        return lRetVal < 0 ? lRetVal : LAN_CONNECTION_FAILED;
+    }
+
+    UART_PRINT("Rejoining stored profile for %s\n\r", SSID_NAME);
+
+    // Poll the connection events every ~10 ms (3 cycles per count at 80 MHz)
+    for (waitedMs = 0; !IS_IP_ACQUIRED(g_ulStatus); waitedMs += 10) {
+        if (waitedMs >= timeoutMs) {
+            UART_PRINT("No IP address from the stored profile \n\r");
+            sl_Stop(SL_STOP_TIMEOUT);
+            return LAN_CONNECTION_FAILED;
+        }
+        _SlNonOsMainLoopTask();
+        MAP_UtilsDelay(266667);
+    }
+    return 0;
+}
+
+//*****************************************************************************
+//
+//! Full sequence: resets the network processor to its default state, joins
+//! SSID_NAME and waits for an IP address, then stores the profile for
+//! startFastConnect. The network processor must be stopped.
+//!
+//! \param  None
+//!
+//! \return  0 on success else error code
+//
+//*****************************************************************************
 int connectToAccessPoint() {
     long lRetVal = -1;
     GPIO_IF_LedConfigure(LED1|LED3);
@@ -673,5 +807,11 @@ int connectToAccessPoint() {
     }
 
     UART_PRINT("Connection established w/ AP and IP is aquired \n\r");
+
+    // The next boot rejoins without the reset above (startFastConnect)
+    lRetVal = SaveFastConnectProfile();
+    if(lRetVal < 0) {
+        UART_PRINT("Failed to store the connection profile \n\r");
+    }
     return 0;
 }
@@ -78,8 +78,12 @@ void SimpleLinkSockEventHandler(SlSockEvent_t *pSock);
 
 static long ConfigureSimpleLinkToDefaultState();
 
+int tls_socket();
+
 int tls_connect();
 
+int startFastConnect(unsigned long timeoutMs);
+
 int connectToAccessPoint();
 
 static long printErrConvenience(char * msg, long retVal);
@@ -0,0 +1,48 @@
+//*****************************************************************************
+// prng.c - Small seeded xorshift32 generator with explicit per-game state
+//*****************************************************************************
+
+#include "prng.h"
+
+#define PRNG_DEFAULT_SEED 0x9E3779B9u
+
+void prngSeed(Prng *rng, uint32_t seed) {
+    rng->state = seed ? seed : PRNG_DEFAULT_SEED;
+}
+
+// Marsaglia xorshift32 (13, 17, 5): three shifts and xors, period 2^32 - 1
+uint32_t prngNext(Prng *rng) {
+    uint32_t x = rng->state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rng->state = x;
+    return x;
+}
+
+uint32_t prngRange(Prng *rng, uint32_t bound) {
+    if (bound == 0) return 0;
+
+    // The high word of x * bound is the result; the low word tells us whether
+    // x fell in the short, over-represented tail that must be rejected
+    uint64_t m = (uint64_t)prngNext(rng) * bound;
+    uint32_t low = (uint32_t)m;
+    if (low < bound) {
+        uint32_t threshold = (0u - bound) % bound;
+        while (low < threshold) {
+            m = (uint64_t)prngNext(rng) * bound;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+uint32_t prngMix(uint32_t seed, uint32_t value) {
+    uint32_t h = seed ^ value;
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
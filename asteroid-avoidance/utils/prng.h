@@ -0,0 +1,28 @@
+//*****************************************************************************
+// prng.h - Small seeded xorshift32 generator with explicit per-game state
+//*****************************************************************************
+
+#ifndef UTILS_PRNG_H_
+#define UTILS_PRNG_H_
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t state;  // Never zero once seeded
+} Prng;
+
+// Seed the generator. A zero seed is remapped, since xorshift sticks at 0.
+void prngSeed(Prng *rng, uint32_t seed);
+
+// Next raw 32-bit output
+uint32_t prngNext(Prng *rng);
+
+// Uniform value in [0, bound) without modulo bias (Lemire multiply-shift with
+// rejection). Returns 0 when bound is 0.
+uint32_t prngRange(Prng *rng, uint32_t bound);
+
+// Fold a 32-bit value into a seed (murmur3 finalizer), for building a seed out
+// of several weak entropy sources
+uint32_t prngMix(uint32_t seed, uint32_t value);
+
+#endif /* UTILS_PRNG_H_ */
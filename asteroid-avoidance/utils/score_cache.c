@@ -0,0 +1,147 @@
+//*****************************************************************************
+// score_cache.c - Flash-backed high score with write-behind shadow sync
+//*****************************************************************************
+
+#include "score_cache.h"
+
+#include <string.h>
+
+#include "aws_shadow.h"
+#include "flash_store.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_INFO
+#include "log.h"
+
+#define SCORE_CACHE_MAGIC   0x31534353UL    // "SCS1"
+
+// On-flash layout
+typedef struct {
+    uint32_t magic;
+    int32_t best;           // Best score known, local or from the shadow
+    int32_t unsynced;       // Local record the shadow hasn't confirmed, 0 if none
+} ScoreCacheFile;
+
+static const char *cache_file;
+static ScoreCacheFile record;
+static uint32_t (*cache_now)(void);
+static uint32_t retry_min;
+static uint32_t retry_max;
+static uint32_t retry_delay = 0;        // 0: post on the next poll
+static uint32_t last_post;
+static ScoreCacheStats stats;
+
+static void save(void) {
+    long ret = flashStoreWrite(cache_file, &record, sizeof(record), sizeof(record));
+    if (ret < 0) {
+        LOG_WARN("Score cache: write failed (%ld)\r\n", ret);
+        stats.write_errors++;
+    } else {
+        stats.writes++;
+    }
+}
+
+long scoreCacheInit(const char *file, uint32_t (*now)(void),
+                    uint32_t retry_min_ticks, uint32_t retry_max_ticks) {
+    long len;
+
+    cache_file = file;
+    cache_now = now;
+    retry_min = retry_min_ticks;
+    retry_max = retry_max_ticks;
+    retry_delay = 0;
+
+    len = flashStoreRead(file, &record, sizeof(record));
+    if (len != (long)sizeof(record) || record.magic != SCORE_CACHE_MAGIC ||
+            record.best < 0 || record.unsynced < 0 || record.unsynced > record.best) {
+        memset(&record, 0, sizeof(record));
+        record.magic = SCORE_CACHE_MAGIC;
+        return len < 0 ? len : -1;
+    }
+    stats.loads++;
+    LOG_INFO("Score cache: best %ld%s\r\n", (long)record.best,
+             record.unsynced ? ", not yet in the shadow" : "");
+    return 0;
+}
+
+// Hand the unsynced record to aws_shadow and back off the next repost
+static void post(void) {
+    awsShadowPostScore((int)record.unsynced);
+    stats.posts++;
+    last_post = cache_now();
+    retry_delay = retry_delay ? retry_delay * 2 : retry_min;
+    if (retry_delay > retry_max) {
+        retry_delay = retry_max;
+    }
+}
+
+int scoreCacheBest(void) {
+    return (int)record.best;
+}
+
+int scoreCacheRecord(int score) {
+    if (score <= record.best) {
+        return 0;
+    }
+    // Flash first, so the record outlives a reset before the shadow has it
+    record.best = score;
+    record.unsynced = score;
+    save();
+    // Queued now, so a leaderboard entry submitted for the same game goes
+    // out in the same update
+    retry_delay = 0;
+    post();
+    return 1;
+}
+
+void scoreCacheSeen(int high_score) {
+    int changed = 0;
+
+    if (high_score > record.best) {
+        record.best = high_score;
+        changed = 1;
+    }
+    if (record.unsynced && high_score >= record.unsynced) {
+        // Ours, or beaten by another device: nothing left to send
+        LOG_INFO("Score cache: %ld synced\r\n", (long)record.unsynced);
+        record.unsynced = 0;
+        stats.synced++;
+        changed = 1;
+    }
+    if (changed) {
+        save();
+    }
+}
+
+void scoreCachePoll(void) {
+    int shadow_score;
+    uint32_t now;
+
+    if (!record.unsynced) {
+        return;
+    }
+    // A score equal to the cached one doesn't fire the change callback
+    shadow_score = awsShadowHighScore(-1);
+    if (shadow_score >= record.unsynced) {
+        scoreCacheSeen(shadow_score);
+        return;
+    }
+    // aws_shadow keeps a post queued across transport failures itself; it
+    // goes idle without the score stored only when it gave up (conflicts),
+    // and only then is it posted again
+    if (!awsShadowIdle()) {
+        return;
+    }
+    now = cache_now();
+    if (now - last_post < retry_delay) {
+        return;
+    }
+    post();
+}
+
+int scoreCacheUnsynced(void) {
+    return record.unsynced != 0;
+}
+
+void scoreCacheGetStats(ScoreCacheStats *out) {
+    *out = stats;
+}
@@ -0,0 +1,55 @@
+//*****************************************************************************
+// score_cache.h - Flash-backed high score with write-behind shadow sync
+//
+// The best score known to the device, from local play or from the shadow, is
+// kept in a small file on the serial flash and read once at boot, so the
+// start screen never waits on the network and records made offline survive a
+// reset. A new record is written to flash first, marked unsynced and posted
+// through aws_shadow at once; scoreCachePoll() posts it again, backing off,
+// until the shadow holds that score or a higher one.
+//*****************************************************************************
+
+#ifndef UTILS_SCORE_CACHE_H_
+#define UTILS_SCORE_CACHE_H_
+
+#include <stdint.h>
+
+typedef struct {
+    unsigned long loads;            // Records read from flash at boot
+    unsigned long writes;           // Flash writes
+    unsigned long write_errors;
+    unsigned long posts;            // Unsynced score handed to aws_shadow
+    unsigned long synced;           // Records confirmed by the shadow
+} ScoreCacheStats;
+
+// Read the record from file; a missing or invalid file starts empty. now()
+// returns free-running ticks; a post not confirmed by the shadow is repeated
+// after retry_min_ticks, doubling up to retry_max_ticks. The network processor
+// must be running (file system) and awsShadowInit() must have been called.
+// Returns 0, or the negative error from reading the file.
+long scoreCacheInit(const char *file, uint32_t (*now)(void),
+                    uint32_t retry_min_ticks, uint32_t retry_max_ticks);
+
+// Best score known locally, or 0
+int scoreCacheBest(void);
+
+// A game ended with score. If it beats the best known score it is saved to
+// flash and queued for the shadow, so an awsShadowSubmit() that follows goes
+// out in the same update; returns 1 then, else 0.
+int scoreCacheRecord(int score);
+
+// The shadow reported high_score (aws_shadow change callback); saved if it
+// beats the local best, and confirms an unsynced record it matches or beats
+void scoreCacheSeen(int high_score);
+
+// Post an unsynced record again when the shadow client has gone idle
+// without it (or after a reset) and its retry delay has passed; call from
+// the main loop
+void scoreCachePoll(void);
+
+// Non-zero while a record waits to reach the shadow
+int scoreCacheUnsynced(void);
+
+void scoreCacheGetStats(ScoreCacheStats *out);
+
+#endif /* UTILS_SCORE_CACHE_H_ */
@@ -0,0 +1,93 @@
+//*****************************************************************************
+// tilt_filter.c - Fixed-point tilt-to-velocity control pipeline
+//*****************************************************************************
+
+#include "tilt_filter.h"
+
+void tiltFilterInit(TiltFilter *f, const TiltConfig *cfg) {
+    f->cfg = *cfg;
+    f->offset = 0;
+    f->pos = 0;
+    f->rate = 0;
+    f->primed = 0;
+    f->errors = 0;
+    f->samples = 0;
+}
+
+int tiltFilterCalibrate(TiltFilter *f, const int8_t *samples, int count) {
+    int32_t sum = 0;
+    int lo = 127;
+    int hi = -128;
+    int i;
+
+    if (count <= 0) {
+        return -1;
+    }
+    for (i = 0; i < count; i++) {
+        sum += samples[i];
+        if (samples[i] < lo) lo = samples[i];
+        if (samples[i] > hi) hi = samples[i];
+    }
+    if (hi - lo > TILT_CALIB_MAX_SPREAD) {
+        return -1;  // Board was moving
+    }
+    f->offset = (fix8_t)((sum * FIX_ONE) / count);
+    f->primed = 0;
+    return 0;
+}
+
+// Alpha-beta tracker with a one-sample step: predict with the rate, then
+// correct both terms by the residual
+void tiltFilterSample(TiltFilter *f, int raw) {
+    fix8_t z = INT_TO_FIX(raw) - f->offset;
+    fix8_t residual;
+
+    f->errors = 0;
+    f->samples++;
+    if (!f->primed) {
+        f->pos = z;
+        f->rate = 0;
+        f->primed = 1;
+        return;
+    }
+    f->pos += f->rate;
+    residual = z - f->pos;
+    f->pos += FIX_MUL(f->cfg.alpha, residual);
+    f->rate += FIX_MUL(f->cfg.beta, residual);
+}
+
+void tiltFilterError(TiltFilter *f) {
+    if (f->errors < f->cfg.max_errors) {
+        f->errors++;
+    }
+}
+
+// Map |tilt| beyond the deadzone onto 0..max_speed through
+// (1 - expo) * t + expo * t^3, with t normalized to 0..1
+TiltStatus tiltFilterOutput(const TiltFilter *f, uint32_t age_us, fix8_t *velocity) {
+    const TiltConfig *cfg = &f->cfg;
+    fix8_t mag;
+    fix8_t t;
+    fix8_t shaped;
+    fix8_t speed;
+
+    *velocity = 0;
+    if (!f->primed || f->errors >= cfg->max_errors || age_us > cfg->max_age_us) {
+        return TILT_FAULT;
+    }
+    mag = f->pos < 0 ? -f->pos : f->pos;
+    if (mag <= cfg->deadzone) {
+        return TILT_OK;
+    }
+    t = FIX_DIV(mag - cfg->deadzone, cfg->full_tilt - cfg->deadzone);
+    if (t > FIX_ONE) {
+        t = FIX_ONE;
+    }
+    shaped = FIX_MUL(FIX_ONE - cfg->expo, t) + FIX_MUL(cfg->expo, FIX_MUL(t, FIX_MUL(t, t)));
+    speed = FIX_MUL(cfg->max_speed, shaped);
+    if ((f->pos < 0) != (cfg->invert != 0)) {
+        speed = -speed;
+    }
+    *velocity = speed;
+    return TILT_OK;
+}
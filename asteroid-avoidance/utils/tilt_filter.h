@@ -0,0 +1,61 @@
+//*****************************************************************************
+// tilt_filter.h - Fixed-point tilt-to-velocity control pipeline
+//
+// calibration offset -> alpha-beta filter -> response curve -> Q8.8 velocity
+//
+// Sample values and read status travel separately: a level board (raw 0) is a
+// perfectly good sample, and failed reads are reported with tiltFilterError().
+//*****************************************************************************
+
+#ifndef UTILS_TILT_FILTER_H_
+#define UTILS_TILT_FILTER_H_
+
+#include <stdint.h>
+
+#include "fixed_point.h"
+
+#define TILT_CALIB_MAX_SPREAD   6       // Max min-max raw spread while calibrating
+
+typedef enum {
+    TILT_OK,
+    TILT_FAULT      // Too many failed reads or the sample is too old; velocity is 0
+} TiltStatus;
+
+typedef struct {
+    fix8_t alpha;           // Position correction gain, 0..FIX_ONE
+    fix8_t beta;            // Rate correction gain, 0..FIX_ONE
+    fix8_t deadzone;        // Filtered tilt (counts, Q8.8) treated as level
+    fix8_t full_tilt;       // Tilt that gives max_speed
+    fix8_t expo;            // Curve shape: 0 = linear, FIX_ONE = cubic
+    fix8_t max_speed;       // Output limit, Q8.8 px/frame
+    int invert;             // Negate the output (sensor axis vs screen axis)
+    int max_errors;         // Consecutive failed reads before TILT_FAULT
+    uint32_t max_age_us;    // Samples older than this give TILT_FAULT
+} TiltConfig;
+
+typedef struct {
+    TiltConfig cfg;
+    fix8_t offset;          // Level reading from calibration
+    fix8_t pos;             // Filtered tilt estimate (counts, Q8.8)
+    fix8_t rate;            // Estimated change per sample
+    int primed;             // A sample has initialized pos
+    int errors;             // Consecutive failed reads
+    unsigned long samples;
+} TiltFilter;
+
+void tiltFilterInit(TiltFilter *f, const TiltConfig *cfg);
+
+// Set the level offset from raw samples taken while the board is held still.
+// Returns 0, or -1 (offset unchanged) if they spread too much to trust.
+int tiltFilterCalibrate(TiltFilter *f, const int8_t *samples, int count);
+
+// Feed one fresh raw sample
+void tiltFilterSample(TiltFilter *f, int raw);
+
+// Record a failed read (the filter holds its estimate)
+void tiltFilterError(TiltFilter *f);
+
+// Velocity for the latest estimate, given the age of the newest sample
+TiltStatus tiltFilterOutput(const TiltFilter *f, uint32_t age_us, fix8_t *velocity);
+
+#endif /* UTILS_TILT_FILTER_H_ */
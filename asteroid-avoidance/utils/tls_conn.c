@@ -0,0 +1,255 @@
+//*****************************************************************************
+// tls_conn.c - Persistent TLS connection manager
+//*****************************************************************************
+
+#include "tls_conn.h"
+
+#include <string.h>
+
+#include "simplelink.h"
+#include "network_utils.h"
+#include "dns_cache.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_INFO
+#include "log.h"
+
+#define PROBE_INTERVAL_DIVISOR  8       // Closure probes per keep-alive interval
+
+enum { IP_SOURCE_NONE, IP_SOURCE_CACHE, IP_SOURCE_DNS };
+
+static TlsConnConfig conn_cfg;
+static uint32_t (*conn_now)(void);
+
+static TlsConnState conn_state = TLS_CONN_DOWN;
+static int conn_sock = -1;
+static unsigned long conn_ip = 0;       // Resolved address, 0 = resolve again
+static int conn_ip_source;              // Where conn_ip came from
+static SlSockAddrIn_t conn_addr;
+static uint32_t conn_backoff;           // Delay after the next failure (reset by a good response)
+static uint32_t conn_retry_at;          // BACKOFF ends
+static uint32_t conn_requested;         // Connect requested (setup latency start)
+static uint32_t conn_handshake_start;
+static uint32_t conn_last_activity;
+static uint32_t conn_last_probe;
+static TlsConnStats stats;
+
+void tlsConnInit(const TlsConnConfig *cfg, uint32_t (*now)(void)) {
+    conn_cfg = *cfg;
+    conn_now = now;
+    conn_state = TLS_CONN_DOWN;
+    conn_sock = -1;
+    conn_ip = 0;
+    conn_ip_source = IP_SOURCE_NONE;
+    conn_backoff = cfg->backoff_min_ticks;
+    memset(&stats, 0, sizeof(stats));
+}
+
+TlsConnState tlsConnState(void) {
+    return conn_state;
+}
+
+void tlsConnGetStats(TlsConnStats *out) {
+    *out = stats;
+}
+
+static void closeSocket(void) {
+    if (conn_sock >= 0) {
+        sl_Close(conn_sock);
+        conn_sock = -1;
+    }
+}
+
+// Close and wait before reconnecting, doubling the wait each time in a row
+static void backOff(void) {
+    closeSocket();
+    conn_retry_at = conn_now() + conn_backoff;
+    conn_state = TLS_CONN_BACKOFF;
+    if (conn_backoff < conn_cfg.backoff_max_ticks / 2) {
+        conn_backoff *= 2;
+    } else {
+        conn_backoff = conn_cfg.backoff_max_ticks;
+    }
+}
+
+static void connectFailed(const char *what, long err) {
+    LOG_WARN("TLS: %s failed (%ld), backing off\r\n", what, err);
+    stats.failures++;
+    if (conn_state == TLS_CONN_CONNECTING && conn_ip_source == IP_SOURCE_CACHE) {
+        // The cached address was tried and didn't take
+        dnsCacheInvalidate();
+    }
+    conn_ip = 0;        // The address may have moved
+    conn_ip_source = IP_SOURCE_NONE;
+    backOff();
+}
+
+static void connected(void) {
+    uint32_t now = conn_now();
+    uint32_t setup = now - conn_requested;
+
+    conn_state = TLS_CONN_UP;
+    conn_last_activity = now;
+    conn_last_probe = now;
+    if (stats.connects > 0) {
+        stats.reconnects++;
+    }
+    stats.connects++;
+    stats.last_setup_ticks = setup;
+    stats.total_setup_ticks += setup;
+    if (setup > stats.max_setup_ticks) {
+        stats.max_setup_ticks = setup;
+    }
+    if (conn_ip_source == IP_SOURCE_DNS) {
+        // Proven good: the next boot can skip the lookup
+        dnsCacheStore(conn_ip);
+        conn_ip_source = IP_SOURCE_CACHE;
+    }
+    LOG_INFO("TLS: connected (socket %d)\r\n", conn_sock);
+}
+
+// Lost an idle connection; reconnect lazily
+static void dropped(const char *why) {
+    LOG_INFO("TLS: connection %s\r\n", why);
+    closeSocket();
+    stats.drops++;
+    conn_state = TLS_CONN_DOWN;
+}
+
+int tlsConnAcquire(void) {
+    if (conn_state == TLS_CONN_UP) {
+        return conn_sock;
+    }
+    if (conn_state == TLS_CONN_DOWN) {
+        conn_requested = conn_now();
+        conn_state = TLS_CONN_DNS;
+    }
+    return -1;
+}
+
+void tlsConnRelease(void) {
+    conn_backoff = conn_cfg.backoff_min_ticks;
+    conn_last_activity = conn_now();
+    conn_last_probe = conn_last_activity;
+}
+
+void tlsConnClose(void) {
+    if (conn_state == TLS_CONN_UP) {
+        closeSocket();
+        conn_state = TLS_CONN_DOWN;
+    }
+}
+
+void tlsConnFail(long err) {
+    // Back off here too: a server that accepts connections but never
+    // answers would otherwise be reconnected to in a tight loop
+    if (conn_state == TLS_CONN_UP) {
+        LOG_WARN("TLS: socket error %ld, backing off\r\n", err);
+        stats.drops++;
+        backOff();
+    }
+}
+
+int tlsConnKeepAliveDue(void) {
+    return conn_state == TLS_CONN_UP && conn_cfg.keepalive_ticks != 0 &&
+           conn_now() - conn_last_activity >= conn_cfg.keepalive_ticks;
+}
+
+// Resolve (if needed), open the secure socket and start the handshake
+static void startConnect(void) {
+    SlSockNonblocking_t nb;
+    long ret;
+
+    if (g_Host == NULL || !IS_IP_ACQUIRED(g_ulStatus)) {
+        connectFailed("network", -1);  // Not on the access point (yet)
+        return;
+    }
+    if (conn_ip == 0) {
+        conn_ip = dnsCacheLookup();
+        conn_ip_source = IP_SOURCE_CACHE;
+    }
+    if (conn_ip == 0) {
+        // Blocking, but only without a usable cached address
+        ret = sl_NetAppDnsGetHostByName(g_Host, strlen((const char *)g_Host), &conn_ip, SL_AF_INET);
+        if (ret < 0) {
+            conn_ip = 0;
+            conn_ip_source = IP_SOURCE_NONE;
+            connectFailed("DNS lookup", ret);
+            return;
+        }
+        conn_ip_source = IP_SOURCE_DNS;
+    }
+
+    conn_sock = tls_socket();
+    if (conn_sock < 0) {
+        connectFailed("socket setup", conn_sock);
+        return;
+    }
+    nb.NonblockingEnabled = 1;
+    ret = sl_SetSockOpt(conn_sock, SL_SOL_SOCKET, SL_SO_NONBLOCKING, &nb, sizeof(nb));
+    if (ret < 0) {
+        connectFailed("non-blocking mode", ret);
+        return;
+    }
+
+    conn_addr.sin_family = SL_AF_INET;
+    conn_addr.sin_port = sl_Htons(g_port);
+    conn_addr.sin_addr.s_addr = sl_Htonl(conn_ip);
+    conn_handshake_start = conn_now();
+    conn_state = TLS_CONN_CONNECTING;
+}
+
+// One step of the non-blocking connect
+static void pollConnect(void) {
+    long ret = sl_Connect(conn_sock, (SlSockAddr_t *)&conn_addr, sizeof(conn_addr));
+    if (ret >= 0 || ret == SL_ESECSNOVERIFY) {
+        connected();
+    } else if (ret != SL_EALREADY) {
+        connectFailed("connect", ret);
+    } else if (conn_now() - conn_handshake_start > conn_cfg.connect_timeout_ticks) {
+        connectFailed("connect timeout", ret);
+    }
+}
+
+// Idle connection: a zero-length read means the server closed it
+static void probe(void) {
+    char discard[16];
+    long ret;
+    uint32_t now = conn_now();
+    uint32_t interval = conn_cfg.keepalive_ticks / PROBE_INTERVAL_DIVISOR;
+
+    if (interval == 0 || now - conn_last_probe < interval) {
+        return;
+    }
+    conn_last_probe = now;
+    ret = sl_Recv(conn_sock, discard, sizeof(discard), 0);
+    if (ret == 0) {
+        dropped("closed by server");
+    } else if (ret < 0 && ret != SL_EAGAIN) {
+        LOG_WARN("TLS: idle socket error %ld\r\n", ret);
+        dropped("failed");
+    }
+    // Unsolicited bytes between responses carry nothing we need
+}
+
+void tlsConnPoll(int in_use) {
+    switch (conn_state) {
+    case TLS_CONN_DNS:
+        startConnect();
+        break;
+    case TLS_CONN_CONNECTING:
+        pollConnect();
+        break;
+    case TLS_CONN_BACKOFF:
+        if ((int32_t)(conn_now() - conn_retry_at) >= 0) {
+            conn_state = TLS_CONN_DOWN;
+        }
+        break;
+    case TLS_CONN_UP:
+        if (!in_use) {
+            probe();
+        }
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,71 @@
+//*****************************************************************************
+// tls_conn.h - Persistent TLS connection manager
+//
+// Owns the one TLS socket to the cloud endpoint. The connection is opened
+// lazily when a client asks for it, with a non-blocking connect driven by
+// tlsConnPoll(); after a failure the next attempt waits out an exponential
+// backoff. While nobody is using the socket it is probed for a server-side
+// close, and tlsConnKeepAliveDue() tells the client when to send something
+// so an idle connection isn't dropped. The endpoint address comes from
+// dns_cache when it has one, so a boot usually connects without a lookup.
+//*****************************************************************************
+
+#ifndef UTILS_TLS_CONN_H_
+#define UTILS_TLS_CONN_H_
+
+#include <stdint.h>
+
+typedef enum {
+    TLS_CONN_DOWN,          // No socket; connects on the next tlsConnAcquire()
+    TLS_CONN_DNS,           // Connect requested, resolving on the next poll
+    TLS_CONN_CONNECTING,    // Handshake in progress
+    TLS_CONN_UP,
+    TLS_CONN_BACKOFF        // Waiting before the next attempt
+} TlsConnState;
+
+typedef struct {
+    uint32_t backoff_min_ticks;     // First retry delay, doubled per failure
+    uint32_t backoff_max_ticks;
+    uint32_t connect_timeout_ticks; // Abort a handshake taking longer
+    uint32_t keepalive_ticks;       // Idle time before a keep-alive is due (0: never)
+} TlsConnConfig;
+
+typedef struct {
+    unsigned long connects;         // Successful connects
+    unsigned long reconnects;       // Successful connects after a drop
+    unsigned long failures;         // Failed connect attempts
+    unsigned long drops;            // Established connections lost
+    uint32_t last_setup_ticks;      // Request-to-connected time of the last connect
+    uint32_t max_setup_ticks;
+    uint32_t total_setup_ticks;
+} TlsConnStats;
+
+// Host and port come from g_Host/g_port (network_utils)
+void tlsConnInit(const TlsConnConfig *cfg, uint32_t (*now)(void));
+
+// Socket if the connection is up, else -1 (and a connect is started if none
+// is in progress or backing off)
+int tlsConnAcquire(void);
+
+// The caller got a good response: keep the connection open and reset the
+// backoff
+void tlsConnRelease(void);
+
+// The server asked to close (Connection: close): close without backoff
+void tlsConnClose(void);
+
+// A send/receive failed or timed out on the socket: close it and back off
+void tlsConnFail(long err);
+
+// Drive DNS/connect/backoff. When in_use is zero and the connection is up,
+// check it hasn't been closed by the server.
+void tlsConnPoll(int in_use);
+
+TlsConnState tlsConnState(void);
+
+// Non-zero when the connection is up and has been idle for keepalive_ticks
+int tlsConnKeepAliveDue(void);
+
+void tlsConnGetStats(TlsConnStats *out);
+
+#endif /* UTILS_TLS_CONN_H_ */
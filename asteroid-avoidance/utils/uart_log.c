@@ -0,0 +1,140 @@
+//*****************************************************************************
+// uart_log.c - Interrupt-drained UART log ring
+//*****************************************************************************
+
+#include "uart_log.h"
+
+#include <stdio.h>
+
+#include "hw_types.h"
+#include "hw_ints.h"
+#include "interrupt.h"
+#include "uart.h"
+#include "rom.h"
+#include "rom_map.h"
+
+#define RING_MASK (UART_LOG_RING_SIZE - 1)
+
+static char log_ring[UART_LOG_RING_SIZE];
+static volatile uint32_t log_head = 0;      // Next byte to write (writers, interrupts masked)
+static volatile uint32_t log_tail = 0;      // Next byte to send (TX interrupt only)
+static unsigned long log_uart = 0;          // 0 = not started, write synchronously
+static unsigned long dropped_unreported = 0;
+static UartLogStats stats;
+
+// Move bytes from the ring into the TX FIFO until one of them is full/empty.
+// Called with interrupts masked or from the TX interrupt.
+static void fillFifo(void) {
+    uint32_t tail = log_tail;
+    while (tail != log_head && MAP_UARTSpaceAvail(log_uart)) {
+        MAP_UARTCharPutNonBlocking(log_uart, log_ring[tail & RING_MASK]);
+        tail++;
+    }
+    log_tail = tail;
+}
+
+static void UartLogIntHandler(void) {
+    unsigned long status = MAP_UARTIntStatus(log_uart, true);
+    MAP_UARTIntClear(log_uart, status);
+
+    fillFifo();
+    if (log_tail == log_head) {
+        // Nothing left: stop until a write leaves bytes behind again
+        MAP_UARTIntDisable(log_uart, UART_INT_TX);
+    }
+}
+
+void uartLogInit(unsigned long uart_base) {
+    log_uart = uart_base;
+    log_head = 0;
+    log_tail = 0;
+    MAP_UARTFIFOLevelSet(log_uart, UART_FIFO_TX4_8, UART_FIFO_RX4_8);
+    MAP_UARTIntRegister(log_uart, UartLogIntHandler);
+    MAP_UARTIntDisable(log_uart, UART_INT_TX);
+}
+
+// Copy into the ring (interrupts masked)
+static void ringPut(const char *data, int len) {
+    uint32_t head = log_head;
+    int i;
+    for (i = 0; i < len; i++) {
+        log_ring[(head + i) & RING_MASK] = data[i];
+    }
+    log_head = head + len;
+}
+
+int uartLogWrite(const char *data, int len) {
+    char marker[40];
+    int marker_len = 0;
+    uint32_t used;
+    tBoolean was_disabled;
+
+    if (len <= 0) {
+        return 0;
+    }
+    if (log_uart == 0) {
+        // Not started yet (early boot): plain blocking output
+        int i;
+        for (i = 0; i < len; i++) {
+            MAP_UARTCharPut(UARTA0_BASE, data[i]);
+        }
+        return len;
+    }
+
+    // Writers may be main loop or ISR code, so the copy is done with
+    // interrupts masked; it's bounded by the message length
+    was_disabled = MAP_IntMasterDisable();
+    if (dropped_unreported) {
+        marker_len = snprintf(marker, sizeof(marker), "\r\n[%lu log messages dropped]\r\n", dropped_unreported);
+    }
+    used = log_head - log_tail;
+    if (used + marker_len + len > UART_LOG_RING_SIZE) {
+        stats.dropped++;
+        stats.dropped_bytes += len;
+        dropped_unreported++;
+        len = 0;
+    } else {
+        if (marker_len > 0) {
+            ringPut(marker, marker_len);
+            dropped_unreported = 0;
+        }
+        ringPut(data, len);
+        stats.messages++;
+        used += marker_len + len;
+        if (used > stats.high_water) {
+            stats.high_water = used;
+        }
+        // The TX interrupt only fires as a full-enough FIFO drains past its
+        // trigger level, so top the FIFO up here; whatever doesn't fit means
+        // the FIFO is full and the interrupt will come for the rest
+        fillFifo();
+        if (log_tail != log_head) {
+            MAP_UARTIntEnable(log_uart, UART_INT_TX);
+        }
+    }
+    if (!was_disabled) {
+        MAP_IntMasterEnable();
+    }
+    return len;
+}
+
+void uartLogFlush(void) {
+    while (log_uart != 0 && log_tail != log_head) {
+        // Works with interrupts masked too
+        tBoolean was_disabled = MAP_IntMasterDisable();
+        fillFifo();
+        if (!was_disabled) {
+            MAP_IntMasterEnable();
+        }
+    }
+    while (log_uart != 0 && MAP_UARTBusy(log_uart)) {
+    }
+}
+
+void uartLogGetStats(UartLogStats *out) {
+    tBoolean was_disabled = MAP_IntMasterDisable();
+    *out = stats;
+    if (!was_disabled) {
+        MAP_IntMasterEnable();
+    }
+}
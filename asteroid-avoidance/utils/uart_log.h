@@ -0,0 +1,40 @@
+//*****************************************************************************
+// uart_log.h - Interrupt-drained UART log ring
+//
+// Writers copy whole messages into a RAM ring and return; the UART TX
+// interrupt refills the hardware FIFO from the ring. When a message doesn't
+// fit it is dropped whole and counted, and a "[N log messages dropped]"
+// marker is queued once there is room again, so the console never shows
+// half-lines and the writer never blocks.
+//*****************************************************************************
+
+#ifndef UTILS_UART_LOG_H_
+#define UTILS_UART_LOG_H_
+
+#include <stdint.h>
+
+// Must be a power of two. ~180 ms of output at 115200 baud.
+#define UART_LOG_RING_SIZE 2048
+
+typedef struct {
+    unsigned long messages;         // Messages queued
+    unsigned long dropped;          // Messages dropped because the ring was full
+    unsigned long dropped_bytes;
+    uint32_t high_water;            // Most bytes ever queued at once
+} UartLogStats;
+
+// Start interrupt-driven output on a UART that InitTerm() already configured.
+// Until this is called uartLogWrite() falls back to blocking output.
+void uartLogInit(unsigned long uart_base);
+
+// Queue len bytes as one message. Safe from any context. Returns len, or 0
+// if the message was dropped.
+int uartLogWrite(const char *data, int len);
+
+// Busy-wait until everything queued has been handed to the UART (fatal
+// error paths, or before reconfiguring the UART)
+void uartLogFlush(void);
+
+void uartLogGetStats(UartLogStats *out);
+
+#endif /* UTILS_UART_LOG_H_ */
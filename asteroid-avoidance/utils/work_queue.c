@@ -0,0 +1,59 @@
+//*****************************************************************************
+// work_queue.c - Deferred-work (bottom half) queue for interrupt handlers
+//*****************************************************************************
+
+#include "work_queue.h"
+
+#include "hw_types.h"
+#include "interrupt.h"
+#include "rom.h"
+#include "rom_map.h"
+
+void workQueueInit(WorkQueue *q) {
+    q->head = 0;
+    q->tail = 0;
+    q->dropped = 0;
+    q->high_water = 0;
+}
+
+int workQueuePost(WorkQueue *q, WorkFn fn, uint32_t arg) {
+    // Several producers share head, so claim the slot with interrupts off.
+    // IntMasterDisable reports whether they were already off (nested use).
+    tBoolean was_disabled = MAP_IntMasterDisable();
+    uint32_t head = q->head;
+    uint32_t used = head - q->tail;
+    int ok = 0;
+
+    if (used < WORK_QUEUE_SIZE) {
+        q->items[head & (WORK_QUEUE_SIZE - 1)].fn = fn;
+        q->items[head & (WORK_QUEUE_SIZE - 1)].arg = arg;
+        q->head = head + 1;
+        if (used + 1 > q->high_water) {
+            q->high_water = used + 1;
+        }
+        ok = 1;
+    } else {
+        q->dropped++;
+    }
+    if (!was_disabled) {
+        MAP_IntMasterEnable();
+    }
+    return ok;
+}
+
+int workQueueRun(WorkQueue *q, uint32_t (*now)(void), uint32_t budget_ticks) {
+    uint32_t start = now();
+    int ran = 0;
+
+    // Single consumer: the item is copied out before tail frees its slot
+    while (q->tail != q->head) {
+        WorkItem item = q->items[q->tail & (WORK_QUEUE_SIZE - 1)];
+        q->tail++;
+        item.fn(item.arg);
+        ran++;
+        if (now() - start >= budget_ticks) {
+            break;
+        }
+    }
+    return ran;
+}
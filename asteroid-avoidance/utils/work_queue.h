@@ -0,0 +1,42 @@
+//*****************************************************************************
+// work_queue.h - Deferred-work (bottom half) queue for interrupt handlers
+//
+// ISRs post a function pointer plus one word of argument; the main loop runs
+// posted items later, outside interrupt context, within a time budget. Posting
+// is safe from any number of ISRs and the main loop (short critical section).
+//*****************************************************************************
+
+#ifndef UTILS_WORK_QUEUE_H_
+#define UTILS_WORK_QUEUE_H_
+
+#include <stdint.h>
+
+// Must be a power of two
+#define WORK_QUEUE_SIZE 16
+
+typedef void (*WorkFn)(uint32_t arg);
+
+typedef struct {
+    WorkFn fn;
+    uint32_t arg;
+} WorkItem;
+
+typedef struct {
+    volatile uint32_t head;         // Next slot to write (producers, under lock)
+    volatile uint32_t tail;         // Next slot to run (main loop only)
+    volatile uint32_t dropped;      // Posts refused because the queue was full
+    volatile uint32_t high_water;   // Most items ever queued at once
+    WorkItem items[WORK_QUEUE_SIZE];
+} WorkQueue;
+
+void workQueueInit(WorkQueue *q);
+
+// Queue fn(arg). Returns 0 and counts a drop when full.
+int workQueuePost(WorkQueue *q, WorkFn fn, uint32_t arg);
+
+// Run queued items in order until the queue is empty or budget_ticks of
+// now() time have passed. At least one item runs per call so the queue always
+// makes progress. Returns the number of items run.
+int workQueueRun(WorkQueue *q, uint32_t (*now)(void), uint32_t budget_ticks);
+
+#endif /* UTILS_WORK_QUEUE_H_ */